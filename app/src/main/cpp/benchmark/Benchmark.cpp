@@ -0,0 +1,329 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <unistd.h>
+#include "../utils/cjson/cJSON.h"
+
+std::vector<Benchmark::Entry> Benchmark::entries;
+
+namespace {
+
+int64_t realTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// 整个进程的cpu时间，包括线程池里的线程
+int64_t cpuTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+BenchmarkStats summarize(std::vector<double> samples) {
+    BenchmarkStats stats = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    if (samples.empty()) {
+        return stats;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    double sum = 0.0;
+    for (double sample: samples) {
+        sum += sample;
+    }
+    stats.mean = sum / n;
+    stats.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+    stats.min = samples.front();
+    stats.max = samples.back();
+    if (n > 1) {
+        double squares = 0.0;
+        for (double sample: samples) {
+            squares += (sample - stats.mean) * (sample - stats.mean);
+        }
+        stats.stddev = std::sqrt(squares / (n - 1)); // 样本标准差
+    }
+    stats.cv = stats.mean > 0.0 ? stats.stddev / stats.mean : 0.0;
+    return stats;
+}
+
+// 按大小选单位，控制台里方便看
+std::string formatNs(double ns) {
+    char buf[32];
+    if (ns < 1e3) {
+        snprintf(buf, sizeof(buf), "%.1f ns", ns);
+    } else if (ns < 1e6) {
+        snprintf(buf, sizeof(buf), "%.2f us", ns / 1e3);
+    } else if (ns < 1e9) {
+        snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+    } else {
+        snprintf(buf, sizeof(buf), "%.3f s", ns / 1e9);
+    }
+    return buf;
+}
+
+std::string formatRate(double perSecond, const char *unit) {
+    char buf[32];
+    if (perSecond >= 1e9) {
+        snprintf(buf, sizeof(buf), "%.2fG%s/s", perSecond / 1e9, unit);
+    } else if (perSecond >= 1e6) {
+        snprintf(buf, sizeof(buf), "%.2fM%s/s", perSecond / 1e6, unit);
+    } else if (perSecond >= 1e3) {
+        snprintf(buf, sizeof(buf), "%.2fk%s/s", perSecond / 1e3, unit);
+    } else {
+        snprintf(buf, sizeof(buf), "%.2f%s/s", perSecond, unit);
+    }
+    return buf;
+}
+
+// JSON里保留3位小数就够了
+double rounded(double value) {
+    return std::round(value * 1000.0) / 1000.0;
+}
+
+cJSON *statsToJson(const BenchmarkStats &stats) {
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "mean", rounded(stats.mean));
+    cJSON_AddNumberToObject(json, "median", rounded(stats.median));
+    cJSON_AddNumberToObject(json, "stddev", rounded(stats.stddev));
+    cJSON_AddNumberToObject(json, "min", rounded(stats.min));
+    cJSON_AddNumberToObject(json, "max", rounded(stats.max));
+    cJSON_AddNumberToObject(json, "cv", rounded(stats.cv));
+    return json;
+}
+
+double numberValue(const cJSON *object, const char *key) {
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(object, key);
+    return cJSON_IsNumber(item) ? item->valuedouble : 0.0;
+}
+
+} // namespace
+
+bool BenchmarkState::keepRunning() {
+    if (!started) {
+        started = true;
+        realStartNs = realTimeNs();
+        cpuStartNs = cpuTimeNs();
+    }
+    if (done < iterations) {
+        done++;
+        return true;
+    }
+    if (!paused) {
+        realNs += realTimeNs() - realStartNs;
+        cpuNs += cpuTimeNs() - cpuStartNs;
+    }
+    return false;
+}
+
+void BenchmarkState::pauseTiming() {
+    if (!paused) {
+        realNs += realTimeNs() - realStartNs;
+        cpuNs += cpuTimeNs() - cpuStartNs;
+        paused = true;
+    }
+}
+
+void BenchmarkState::resumeTiming() {
+    if (paused) {
+        paused = false;
+        realStartNs = realTimeNs();
+        cpuStartNs = cpuTimeNs();
+    }
+}
+
+void Benchmark::registerBenchmark(const std::string &name, BenchmarkFunction function,
+                                  const std::vector<int64_t> &args) {
+    if (args.empty()) {
+        entries.push_back({name, function, 0});
+        return;
+    }
+    for (int64_t arg: args) {
+        entries.push_back({name + "/" + std::to_string(arg), function, arg});
+    }
+}
+
+void Benchmark::runOnce(const Entry &entry, BenchmarkState &state) {
+    entry.function(state);
+    if (state.done < state.iterations) {
+        fprintf(stderr, "benchmark %s: loop exited after %lld of %lld iterations\n", entry.name.c_str(),
+                (long long)state.done, (long long)state.iterations);
+        abort(); // benchmark本身写错了，结果没有意义
+    }
+}
+
+BenchmarkResult Benchmark::run(const Entry &entry, const BenchmarkOptions &options) {
+    // 预热：迭代次数每轮翻倍，直到累计运行了warmupMs。最后一轮的耗时用来估计每次迭代的时间，至少运行一轮
+    int64_t iterations = 1;
+    double perIterationNs = 0.0;
+    double warmedNs = 0.0;
+    while (true) {
+        BenchmarkState state(entry.arg, iterations);
+        runOnce(entry, state);
+        perIterationNs = std::max(1.0, (double)state.realNs / iterations);
+        warmedNs += state.realNs;
+        if (warmedNs >= options.warmupMs * 1e6 || state.realNs >= options.minTimeMs * 1e6) {
+            break;
+        }
+        iterations *= 2;
+    }
+    iterations = std::max((int64_t)1, (int64_t)std::ceil(options.minTimeMs * 1e6 / perIterationNs));
+
+    std::vector<double> realSamples;
+    std::vector<double> cpuSamples;
+    std::vector<double> itemRates;
+    std::vector<double> byteRates;
+    for (int i = 0; i < options.repetitions; i++) {
+        BenchmarkState state(entry.arg, iterations);
+        runOnce(entry, state);
+        realSamples.push_back((double)state.realNs / iterations);
+        cpuSamples.push_back((double)state.cpuNs / iterations);
+        if (state.realNs > 0) {
+            itemRates.push_back(state.itemsProcessed * 1e9 / state.realNs);
+            byteRates.push_back(state.bytesProcessed * 1e9 / state.realNs);
+        }
+    }
+
+    BenchmarkResult result;
+    result.name = entry.name;
+    result.arg = entry.arg;
+    result.iterations = iterations;
+    result.repetitions = options.repetitions;
+    result.realNs = summarize(realSamples);
+    result.cpuNs = summarize(cpuSamples);
+    result.itemsPerSecond = summarize(itemRates).median;
+    result.bytesPerSecond = summarize(byteRates).median;
+    return result;
+}
+
+std::vector<BenchmarkResult> Benchmark::runAll(const BenchmarkOptions &options) {
+    std::vector<BenchmarkResult> results;
+    printf("%-56s %12s %12s %12s %7s %10s  %s\n", "benchmark", "iterations", "median", "cpu", "cv", "min", "rate");
+    for (const Entry &entry: entries) {
+        if (!options.filter.empty() && entry.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        if (options.maxArg > 0 && entry.arg > options.maxArg) {
+            continue;
+        }
+        BenchmarkResult result = run(entry, options);
+        std::string rate;
+        if (result.bytesPerSecond > 0.0) {
+            rate = formatRate(result.bytesPerSecond, "B");
+        } else if (result.itemsPerSecond > 0.0) {
+            rate = formatRate(result.itemsPerSecond, " items");
+        }
+        printf("%-56s %12lld %12s %12s %6.1f%% %10s  %s\n", result.name.c_str(), (long long)result.iterations,
+               formatNs(result.realNs.median).c_str(), formatNs(result.cpuNs.median).c_str(), result.realNs.cv * 100.0,
+               formatNs(result.realNs.min).c_str(), rate.c_str());
+        fflush(stdout);
+        results.push_back(result);
+    }
+    return results;
+}
+
+bool Benchmark::writeJson(const std::string &path, const BenchmarkOptions &options,
+                          const std::vector<BenchmarkResult> &results) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON *context = cJSON_AddObjectToObject(root, "context");
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    cJSON_AddStringToObject(context, "date", date);
+    char host[256] = {0};
+    gethostname(host, sizeof(host) - 1);
+    cJSON_AddStringToObject(context, "host", host);
+    cJSON_AddNumberToObject(context, "cpus", sysconf(_SC_NPROCESSORS_ONLN));
+    cJSON_AddNumberToObject(context, "repetitions", options.repetitions);
+    cJSON_AddNumberToObject(context, "minTimeMs", options.minTimeMs);
+    cJSON_AddNumberToObject(context, "warmupMs", options.warmupMs);
+
+    cJSON *benchmarks = cJSON_AddArrayToObject(root, "benchmarks");
+    for (const BenchmarkResult &result: results) {
+        cJSON *json = cJSON_CreateObject();
+        cJSON_AddStringToObject(json, "name", result.name.c_str());
+        cJSON_AddNumberToObject(json, "arg", result.arg);
+        cJSON_AddNumberToObject(json, "iterations", result.iterations);
+        cJSON_AddNumberToObject(json, "repetitions", result.repetitions);
+        cJSON_AddItemToObject(json, "realNs", statsToJson(result.realNs));
+        cJSON_AddItemToObject(json, "cpuNs", statsToJson(result.cpuNs));
+        if (result.itemsPerSecond > 0.0) {
+            cJSON_AddNumberToObject(json, "itemsPerSecond", rounded(result.itemsPerSecond));
+        }
+        if (result.bytesPerSecond > 0.0) {
+            cJSON_AddNumberToObject(json, "bytesPerSecond", rounded(result.bytesPerSecond));
+        }
+        cJSON_AddItemToArray(benchmarks, json);
+    }
+
+    char *text = cJSON_Print(root);
+    cJSON_Delete(root);
+    FILE *file = fopen(path.c_str(), "w");
+    bool written = file != nullptr;
+    if (!written) {
+        fprintf(stderr, "benchmark: can not write %s: %s\n", path.c_str(), strerror(errno));
+    } else {
+        fputs(text, file);
+        fputc('\n', file);
+        fclose(file);
+    }
+    free(text);
+    return written;
+}
+
+bool Benchmark::compare(const std::string &baselinePath, const std::vector<BenchmarkResult> &results) {
+    FILE *file = fopen(baselinePath.c_str(), "r");
+    if (file == nullptr) {
+        fprintf(stderr, "benchmark: can not read %s: %s\n", baselinePath.c_str(), strerror(errno));
+        return false;
+    }
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        text.append(buf, n);
+    }
+    fclose(file);
+    cJSON *root = cJSON_Parse(text.c_str());
+    cJSON *benchmarks = cJSON_GetObjectItemCaseSensitive(root, "benchmarks");
+    if (!cJSON_IsArray(benchmarks)) {
+        fprintf(stderr, "benchmark: %s is not a benchmark report\n", baselinePath.c_str());
+        cJSON_Delete(root);
+        return false;
+    }
+    std::map<std::string, BenchmarkStats> baseline;
+    cJSON *item;
+    cJSON_ArrayForEach(item, benchmarks) {
+        cJSON *name = cJSON_GetObjectItemCaseSensitive(item, "name");
+        cJSON *realNs = cJSON_GetObjectItemCaseSensitive(item, "realNs");
+        if (!cJSON_IsString(name) || !cJSON_IsObject(realNs)) {
+            continue;
+        }
+        BenchmarkStats stats = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        stats.median = numberValue(realNs, "median");
+        stats.cv = numberValue(realNs, "cv");
+        baseline[name->valuestring] = stats;
+    }
+    cJSON_Delete(root);
+
+    // 变化小于两次测量的cv之和时，很可能只是噪声
+    printf("\n%-56s %12s %12s %9s\n", "compared with baseline", "baseline", "current", "change");
+    for (const BenchmarkResult &result: results) {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second.median <= 0.0) {
+            printf("%-56s %12s %12s %9s\n", result.name.c_str(), "-", formatNs(result.realNs.median).c_str(), "new");
+            continue;
+        }
+        double change = result.realNs.median / it->second.median - 1.0;
+        bool noise = std::fabs(change) < it->second.cv + result.realNs.cv;
+        printf("%-56s %12s %12s %+8.1f%%%s\n", result.name.c_str(), formatNs(it->second.median).c_str(),
+               formatNs(result.realNs.median).c_str(), change * 100.0, noise ? " ~" : "");
+    }
+    return true;
+}
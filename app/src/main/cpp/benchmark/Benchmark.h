@@ -0,0 +1,114 @@
+#ifndef NATIVEACTIVITYDEMO_BENCHMARK_H
+#define NATIVEACTIVITYDEMO_BENCHMARK_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * 一次测量传给benchmark函数的状态，用法和Google Benchmark一样：
+ *   准备数据（不计时）
+ *   while (state.keepRunning()) { 被测的代码 }
+ * 每次迭代都要重新准备的数据放在pauseTiming和resumeTiming之间。
+ */
+class BenchmarkState {
+public:
+    BenchmarkState(int64_t arg, int64_t iterations) : arg(arg), iterations(iterations) {}
+
+    // 第一次调用时开始计时，运行了iterations次后停止计时并返回false
+    bool keepRunning();
+    void pauseTiming();
+    void resumeTiming();
+
+    int64_t getArg() const { return arg; } // 注册时的参数，这里是输入数据的倍数
+    int64_t getIterations() const { return iterations; }
+
+    // 所有迭代一共处理的数量，用于计算每秒的吞吐
+    void setItemsProcessed(int64_t items) { itemsProcessed = items; }
+    void setBytesProcessed(int64_t bytes) { bytesProcessed = bytes; }
+
+private:
+    friend class Benchmark;
+
+    int64_t arg;
+    int64_t iterations;
+    int64_t done = 0;
+    bool started = false;
+    bool paused = false;
+    int64_t realStartNs = 0;
+    int64_t cpuStartNs = 0;
+    int64_t realNs = 0;
+    int64_t cpuNs = 0;
+    int64_t itemsProcessed = 0;
+    int64_t bytesProcessed = 0;
+};
+
+typedef std::function<void(BenchmarkState &state)> BenchmarkFunction;
+
+struct BenchmarkOptions {
+    std::string filter; // 名字里包含它的才运行，为空时全部运行
+    int64_t maxArg = 0; // 跳过参数大于它的，0表示不限制
+    int repetitions = 10; // 统计用的重复次数
+    double minTimeMs = 100.0; // 每次重复至少运行的时间，由此决定迭代次数
+    double warmupMs = 200.0; // 正式测量前先运行的时间，缓存和分配器进入稳定状态
+};
+
+// 每次迭代的耗时在各次重复之间的统计，单位纳秒
+struct BenchmarkStats {
+    double mean;
+    double median;
+    double stddev;
+    double min;
+    double max;
+    double cv; // stddev / mean，太大时说明测量受到了干扰
+};
+
+struct BenchmarkResult {
+    std::string name; // 带参数时为"名字/参数"
+    int64_t arg;
+    int64_t iterations; // 每次重复的迭代次数
+    int repetitions;
+    BenchmarkStats realNs;
+    BenchmarkStats cpuNs; // 进程的cpu时间，多线程时大于realNs
+    double itemsPerSecond; // 按realNs的中位数计算，没有设置时为0
+    double bytesPerSecond;
+};
+
+/**
+ * 微基准测试：注册、预热、按目标时间确定迭代次数、重复测量后统计，结果输出为JSON，
+ * 可以和另一次提交的结果比较（见compare）。
+ */
+class Benchmark {
+public:
+    // args为空时注册一个不带参数的benchmark（arg为0），否则每个参数各是一个benchmark
+    static void registerBenchmark(const std::string &name, BenchmarkFunction function,
+                                  const std::vector<int64_t> &args = std::vector<int64_t>());
+
+    static std::vector<BenchmarkResult> runAll(const BenchmarkOptions &options);
+
+    static bool writeJson(const std::string &path, const BenchmarkOptions &options,
+                          const std::vector<BenchmarkResult> &results);
+    // 和之前writeJson写出的文件比较中位数，打印变化的百分比。读不了baseline时返回false
+    static bool compare(const std::string &baselinePath, const std::vector<BenchmarkResult> &results);
+
+    // 防止编译器把结果没有被使用的计算优化掉
+    template <typename T>
+    static void doNotOptimize(const T &value) {
+        asm volatile("" : : "r,m"(value) : "memory"); // gcc和clang都支持
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        BenchmarkFunction function;
+        int64_t arg;
+    };
+
+    static std::vector<Entry> entries;
+
+    static void runOnce(const Entry &entry, BenchmarkState &state);
+    static BenchmarkResult run(const Entry &entry, const BenchmarkOptions &options);
+};
+
+#endif //NATIVEACTIVITYDEMO_BENCHMARK_H
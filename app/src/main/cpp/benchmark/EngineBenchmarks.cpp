@@ -0,0 +1,422 @@
+#include "EngineBenchmarks.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+#include "Benchmark.h"
+#include "../platform/AssetProvider.h"
+#include "../resource/ResourceCache.h"
+#include "../texture/MipmapGenerator.h"
+#include "../texture/PixelConverter.h"
+#include "../texture/TextureUtils.h"
+#include "../utils/CoordinatesUtils.h"
+#include "../utils/ObjHelper.h"
+#include "../view/ObjMesh.h"
+#include "../view/ObjModel.h"
+#include "../view/Shape.h"
+
+const char *const EngineBenchmarks::SYNTHETIC_PREFIX = "synthetic/";
+std::string EngineBenchmarks::syntheticDir;
+
+namespace {
+
+typedef std::unordered_map<int, std::unordered_map<int, std::unique_ptr<MapLocInfo>>> MapLocInfos;
+
+// 场景里的地形，参数和DemoScene一致
+const char *const MOUNTAIN_OBJ = "blenderObjs/mountain.png";
+// 场景启动时loadPNGTextures一起解码的纹理
+const char *const SCENE_PNGS[] = {"mountain.png", "moon.png", "oldhouse2.png", "skybox.png", "brown.png"};
+const int SCENE_PNG_COUNT = sizeof(SCENE_PNGS) / sizeof(SCENE_PNGS[0]);
+const int SYNTHETIC_PNG_COUNT = 4; // 合成纹理每批的张数，和串行解码比较并行的收益
+const int HEIGHT_QUERIES = 1024; // getMapHeight每次迭代查询的点数
+const std::vector<int64_t> SCALES = {1, 10, 100};
+
+// 和ObjMesh::loadData一样通过Assets打开。输入不存在时测量没有意义
+FILE *openAsset(const std::string &assetName) {
+    int fd = Assets::openFd(assetName.c_str());
+    if (fd < 0) {
+        fprintf(stderr, "benchmark: can not open %s\n", assetName.c_str());
+        abort();
+    }
+    return fdopen(fd, "r");
+}
+
+void readTerrain(const std::string &assetName, ObjHelper::ObjData *pObjData, bool rearrange) {
+    FILE *file = openAsset(assetName);
+    if (rearrange) {
+        ObjHelper::readObjFile(file, pObjData, true, true, false);
+    } else {
+        ObjHelper::parseObjFile(file, pObjData, true, true);
+    }
+    fclose(file);
+}
+
+void copyMapLocInfos(const MapLocInfos &from, MapLocInfos &to) {
+    to.clear();
+    for (const auto &column: from) {
+        std::unordered_map<int, std::unique_ptr<MapLocInfo>> &toColumn = to[column.first];
+        for (const auto &entry: column.second) {
+            toColumn[entry.first] = std::unique_ptr<MapLocInfo>(new MapLocInfo(*entry.second));
+        }
+    }
+}
+
+// ObjData有unique_ptr不能直接拷贝，rearrangeVVtVns会修改输入，每次迭代从同一份解析结果复制
+void copyObjData(const ObjHelper::ObjData &from, ObjHelper::ObjData &to) {
+    to.minVertex = from.minVertex;
+    to.maxVertex = from.maxVertex;
+    to.vertices = from.vertices;
+    to.normals = from.normals;
+    to.texCoords = from.texCoords;
+    to.indeces = from.indeces;
+    copyMapLocInfos(from.mapLocInfos, to.mapLocInfos);
+}
+
+// 把Shape的两个protected方法暴露出来单独测量
+class TransformShape : public Shape {
+public:
+    using Shape::updateModelMat4;
+    using Shape::updateWrapBoxTransform;
+};
+
+void benchReadObjFile(BenchmarkState &state, const std::string &assetName) {
+    FILE *sizeFile = openAsset(assetName);
+    fseek(sizeFile, 0, SEEK_END);
+    int64_t fileBytes = ftell(sizeFile);
+    fclose(sizeFile);
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        FILE *file = openAsset(assetName);
+        ObjHelper::ObjData data;
+        state.resumeTiming();
+        ObjHelper::readObjFile(file, &data, true, true, false);
+        state.pauseTiming();
+        fclose(file);
+        state.resumeTiming();
+    }
+    state.setBytesProcessed(state.getIterations() * fileBytes);
+}
+
+void benchRearrange(BenchmarkState &state, const std::string &assetName) {
+    ObjHelper::ObjData parsed;
+    readTerrain(assetName, &parsed, false);
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        ObjHelper::ObjData data;
+        copyObjData(parsed, data);
+        state.resumeTiming();
+        ObjHelper::rearrangeVVtVns(&data, false, true);
+    }
+    state.setItemsProcessed(state.getIterations() * (int64_t)parsed.indeces.size());
+}
+
+void benchInsertLinearValue(BenchmarkState &state, const std::string &assetName) {
+    ObjHelper::ObjData loaded;
+    readTerrain(assetName, &loaded, true);
+    // 和ObjMesh::loadData的参数一致
+    float factor = ObjHelper::heightMapSampleFactor;
+    int minX = (int)(loaded.minVertex[0] * factor);
+    int minZ = (int)(loaded.minVertex[2] * factor);
+    int maxX = (int)(loaded.maxVertex[0] * factor);
+    int maxZ = (int)(loaded.maxVertex[2] * factor);
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        MapLocInfos data;
+        copyMapLocInfos(loaded.mapLocInfos, data);
+        state.resumeTiming();
+        CoordinatesUtils::insertLinearValue(data, minX, minZ, maxX, maxZ);
+        state.pauseTiming();
+        data.clear(); // 释放不计入
+        state.resumeTiming();
+    }
+    state.setItemsProcessed(state.getIterations() * (int64_t)(maxX - minX + 1) * (maxZ - minZ + 1));
+}
+
+void benchGetMapHeight(BenchmarkState &state, const std::string &assetName) {
+    // 保持模型和mesh数据在各次运行之间不被释放，只在第一次加载
+    static std::map<std::string, std::shared_ptr<ObjModel>> models;
+    std::shared_ptr<ObjModel> &model = models[assetName];
+    if (!model) {
+        model = std::make_shared<ObjModel>(assetName.c_str(), "brown.png", true, true, false);
+        model->scaleBy(9, 1.5, 9); // 和DemoScene里的mountain一样
+    }
+    std::shared_ptr<const ObjMeshData> meshData = ResourceCache::getMeshData(assetName.c_str(), true, true, false);
+    GLfloat scale[3];
+    model->getScale(scale);
+    // 固定种子，每次运行查询相同的点，覆盖整个地形
+    std::mt19937 random(20261019);
+    std::uniform_real_distribution<float> xs(meshData->minVertex[0] * scale[0], meshData->maxVertex[0] * scale[0]);
+    std::uniform_real_distribution<float> zs(meshData->minVertex[2] * scale[2], meshData->maxVertex[2] * scale[2]);
+    std::vector<GLfloat> points(HEIGHT_QUERIES * 2);
+    for (int i = 0; i < HEIGHT_QUERIES; i++) {
+        points[i * 2] = xs(random);
+        points[i * 2 + 1] = zs(random);
+    }
+    while (state.keepRunning()) {
+        GLfloat sum = 0.0f;
+        for (int i = 0; i < HEIGHT_QUERIES; i++) {
+            sum += model->getMapHeight(points[i * 2], points[i * 2 + 1]);
+        }
+        Benchmark::doNotOptimize(sum);
+    }
+    state.setItemsProcessed(state.getIterations() * HEIGHT_QUERIES);
+}
+
+// 参数是一帧里更新变换的模型数
+std::vector<std::unique_ptr<TransformShape>> makeShapes(int64_t count) {
+    std::vector<std::unique_ptr<TransformShape>> shapes;
+    for (int64_t i = 0; i < count; i++) {
+        std::unique_ptr<TransformShape> shape(new TransformShape());
+        shape->initWrapBox(-1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f);
+        shape->moveBy(i * 0.1f, 0.0f, i * 0.2f);
+        shape->rotateBy(0.0f, i * 0.05f, 0.0f);
+        shape->worldRotateBy(0.0f, 0.3f, 0.0f);
+        shapes.push_back(std::move(shape));
+    }
+    return shapes;
+}
+
+void benchDecodePNGs(BenchmarkState &state, const char *const *pngFiles, int count, bool parallel) {
+    std::vector<void *> images(count);
+    std::vector<uint32_t> ws(count);
+    std::vector<uint32_t> hs(count);
+    int64_t decodedBytes = 0;
+    while (state.keepRunning()) {
+        if (parallel) {
+            TextureUtils::decodePNGs(pngFiles, count, images.data(), ws.data(), hs.data());
+        } else {
+            for (int i = 0; i < count; i++) {
+                images[i] = TextureUtils::decodePNG(pngFiles[i], &ws[i], &hs[i]);
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            if (images[i] == nullptr) {
+                fprintf(stderr, "benchmark: decode %s failed\n", pngFiles[i]);
+                abort();
+            }
+            decodedBytes += (int64_t)ws[i] * hs[i] * 4;
+            free(images[i]);
+        }
+    }
+    state.setBytesProcessed(decodedBytes);
+}
+
+// 解码一次，每次迭代复制level0后生成整条链，复制和释放不计入。参数是asset名
+void benchBuildMipmaps(BenchmarkState &state, const std::string &pngFile) {
+    uint32_t w = 0, h = 0;
+    void *decoded = TextureUtils::decodePNG(pngFile.c_str(), &w, &h);
+    if (decoded == nullptr) {
+        fprintf(stderr, "benchmark: decode %s failed\n", pngFile.c_str());
+        abort();
+    }
+    size_t bytes = (size_t)w * h * 4;
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        void *image = malloc(bytes);
+        memcpy(image, decoded, bytes);
+        state.resumeTiming();
+        int levels = MipmapGenerator::build(&image, w, h);
+        Benchmark::doNotOptimize(levels);
+        state.pauseTiming();
+        free(image);
+        state.resumeTiming();
+    }
+    free(decoded);
+    state.setItemsProcessed(state.getIterations() * (int64_t)w * h); // level0的像素数，items/s即像素/秒
+}
+
+// 不透明的合成纹理转RGB565，和TextureUtils::applyOption一样原地转换，每次迭代复制输入，复制不计入
+void benchConvertPixels(BenchmarkState &state, const std::string &pngFile, DitherMode dither) {
+    uint32_t w = 0, h = 0;
+    void *decoded = TextureUtils::decodePNG(pngFile.c_str(), &w, &h);
+    if (decoded == nullptr) {
+        fprintf(stderr, "benchmark: decode %s failed\n", pngFile.c_str());
+        abort();
+    }
+    std::vector<uint8_t> image((size_t)w * h * 4);
+    while (state.keepRunning()) {
+        state.pauseTiming();
+        memcpy(image.data(), decoded, image.size());
+        state.resumeTiming();
+        PixelConverter::convert(image.data(), w, h, PIXEL_RGB565, dither, (uint16_t *)image.data());
+    }
+    Benchmark::doNotOptimize(image[0]);
+    free(decoded);
+    state.setItemsProcessed(state.getIterations() * (int64_t)w * h);
+}
+
+} // namespace
+
+// 网格地形，(n+1)x(n+1)个顶点、2n^2个三角形，n = 10 * sqrt(scale)。间距固定，面积和scale成正比，
+// 插值后的高度图大小也和scale成正比。100倍时展开后的顶点数是60000，还在GLushort索引的范围内
+std::string EngineBenchmarks::syntheticTerrain(int scale) {
+    static std::set<int> written;
+    std::string assetName = std::string(SYNTHETIC_PREFIX) + "terrain_" + std::to_string(scale) + ".obj";
+    if (written.count(scale)) {
+        return assetName;
+    }
+    std::string path = syntheticDir + "/terrain_" + std::to_string(scale) + ".obj";
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "benchmark: can not write %s\n", path.c_str());
+        abort();
+    }
+    int n = (int)std::lround(10.0 * std::sqrt((double)scale));
+    const float spacing = 0.05f; // 高度图的采样间隔是0.01，格子之间需要插值
+    float half = n * spacing / 2.0f;
+    fprintf(file, "# synthetic terrain, scale %d\no terrain\n", scale);
+    for (int j = 0; j <= n; j++) {
+        for (int i = 0; i <= n; i++) {
+            float x = i * spacing - half;
+            float z = j * spacing - half;
+            fprintf(file, "v %.4f %.4f %.4f\n", x, 0.3f * std::sin(x * 1.7f) * std::cos(z * 1.3f), z);
+        }
+    }
+    for (int j = 0; j <= n; j++) {
+        for (int i = 0; i <= n; i++) {
+            fprintf(file, "vt %.4f %.4f\n", (float)i / n, (float)j / n);
+        }
+    }
+    for (int j = 0; j <= n; j++) {
+        for (int i = 0; i <= n; i++) {
+            float x = i * spacing - half;
+            float z = j * spacing - half;
+            // 高度函数的梯度
+            float dx = 0.3f * 1.7f * std::cos(x * 1.7f) * std::cos(z * 1.3f);
+            float dz = -0.3f * 1.3f * std::sin(x * 1.7f) * std::sin(z * 1.3f);
+            float length = std::sqrt(dx * dx + 1.0f + dz * dz);
+            fprintf(file, "vn %.4f %.4f %.4f\n", -dx / length, 1.0f / length, -dz / length);
+        }
+    }
+    fprintf(file, "s off\n");
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < n; i++) {
+            int a = j * (n + 1) + i + 1; // obj的索引从1开始
+            int b = a + 1;
+            int c = a + n + 1;
+            int d = c + 1;
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, c, c, c, b, b, b);
+            fprintf(file, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", b, b, b, c, c, c, d, d, d);
+        }
+    }
+    fclose(file);
+    written.insert(scale);
+    return assetName;
+}
+
+// 边长128 * sqrt(scale)的RGBA图片，渐变加上噪声，压缩率接近照片类的纹理
+std::string EngineBenchmarks::syntheticPng(int scale, int index) {
+    static std::set<std::pair<int, int>> written;
+    std::string name = "texture_" + std::to_string(scale) + "_" + std::to_string(index) + ".png";
+    std::string assetName = SYNTHETIC_PREFIX + name;
+    if (written.count({scale, index})) {
+        return assetName;
+    }
+    uint32_t size = (uint32_t)std::lround(128.0 * std::sqrt((double)scale));
+    std::vector<uint8_t> rgba((size_t)size * size * 4);
+    std::mt19937 random(index + 1);
+    for (uint32_t y = 0; y < size; y++) {
+        for (uint32_t x = 0; x < size; x++) {
+            uint32_t noise = random();
+            uint8_t *pixel = &rgba[((size_t)y * size + x) * 4];
+            pixel[0] = (uint8_t)(x * 255 / size + (noise & 15));
+            pixel[1] = (uint8_t)(y * 255 / size + ((noise >> 4) & 15));
+            pixel[2] = (uint8_t)((x + y) * 127 / size + ((noise >> 8) & 15));
+            pixel[3] = 255;
+        }
+    }
+    std::string path = syntheticDir + "/" + name;
+    if (!TextureUtils::encodePNG(path.c_str(), rgba.data(), size, size)) {
+        fprintf(stderr, "benchmark: can not write %s\n", path.c_str());
+        abort();
+    }
+    written.insert({scale, index});
+    return assetName;
+}
+
+void EngineBenchmarks::registerAll(const std::string &dir) {
+    syntheticDir = dir;
+
+    // 地形相关的几项，对应ObjMesh::loadData里的readObjFile、insertLinearValue和运行时的高度查询。
+    // 各有场景里的mountain和合成地形两种输入
+    typedef void (*TerrainBenchmark)(BenchmarkState &state, const std::string &assetName);
+    const std::pair<const char *, TerrainBenchmark> terrainBenchmarks[] = {
+            {"ObjHelper::readObjFile", benchReadObjFile},
+            {"ObjHelper::rearrangeVVtVns", benchRearrange},
+            {"CoordinatesUtils::insertLinearValue", benchInsertLinearValue},
+            {"ObjModel::getMapHeight", benchGetMapHeight},
+    };
+    for (const auto &entry: terrainBenchmarks) {
+        TerrainBenchmark function = entry.second;
+        Benchmark::registerBenchmark(std::string(entry.first) + "/mountain", [function](BenchmarkState &state) {
+            function(state, MOUNTAIN_OBJ);
+        });
+        Benchmark::registerBenchmark(std::string(entry.first) + "/synthetic", [function](BenchmarkState &state) {
+            function(state, syntheticTerrain((int)state.getArg()));
+        }, SCALES);
+    }
+
+    // 每次迭代更新参数个模型的变换
+    Benchmark::registerBenchmark("Shape::updateModelMat4", [](BenchmarkState &state) {
+        std::vector<std::unique_ptr<TransformShape>> shapes = makeShapes(state.getArg());
+        while (state.keepRunning()) {
+            for (const std::unique_ptr<TransformShape> &shape: shapes) {
+                shape->updateModelMat4();
+            }
+        }
+        state.setItemsProcessed(state.getIterations() * state.getArg());
+    }, SCALES);
+    Benchmark::registerBenchmark("Shape::updateWrapBoxTransform", [](BenchmarkState &state) {
+        std::vector<std::unique_ptr<TransformShape>> shapes = makeShapes(state.getArg());
+        while (state.keepRunning()) {
+            for (const std::unique_ptr<TransformShape> &shape: shapes) {
+                shape->updateWrapBoxTransform();
+            }
+        }
+        state.setItemsProcessed(state.getIterations() * state.getArg());
+    }, SCALES);
+
+    // 解码之后在同一个工作线程里生成mipmap，场景里最大的纹理和合成纹理
+    Benchmark::registerBenchmark("MipmapGenerator::build/skybox", [](BenchmarkState &state) {
+        benchBuildMipmaps(state, "skybox.png");
+    });
+    Benchmark::registerBenchmark("MipmapGenerator::build/synthetic", [](BenchmarkState &state) {
+        benchBuildMipmaps(state, syntheticPng((int)state.getArg(), 0));
+    }, SCALES);
+
+    // 16位纹理的转换，三种抖动方式
+    const std::pair<const char *, DitherMode> dithers[] = {
+            {"none", DITHER_NONE}, {"ordered", DITHER_ORDERED}, {"diffusion", DITHER_DIFFUSION}
+    };
+    for (const auto &entry: dithers) {
+        DitherMode dither = entry.second;
+        Benchmark::registerBenchmark(std::string("PixelConverter::convert/") + entry.first + "/synthetic",
+                                     [dither](BenchmarkState &state) {
+            benchConvertPixels(state, syntheticPng((int)state.getArg(), 0), dither);
+        }, SCALES);
+    }
+
+    // loadPNGTextures的解码部分，逐张decodePNG和线程池里并行的decodePNGs
+    for (bool parallel: {false, true}) {
+        std::string name = parallel ? "TextureUtils::decodePNGs" : "TextureUtils::decodePNG";
+        Benchmark::registerBenchmark(name + "/scene", [parallel](BenchmarkState &state) {
+            benchDecodePNGs(state, SCENE_PNGS, SCENE_PNG_COUNT, parallel);
+        });
+        Benchmark::registerBenchmark(name + "/synthetic", [parallel](BenchmarkState &state) {
+            std::vector<std::string> names;
+            for (int i = 0; i < SYNTHETIC_PNG_COUNT; i++) {
+                names.push_back(syntheticPng((int)state.getArg(), i));
+            }
+            std::vector<const char *> files;
+            for (const std::string &name: names) {
+                files.push_back(name.c_str());
+            }
+            benchDecodePNGs(state, files.data(), SYNTHETIC_PNG_COUNT, parallel);
+        }, SCALES);
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef NATIVEACTIVITYDEMO_ENGINEBENCHMARKS_H
+#define NATIVEACTIVITYDEMO_ENGINEBENCHMARKS_H
+
+#include <string>
+
+/**
+ * 引擎热点的benchmark：obj解析和整理、高度图插值和查询、Shape的变换更新、png解码、mipmap生成和16位纹理转换。
+ * 每项都有场景里用到的asset和合成的输入两种，合成输入的参数是倍数（1、10、100），耗时应当大致按倍数增长。
+ * 合成的obj和png第一次用到时写到syntheticDir，通过asset名"synthetic/..."读取，见nativedemo-bench。
+ * 使用软件光栅化后端，不需要GL context。
+ */
+class EngineBenchmarks {
+public:
+    static const char *const SYNTHETIC_PREFIX; // "synthetic/"
+
+    static void registerAll(const std::string &syntheticDir);
+
+private:
+    static std::string syntheticDir;
+
+    static std::string syntheticTerrain(int scale);
+    static std::string syntheticPng(int scale, int index);
+};
+
+#endif //NATIVEACTIVITYDEMO_ENGINEBENCHMARKS_H
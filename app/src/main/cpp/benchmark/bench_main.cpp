@@ -0,0 +1,118 @@
+// 开发机上运行引擎的benchmark，结果写成JSON，可以和之前的结果比较：
+//   nativedemo-bench --assets app/src/main/assets --json before.json
+//   nativedemo-bench --assets app/src/main/assets --json after.json --baseline before.json
+// 只跑一部分：--filter ObjHelper，跳过100倍的输入：--max-scale 10
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include "Benchmark.h"
+#include "EngineBenchmarks.h"
+#include "../platform/AssetProvider.h"
+#include "../platform/PlatformLog.h"
+#include "../render/RenderBackend.h"
+
+namespace {
+
+// "synthetic/"开头的是benchmark生成的输入，其他的是assets目录
+class BenchAssetProvider : public AssetProvider {
+public:
+    BenchAssetProvider(const std::string &assetsDir, const std::string &syntheticDir)
+            : assets(assetsDir), synthetic(syntheticDir) {}
+
+    int openFd(const char *assetName) override {
+        size_t prefixLength = strlen(EngineBenchmarks::SYNTHETIC_PREFIX);
+        if (strncmp(assetName, EngineBenchmarks::SYNTHETIC_PREFIX, prefixLength) == 0) {
+            return synthetic.openFd(assetName + prefixLength);
+        }
+        return assets.openFd(assetName);
+    }
+
+private:
+    DirectoryAssetProvider assets;
+    DirectoryAssetProvider synthetic;
+};
+
+// 被测的代码里有app_log，打印到stderr会影响计时
+void discardLog(const char *) {}
+
+void usage(const char *program) {
+    fprintf(stderr, "usage: %s --assets DIR [--data DIR] [--filter TEXT] [--max-scale N]\n"
+                    "          [--repetitions N] [--min-time MS] [--warmup MS] [--json FILE] [--baseline FILE]"
+                    " [--verbose]\n", program);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string assetsDir;
+    std::string dataDir = ".";
+    std::string jsonPath;
+    std::string baselinePath;
+    bool verbose = false;
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--verbose") == 0) {
+            verbose = true;
+            continue;
+        }
+        if (value == nullptr) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(arg, "--assets") == 0) {
+            assetsDir = value;
+        } else if (strcmp(arg, "--data") == 0) {
+            dataDir = value;
+        } else if (strcmp(arg, "--filter") == 0) {
+            options.filter = value;
+        } else if (strcmp(arg, "--max-scale") == 0) {
+            options.maxArg = atoll(value);
+        } else if (strcmp(arg, "--repetitions") == 0) {
+            options.repetitions = atoi(value);
+        } else if (strcmp(arg, "--min-time") == 0) {
+            options.minTimeMs = atof(value);
+        } else if (strcmp(arg, "--warmup") == 0) {
+            options.warmupMs = atof(value);
+        } else if (strcmp(arg, "--json") == 0) {
+            jsonPath = value;
+        } else if (strcmp(arg, "--baseline") == 0) {
+            baselinePath = value;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    if (assetsDir.empty() || options.repetitions <= 0 || options.minTimeMs < 0.0 || options.warmupMs < 0.0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (!verbose) {
+        PlatformLog_set_sink(discardLog);
+    }
+    RenderBackend::set(RENDER_BACKEND_SOFT); // ObjModel同步加载cpu侧的数据，不需要GL
+    std::string syntheticDir = dataDir + "/synthetic";
+    mkdir(dataDir.c_str(), 0755);
+    mkdir(syntheticDir.c_str(), 0755);
+    Assets::setProvider(std::unique_ptr<AssetProvider>(new BenchAssetProvider(assetsDir, syntheticDir)));
+
+    EngineBenchmarks::registerAll(syntheticDir);
+    std::vector<BenchmarkResult> results = Benchmark::runAll(options);
+    if (results.empty()) {
+        fprintf(stderr, "no benchmark matches \"%s\"\n", options.filter.c_str());
+        return 2;
+    }
+    if (!jsonPath.empty() && !Benchmark::writeJson(jsonPath, options, results)) {
+        return 2;
+    }
+    if (!baselinePath.empty() && !Benchmark::compare(baselinePath, results)) {
+        return 2;
+    }
+    return 0;
+}
@@ -3,3 +3,9 @@
 //
 
 #define APP_DEBUG
+
+// 打开后场景中加入5000个实例化绘制的圆锥，用于测试实例化的性能
+//#define INSTANCING_STRESS_TEST
+
+// 去掉后PROFILE_ZONE和PROFILE_GPU_ZONE展开为空，不开启Profiler时连一次判断都没有
+#define APP_PROFILER
@@ -12,6 +12,8 @@
 #include <GLES3/gl32.h> // sdk18以上才支持GLESv3版本
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "GLESEngine.h"
 #include "../app_log.h"
@@ -23,26 +25,20 @@ struct GLESEngine {
     int32_t width;
     int32_t height;
     int32_t viewportSize;
-} engine = { EGL_NO_DISPLAY, EGL_NO_SURFACE, EGL_NO_CONTEXT, 0, 0, 0 };
+    int headless; // pbuffer surface，没有窗口
+} engine = { EGL_NO_DISPLAY, EGL_NO_SURFACE, EGL_NO_CONTEXT, 0, 0, 0, 0 };
 
 /**
- * Initialize an EGL context for the current display.
+ * 选择RGBA8888、16位深度的config，surfaceType是EGL_WINDOW_BIT或EGL_PBUFFER_BIT。
  */
-int GLESEngine_init(ANativeWindow *window) {
-    // initialize OpenGL ES and EGL
-
-    GLint major, minor;
-    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-    eglInitialize(display, &major, &minor);
-    app_log("egl, major: %d, minor: %d\n", major, minor);
-
+static EGLConfig choose_config(EGLDisplay display, EGLint surfaceType) {
     /*
      * Here specify the attributes of the desired configuration.
      * Below, we select an EGLConfig with at least 8 bits per color
      * component compatible with on-screen windows
      */
     const EGLint attribs[] = {
-            EGL_SURFACE_TYPE, EGL_WINDOW_BIT, /*EGL_PBUFFER_BIT*/ // 创建屏外渲染的surface
+            EGL_SURFACE_TYPE, surfaceType, // EGL_PBUFFER_BIT创建屏外渲染的surface
             EGL_BLUE_SIZE, 8,
             EGL_GREEN_SIZE, 8,
             EGL_RED_SIZE, 8,
@@ -58,6 +54,9 @@ int GLESEngine_init(ANativeWindow *window) {
      */
     eglChooseConfig(display, attribs, NULL, 0, &numConfigs);
     app_log("egl numConfigs: %d\n", numConfigs);
+    if (numConfigs <= 0) {
+        return NULL;
+    }
     EGLConfig supportedConfigs[numConfigs];
     eglChooseConfig(display, attribs, supportedConfigs, numConfigs, &numConfigs);
     assert(numConfigs);
@@ -80,16 +79,47 @@ int GLESEngine_init(ANativeWindow *window) {
     if (i == numConfigs) {
         config = supportedConfigs[0];
     }
+    return config;
+}
 
-    /* EGL_NATIVE_VISUAL_ID is an attribute of the EGLConfig that is
-     * guaranteed to be accepted by ANativeWindow_setBuffersGeometry().
-     * As soon as we picked a EGLConfig, we can safely reconfigure the
-     * ANativeWindow buffers to match, using EGL_NATIVE_VISUAL_ID. */
-    EGLint format;
-    eglGetConfigAttrib(display, config, EGL_NATIVE_VISUAL_ID, &format);
-
-    EGLSurface surface = eglCreateWindowSurface(display, config, window, NULL);
+void GLESEngine_compute_viewport(int32_t w, int32_t h, int32_t viewport[4]) {
+    // 选取缩小后的正方形
+//    if (w < h) {
+//        glViewport(0, (h - w)/2, w, w); // 指定左下角坐标和宽高
+//        engine.viewportSize = w;
+//    } else if (w > h) {
+//        glViewport((w - h)/2, 0, h, h);
+//        engine.viewportSize = h;
+//    } else {
+//        glViewport(0, 0, w, h); // default config set by opengl es engine
+//        engine.viewportSize = w;
+//    }
+    // 选取放大后的正方形
+    // 将中心定在偏下的1/3处。高度增加了1/3，即变为之前的4/3。
+    // -----------------
+    // |    |     |    |
+    // |    |     |    |
+    // |    |  ^  |    |
+    // |    -------    |
+    // |               |
+    // -----------------
+    if (w <= h) {
+        viewport[0] = (w-h)/2-h/6;
+        viewport[1] = -h*1/3;
+        viewport[2] = h*4/3;
+        viewport[3] = h*4/3;
+    } else {
+        viewport[0] = -w/6;
+        viewport[1] = (h-w)/2-w*1/3;
+        viewport[2] = w*4/3;
+        viewport[3] = w*4/3;
+    }
+}
 
+/**
+ * 创建context并和surface绑定，设置初始的GL状态和viewport。
+ */
+static int make_current(EGLDisplay display, EGLConfig config, EGLSurface surface) {
     EGLint contextAttribs[] = {
             EGL_CONTEXT_CLIENT_VERSION, 3,
             EGL_NONE
@@ -131,37 +161,90 @@ int GLESEngine_init(ANativeWindow *window) {
 
     app_log("OpenGL window w: %d, h: %d, ratio: %f\n", w, h, (float)h/w);
 
-    // 选取缩小后的正方形
-//    if (w < h) {
-//        glViewport(0, (h - w)/2, w, w); // 指定左下角坐标和宽高
-//        engine.viewportSize = w;
-//    } else if (w > h) {
-//        glViewport((w - h)/2, 0, h, h);
-//        engine.viewportSize = h;
-//    } else {
-//        glViewport(0, 0, w, h); // default config set by opengl es engine
-//        engine.viewportSize = w;
-//    }
-    // 选取放大后的正方形
-    // 将中心定在偏下的1/3处。高度增加了1/3，即变为之前的4/3。
-    // -----------------
-    // |    |     |    |
-    // |    |     |    |
-    // |    |  ^  |    |
-    // |    -------    |
-    // |               |
-    // -----------------
-    if (w <= h) {
-        glViewport((w-h)/2-h/6, -h*1/3, h*4/3, h*4/3); // 指定左下角坐标和宽高
-        engine.viewportSize = h*4/3;
-    } else {
-        glViewport(-w/6, (h-w)/2-w*1/3, w*4/3, w*4/3);
-        engine.viewportSize = w*4/3;
-    }
+    int32_t viewport[4];
+    GLESEngine_compute_viewport(w, h, viewport);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]); // 指定左下角坐标和宽高
+    engine.viewportSize = viewport[2];
 
     return 0;
 }
 
+/**
+ * Initialize an EGL context for the current display.
+ */
+int GLESEngine_init(EGLNativeWindowType window) {
+    // initialize OpenGL ES and EGL
+
+    GLint major, minor;
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    eglInitialize(display, &major, &minor);
+    app_log("egl, major: %d, minor: %d\n", major, minor);
+
+    EGLConfig config = choose_config(display, EGL_WINDOW_BIT);
+    assert(config);
+
+    /* EGL_NATIVE_VISUAL_ID is an attribute of the EGLConfig that is
+     * guaranteed to be accepted by ANativeWindow_setBuffersGeometry().
+     * As soon as we picked a EGLConfig, we can safely reconfigure the
+     * ANativeWindow buffers to match, using EGL_NATIVE_VISUAL_ID. */
+    EGLint format;
+    eglGetConfigAttrib(display, config, EGL_NATIVE_VISUAL_ID, &format);
+
+    EGLSurface surface = eglCreateWindowSurface(display, config, window, NULL);
+    engine.headless = 0;
+    return make_current(display, config, surface);
+}
+
+int GLESEngine_init_headless(int32_t width, int32_t height) {
+    GLint major, minor;
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (eglInitialize(display, &major, &minor) == EGL_FALSE) {
+        app_log("headless: eglInitialize failed: 0x%x\n", eglGetError());
+        return -1;
+    }
+    app_log("egl, major: %d, minor: %d, headless %dx%d\n", major, minor, width, height);
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    EGLConfig config = choose_config(display, EGL_PBUFFER_BIT);
+    if (config == NULL) {
+        app_log("headless: no pbuffer config\n");
+        eglTerminate(display);
+        return -1;
+    }
+    const EGLint surfaceAttribs[] = {
+            EGL_WIDTH, width,
+            EGL_HEIGHT, height,
+            EGL_NONE
+    };
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    if (surface == EGL_NO_SURFACE) {
+        app_log("headless: eglCreatePbufferSurface failed: 0x%x\n", eglGetError());
+        eglTerminate(display);
+        return -1;
+    }
+    engine.headless = 1;
+    return make_current(display, config, surface);
+}
+
+void GLESEngine_read_pixels(void *rgba) {
+    int32_t w = engine.width;
+    int32_t h = engine.height;
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    // GL的第一行在最下面，翻转成图片的顺序
+    size_t rowBytes = (size_t)w * 4;
+    unsigned char *row = (unsigned char *)malloc(rowBytes);
+    unsigned char *pixels = (unsigned char *)rgba;
+    for (int32_t y = 0; y < h / 2; y++) {
+        unsigned char *top = pixels + (size_t)y * rowBytes;
+        unsigned char *bottom = pixels + (size_t)(h - 1 - y) * rowBytes;
+        memcpy(row, top, rowBytes);
+        memcpy(top, bottom, rowBytes);
+        memcpy(bottom, row, rowBytes);
+    }
+    free(row);
+}
+
 /**
  * Just the current frame in the display.
  */
@@ -170,6 +253,10 @@ void GLESEngine_refresh() {
         // No display.
         return;
     }
+    if (engine.headless) {
+        glFinish(); // pbuffer没有swap，等GPU画完，帧时间才有意义
+        return;
+    }
     eglSwapBuffers(engine.display, engine.surface); // block until vSync is done.
 }
 
@@ -192,6 +279,7 @@ void GLESEngine_destroy() {
     engine.surface = EGL_NO_SURFACE;
     engine.width = 0;
     engine.height = 0;
+    engine.headless = 0;
 }
 
 int32_t GLESEngine_get_width() {
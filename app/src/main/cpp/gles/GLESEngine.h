@@ -5,13 +5,22 @@
 #ifndef NATIVEACTIVITYDEMO_GLESENGINE_H
 #define NATIVEACTIVITYDEMO_GLESENGINE_H
 
-#include <android/native_window.h>
+#include <EGL/egl.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int GLESEngine_init(ANativeWindow *);
+// window在android上就是ANativeWindow *
+int GLESEngine_init(EGLNativeWindowType window);
+
+// 不需要窗口，创建指定大小的pbuffer surface做屏外渲染，用于自动化的性能测试。
+// refresh时用glFinish代替eglSwapBuffers，帧时间包括GPU的执行时间
+int GLESEngine_init_headless(int32_t width, int32_t height);
+
+// 读取当前surface的RGBA像素，从上到下按行排列，rgba至少width * height * 4字节
+void GLESEngine_read_pixels(void *rgba);
 
 void GLESEngine_refresh();
 
@@ -23,6 +32,9 @@ int32_t GLESEngine_get_height();
 
 int32_t GLESEngine_get_viewport_size();
 
+// 按屏幕宽高计算demo使用的viewport：[x, y, 宽, 高]，左下角为原点。软件光栅化也用它，不调用GL
+void GLESEngine_compute_viewport(int32_t w, int32_t h, int32_t viewport[4]);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,292 @@
+#include "GLStateCache.h"
+#include <cstring>
+
+static const GLuint UNKNOWN_NAME = 0xffffffffu;
+static const GLenum UNKNOWN_ENUM = 0xffffffffu;
+
+GLuint GLStateCache::program = UNKNOWN_NAME;
+GLenum GLStateCache::activeUnit = UNKNOWN_ENUM;
+GLuint GLStateCache::textures[MAX_TEXTURE_UNITS] = {
+        UNKNOWN_NAME, UNKNOWN_NAME, UNKNOWN_NAME, UNKNOWN_NAME,
+        UNKNOWN_NAME, UNKNOWN_NAME, UNKNOWN_NAME, UNKNOWN_NAME
+};
+GLuint GLStateCache::vao = UNKNOWN_NAME;
+GLStateCache::BufferRange GLStateCache::uniformBindings[MAX_UNIFORM_BINDINGS] = {
+        {UNKNOWN_NAME, 0, 0}, {UNKNOWN_NAME, 0, 0}, {UNKNOWN_NAME, 0, 0}, {UNKNOWN_NAME, 0, 0}
+};
+int8_t GLStateCache::caps[MAX_CAPS] = {-1, -1, -1, -1};
+GLenum GLStateCache::blendSrc = UNKNOWN_ENUM;
+GLenum GLStateCache::blendDst = UNKNOWN_ENUM;
+GLenum GLStateCache::depthFuncValue = UNKNOWN_ENUM;
+int8_t GLStateCache::depthMaskValue = -1;
+GLfloat GLStateCache::lineWidthValue = -1.0f;
+std::unordered_map<uint64_t, GLStateCache::UniformValue> GLStateCache::uniforms;
+GLStateCacheStats GLStateCache::stats = {0, 0};
+
+void GLStateCache::invalidate() {
+    program = UNKNOWN_NAME;
+    activeUnit = UNKNOWN_ENUM;
+    for (GLuint &texture: textures) {
+        texture = UNKNOWN_NAME;
+    }
+    vao = UNKNOWN_NAME;
+    for (BufferRange &range: uniformBindings) {
+        range.buffer = UNKNOWN_NAME;
+    }
+    for (int8_t &cap: caps) {
+        cap = -1;
+    }
+    blendSrc = UNKNOWN_ENUM;
+    blendDst = UNKNOWN_ENUM;
+    depthFuncValue = UNKNOWN_ENUM;
+    depthMaskValue = -1;
+    lineWidthValue = -1.0f;
+    uniforms.clear();
+}
+
+void GLStateCache::resetStats() {
+    stats.issued = 0;
+    stats.skipped = 0;
+}
+
+void GLStateCache::useProgram(GLuint program_) {
+    if (program == program_) {
+        stats.skipped++;
+        return;
+    }
+    program = program_;
+    glUseProgram(program_);
+    stats.issued++;
+}
+
+void GLStateCache::activeTexture(GLenum unit) {
+    if (activeUnit == unit) {
+        stats.skipped++;
+        return;
+    }
+    activeUnit = unit;
+    glActiveTexture(unit);
+    stats.issued++;
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture) {
+    GLuint unit = activeUnit == UNKNOWN_ENUM ? 0 : activeUnit - GL_TEXTURE0;
+    // 只记录GL_TEXTURE_2D，其他target直接透传
+    if (target != GL_TEXTURE_2D || unit >= MAX_TEXTURE_UNITS) {
+        glBindTexture(target, texture);
+        stats.issued++;
+        return;
+    }
+    if (activeUnit != UNKNOWN_ENUM && textures[unit] == texture) {
+        stats.skipped++;
+        return;
+    }
+    textures[unit] = texture;
+    glBindTexture(target, texture);
+    stats.issued++;
+}
+
+void GLStateCache::bindVertexArray(GLuint vao_) {
+    if (vao == vao_) {
+        stats.skipped++;
+        return;
+    }
+    vao = vao_;
+    glBindVertexArray(vao_);
+    stats.issued++;
+}
+
+void GLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    if (target != GL_UNIFORM_BUFFER || index >= MAX_UNIFORM_BINDINGS) {
+        glBindBufferRange(target, index, buffer, offset, size);
+        stats.issued++;
+        return;
+    }
+    BufferRange &range = uniformBindings[index];
+    if (range.buffer == buffer && range.offset == offset && range.size == size) {
+        stats.skipped++;
+        return;
+    }
+    range.buffer = buffer;
+    range.offset = offset;
+    range.size = size;
+    glBindBufferRange(target, index, buffer, offset, size);
+    stats.issued++;
+}
+
+void GLStateCache::deleteBuffers(GLsizei n, const GLuint *buffers) {
+    for (GLsizei i = 0; i < n; i++) {
+        for (BufferRange &range: uniformBindings) {
+            if (range.buffer == buffers[i]) {
+                range.buffer = UNKNOWN_NAME;
+            }
+        }
+    }
+    glDeleteBuffers(n, buffers);
+}
+
+int GLStateCache::capIndex(GLenum cap) {
+    switch (cap) {
+        case GL_BLEND: return 0;
+        case GL_DEPTH_TEST: return 1;
+        case GL_CULL_FACE: return 2;
+        case GL_SCISSOR_TEST: return 3;
+        default: return -1;
+    }
+}
+
+void GLStateCache::enable(GLenum cap) {
+    int index = capIndex(cap);
+    if (index >= 0 && caps[index] == 1) {
+        stats.skipped++;
+        return;
+    }
+    if (index >= 0) caps[index] = 1;
+    glEnable(cap);
+    stats.issued++;
+}
+
+void GLStateCache::disable(GLenum cap) {
+    int index = capIndex(cap);
+    if (index >= 0 && caps[index] == 0) {
+        stats.skipped++;
+        return;
+    }
+    if (index >= 0) caps[index] = 0;
+    glDisable(cap);
+    stats.issued++;
+}
+
+void GLStateCache::blendFunc(GLenum sfactor, GLenum dfactor) {
+    if (blendSrc == sfactor && blendDst == dfactor) {
+        stats.skipped++;
+        return;
+    }
+    blendSrc = sfactor;
+    blendDst = dfactor;
+    glBlendFunc(sfactor, dfactor);
+    stats.issued++;
+}
+
+void GLStateCache::depthFunc(GLenum func) {
+    if (depthFuncValue == func) {
+        stats.skipped++;
+        return;
+    }
+    depthFuncValue = func;
+    glDepthFunc(func);
+    stats.issued++;
+}
+
+void GLStateCache::depthMask(GLboolean flag) {
+    if (depthMaskValue == (int8_t)flag) {
+        stats.skipped++;
+        return;
+    }
+    depthMaskValue = (int8_t)flag;
+    glDepthMask(flag);
+    stats.issued++;
+}
+
+void GLStateCache::lineWidth(GLfloat width) {
+    if (lineWidthValue == width) {
+        stats.skipped++;
+        return;
+    }
+    lineWidthValue = width;
+    glLineWidth(width);
+    stats.issued++;
+}
+
+// uniform的值是program对象的状态，key由program和location组成
+bool GLStateCache::uniformChanged(GLint location, const GLfloat *value, GLsizei size) {
+    if (program == UNKNOWN_NAME) {
+        return true;
+    }
+    uint64_t key = ((uint64_t)program << 32) | (uint32_t)location;
+    auto it = uniforms.find(key);
+    if (it != uniforms.end() && it->second.size == size &&
+        memcmp(it->second.values, value, sizeof(GLfloat) * size) == 0) {
+        return false;
+    }
+    UniformValue &uniform = uniforms[key];
+    uniform.size = size;
+    memcpy(uniform.values, value, sizeof(GLfloat) * size);
+    return true;
+}
+
+void GLStateCache::uniform1i(GLint location, GLint value) {
+    if (location < 0) return;
+    GLfloat bits;
+    memcpy(&bits, &value, sizeof(bits)); // 按位比较，和float的值共用一套存储
+    if (!uniformChanged(location, &bits, 1)) {
+        stats.skipped++;
+        return;
+    }
+    glUniform1i(location, value);
+    stats.issued++;
+}
+
+void GLStateCache::uniform3fv(GLint location, const GLfloat *value) {
+    if (location < 0) return;
+    if (!uniformChanged(location, value, 3)) {
+        stats.skipped++;
+        return;
+    }
+    glUniform3fv(location, 1, value);
+    stats.issued++;
+}
+
+void GLStateCache::uniform4fv(GLint location, const GLfloat *value) {
+    if (location < 0) return;
+    if (!uniformChanged(location, value, 4)) {
+        stats.skipped++;
+        return;
+    }
+    glUniform4fv(location, 1, value);
+    stats.issued++;
+}
+
+void GLStateCache::uniformMatrix4fv(GLint location, const GLfloat *value) {
+    if (location < 0) return;
+    if (!uniformChanged(location, value, 16)) {
+        stats.skipped++;
+        return;
+    }
+    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    stats.issued++;
+}
+
+void GLStateCache::deleteProgram(GLuint program_) {
+    if (program == program_) {
+        program = UNKNOWN_NAME;
+    }
+    for (auto it = uniforms.begin(); it != uniforms.end();) {
+        if ((GLuint)(it->first >> 32) == program_) {
+            it = uniforms.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    glDeleteProgram(program_);
+}
+
+void GLStateCache::deleteTextures(GLsizei n, const GLuint *textures_) {
+    for (GLsizei i = 0; i < n; i++) {
+        for (GLuint &texture: textures) {
+            if (texture == textures_[i]) {
+                texture = 0; // GL删除已绑定的纹理后，该单元会回到0
+            }
+        }
+    }
+    glDeleteTextures(n, textures_);
+}
+
+void GLStateCache::deleteVertexArrays(GLsizei n, const GLuint *vaos) {
+    for (GLsizei i = 0; i < n; i++) {
+        if (vao == vaos[i]) {
+            vao = 0;
+        }
+    }
+    glDeleteVertexArrays(n, vaos);
+}
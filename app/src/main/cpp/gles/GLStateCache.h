@@ -0,0 +1,86 @@
+#ifndef NATIVEACTIVITYDEMO_GLSTATECACHE_H
+#define NATIVEACTIVITYDEMO_GLSTATECACHE_H
+
+#include <GLES3/gl32.h>
+#include <cstdint>
+#include <unordered_map>
+
+struct GLStateCacheStats {
+    uint32_t issued; // 真正调用到GL的次数
+    uint32_t skipped; // 和当前状态相同而被过滤掉的次数
+};
+
+/**
+ * 记录当前context的GL状态，过滤掉重复的状态设置调用。
+ * 所有绑定、开关和uniform的设置都要经过这里，直接调用GL会导致记录的状态和实际不一致，
+ * 这种情况下（比如context重建后）需要调用invalidate。
+ * 只调用标准的gl*函数，test/GLStateCacheTest.cpp链接test/GLStub.cpp的GL桩库测试。
+ */
+class GLStateCache {
+public:
+    static void invalidate();
+
+    static void useProgram(GLuint program);
+    static void activeTexture(GLenum unit);
+    static void bindTexture(GLenum target, GLuint texture);
+    static void bindVertexArray(GLuint vao);
+    // 只记录GL_UNIFORM_BUFFER的前几个binding point
+    static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    static void enable(GLenum cap);
+    static void disable(GLenum cap);
+    static void blendFunc(GLenum sfactor, GLenum dfactor);
+    static void depthFunc(GLenum func);
+    static void depthMask(GLboolean flag);
+    static void lineWidth(GLfloat width);
+
+    // 作用于当前program，location为-1时忽略
+    static void uniform1i(GLint location, GLint value);
+    static void uniform3fv(GLint location, const GLfloat *value);
+    static void uniform4fv(GLint location, const GLfloat *value);
+    static void uniformMatrix4fv(GLint location, const GLfloat *value);
+
+    // 删除对象前调用，避免GL复用同一个名字后状态被误判为相同
+    static void deleteProgram(GLuint program);
+    static void deleteTextures(GLsizei n, const GLuint *textures);
+    static void deleteVertexArrays(GLsizei n, const GLuint *vaos);
+    static void deleteBuffers(GLsizei n, const GLuint *buffers);
+
+    static const GLStateCacheStats &getStats() { return stats; }
+    static void resetStats();
+
+private:
+    static const int MAX_TEXTURE_UNITS = 8;
+    static const int MAX_CAPS = 4;
+    static const int MAX_UNIFORM_BINDINGS = 4;
+
+    struct BufferRange {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    struct UniformValue {
+        GLsizei size;
+        GLfloat values[16];
+    };
+
+    static GLuint program;
+    static GLenum activeUnit;
+    static GLuint textures[MAX_TEXTURE_UNITS];
+    static GLuint vao;
+    static BufferRange uniformBindings[MAX_UNIFORM_BINDINGS];
+    static int8_t caps[MAX_CAPS]; // -1未知，0关闭，1开启
+    static GLenum blendSrc;
+    static GLenum blendDst;
+    static GLenum depthFuncValue;
+    static int8_t depthMaskValue;
+    static GLfloat lineWidthValue;
+    static std::unordered_map<uint64_t, UniformValue> uniforms;
+    static GLStateCacheStats stats;
+
+    static int capIndex(GLenum cap);
+    static bool uniformChanged(GLint location, const GLfloat *value, GLsizei size);
+};
+
+#endif //NATIVEACTIVITYDEMO_GLSTATECACHE_H
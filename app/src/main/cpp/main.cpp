@@ -15,24 +15,50 @@
 #include <vector>
 
 #include "app_log.h"
-#include "gles/GLESEngine.h"
-#include "view/Triangles.h"
 #include "view/Shape.h"
-#include "view/Cube.h"
 #include "utils/CoordinatesUtils.h"
 #include "utils/TouchEventHandler.h"
-#include "utils/AndroidAssetUtils.h"
-#include "view/ObjModel.h"
-#include "view/SkyBox.h"
+#include "scene/DemoApp.h"
+#include "scene/DemoScene.h"
+#include "utils/Utils.h"
+#include "utils/libglm0_9_6_3/glm/ext.hpp"
+#include "render/RenderBackend.h"
+#include "resource/AssetLoader.h"
+#include "platform/AssetProvider.h"
+#include "platform/android/AndroidAssetProvider.h"
+#include "platform/android/AndroidWindowProvider.h"
+#include "profiler/Profiler.h"
+#include <sys/system_properties.h>
 
 static const float NS_2_S = 1.0f / 1000000000.0f; // 将纳秒转成秒
 static const float DEG_2_RADIAN = (float) M_PI / 180.0f;
 
-static std::vector<std::shared_ptr<Shape>> shapes;
+static const float TAP_MAX_MILLIS = 200.0f; // 按下到抬起不超过这个时间，且没有移动，算一次点击
+static const float DOUBLE_TAP_MILLIS = 300.0f; // 两次点击的间隔，双击切换包围盒的显示
+static const float TAP_MOVE_SLOP = 8.0f; // 像素
+// headless模式：不创建窗口，在pbuffer上跑固定的帧数，输出帧时间统计后退出。
+// adb shell setprop debug.nativedemo.headless 300
+static const char *HEADLESS_FRAMES_PROPERTY = "debug.nativedemo.headless";
+static const char *HEADLESS_SIZE_PROPERTY = "debug.nativedemo.headless.size"; // 宽x高，默认1080x1920
+static const char *HEADLESS_READBACK_PROPERTY = "debug.nativedemo.headless.readback"; // 1时最后一帧保存为png
+// golden image回归测试，1：比较，2：录制。尺寸固定，golden不打包进apk，比较前先推到internalDataPath/golden_expected：
+// adb push app/src/test/golden /data/local/tmp/ && adb shell run-as com.czf.nativeactivitydemo cp -r /data/local/tmp/golden files/golden_expected
+static const char *GOLDEN_PROPERTY = "debug.nativedemo.golden";
+// 1时用软件光栅化代替GL，窗口模式直接写ANativeWindow的buffer，headless模式渲染到内存
+static const char *SOFT_RENDERER_PROPERTY = "debug.nativedemo.soft";
+// 1时开启Profiler，各zone的统计随帧时间每300帧打印一次；之后改为2时导出到internalDataPath/profile.json
+// adb shell setprop debug.nativedemo.profile 1
+static const char *PROFILE_PROPERTY = "debug.nativedemo.profile";
+static const int PROFILE_POLL_FRAMES = 60; // 窗口模式下每隔这么多帧检查一次属性
 
 static TouchEventHandler *touchEventHandler = NULL;
 
 static float gyro_event_ts_s_old = -1;
+static float touchDownMillis = 0.0f;
+static float lastTapMillis = -1.0f;
+static bool touchMoved = false;
+static int profileMode = 0;
+static int profilePollFrames = 0;
 
 /**
  * Our saved state data.
@@ -57,6 +83,7 @@ struct context {
     ASensorEventQueue *sensorEventQueue;
 
     int animating;
+    int headless; // headless模式已经跑完，不再创建窗口的context
     struct saved_state state;
 };
 
@@ -100,6 +127,70 @@ static void renderByANativeWindowAPI(ANativeWindow *window) {
     }
 }
 
+static int get_int_property(const char *name, int defaultValue) {
+    char value[PROP_VALUE_MAX] = {0};
+    if (__system_property_get(name, value) <= 0) {
+        return defaultValue;
+    }
+    return atoi(value);
+}
+
+/**
+ * 设置了debug.nativedemo.headless时，在pbuffer上渲染和窗口模式相同的场景：
+ * 等资源全部加载完后，跑固定的帧数，输出帧时间统计，可选把最后一帧保存到internalDataPath/headless.png。
+ * 返回false表示没有开启或者初始化失败，继续正常的窗口模式。
+ */
+static bool run_headless() {
+    HeadlessOptions options;
+    options.frames = get_int_property(HEADLESS_FRAMES_PROPERTY, 0);
+    if (options.frames <= 0) {
+        return false;
+    }
+    options.width = 1080;
+    options.height = 1920;
+    char size[PROP_VALUE_MAX] = {0};
+    if (__system_property_get(HEADLESS_SIZE_PROPERTY, size) > 0 &&
+        sscanf(size, "%dx%d", &options.width, &options.height) != 2) {
+        app_log("headless: invalid size %s, use 1080x1920\n", size);
+        options.width = 1080;
+        options.height = 1920;
+    }
+    options.readback = get_int_property(HEADLESS_READBACK_PROPERTY, 0) == 1;
+    return DemoApp::runHeadless(options);
+}
+
+/**
+ * 设置了debug.nativedemo.golden时，headless地沿固定的相机路径渲染场景，和internalDataPath/golden_expected/<后端>/里的图片比较，
+ * 报告和没有通过的帧写到internalDataPath/golden/，见GoldenRunner。为2时只录制，用来更新golden。
+ * 返回false表示没有开启或者初始化失败。
+ */
+static bool run_golden(struct android_app *app) {
+    int mode = get_int_property(GOLDEN_PROPERTY, 0);
+    if (mode != 1 && mode != 2) {
+        return false;
+    }
+    bool passed = false;
+    return DemoApp::runGolden(mode == 2, std::string(app->activity->internalDataPath) + "/golden_expected", &passed);
+}
+
+/**
+ * 窗口模式下画一帧。每隔PROFILE_POLL_FRAMES帧检查debug.nativedemo.profile，变化时开关Profiler，改为2时导出。
+ */
+static void draw_frame(struct android_app *app) {
+    if (++profilePollFrames >= PROFILE_POLL_FRAMES) {
+        profilePollFrames = 0;
+        int mode = get_int_property(PROFILE_PROPERTY, 0);
+        if (mode != profileMode) {
+            Profiler::setEnabled(mode == 1 || mode == 2);
+            if (mode == 2) {
+                Profiler::requestExport(std::string(app->activity->internalDataPath) + "/profile.json");
+            }
+            profileMode = mode;
+        }
+    }
+    DemoApp::drawFrame();
+}
+
 /**
  * Process the next main command.
  */
@@ -117,101 +208,23 @@ static void on_handle_cmd(struct android_app *app, int32_t cmd) {
         case APP_CMD_INIT_WINDOW:
             // The window is being shown, get it ready.
             app_log("cmd -- init window\n");
-            if (context->app->window != NULL) {
-                GLESEngine_init(context->app->window);
-                context->width = GLESEngine_get_width();
-                context->height = GLESEngine_get_height();
-
-                CoordinatesUtils::screenW = context->width;
-                CoordinatesUtils::screenH = context->height;
-                CoordinatesUtils::screenS = context->width > context->height ? context->height : context->width;
-                CoordinatesUtils::screenL = context->width > context->height ? context->width : context->height;
-                CoordinatesUtils::glesViewportSize = GLESEngine_get_viewport_size();
-
-                AndroidAssetUtils::init(app->activity->assetManager);
-
-                BaseShader::getSingletonProgram();
-                TextureUtils::loadSimpleTexture(); // 加载一些纯色的纹理，当颜色用
-
-                // 深度测试的基准,注意1.0代表从近裁剪面到远裁剪面 这一段范围！！并不是指Z轴的1个单位
-                // 深度，是一个normalized的值，范围是 0-1(不是z轴坐标)，对应Z轴是从近裁剪面到远裁剪面
-                // 所以这里的 1.0f 指的是，深度缓冲区中远裁剪面以内全部清除
-                glClearDepthf(1.0f);
-                glClearColor(0, 0, 0, 0);
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-                // blend跟物体渲染顺序有关，需要后渲染半透明物体
-//                shapes[0] = new Cube();
-//                shapes[0] = new Triangles();
-                shared_ptr<Shape> mountain = make_shared<ObjModel>("blenderObjs/mountain.png",
-                                                                   "mountain.png", true, true, false);
-                mountain->scaleBy(9, 1.5, 9); // 长宽放大10倍
-                shapes.push_back(mountain);
-
-                shared_ptr<Shape> tower = make_shared<ObjModel>("blenderObjs/tower.png",
-                                                                "tower.png", false, true, false);
-                tower->moveBy(5.66, 3.51, -17.21);
-                shapes.push_back(tower);
-
-                shared_ptr<Shape> moodhouse = make_shared<ObjModel>("blenderObjs/moodhouse.png",
-                                                                    "moodhouse.png", false, true, false);
-                moodhouse->moveBy(0, mountain->getMapHeight(0, 18), 18);
-                moodhouse->rotateBy(0, 0.5, 0);
-                moodhouse->scaleBy(-0.8, -0.8, -0.8);
-                shapes.push_back(moodhouse);
-
-                shared_ptr<Shape> moon = make_shared<ObjModel>("blenderObjs/moon.png",
-                                                               "moon.png", false, true, false);
-                moon->moveBy(12, 12, 30);
-                shapes.push_back(moon);
-
-                shared_ptr<Shape> oldHouse = make_shared<ObjModel>("blenderObjs/oldhouse2.png",
-                                                                   "oldhouse2.png", false, true, false);
-                oldHouse->moveBy(10.11f, 3.78f, 7.25f);
-                oldHouse->rotateBy(0, -0.3f, 0);
-                oldHouse->scaleBy(1.2f, 1.2f, 1.2f);
-                shapes.push_back(oldHouse);
-
-                shared_ptr<Shape> skybox = make_shared<SkyBox>();
-                skybox->scaleBy(40.0f, 40.0f, 40.0f);
-                shapes.push_back(skybox);
-
-                shared_ptr<Shape> monkey = make_shared<ObjModel>("blenderObjs/monkey.png",
-                                                                 "brown.png", false, true, false);
-                monkey->moveBy(0, 0.294f, 0); // 模型的-y为-0.98
-                monkey->rotateBy(0, 3.14f, 0);
-                monkey->scaleBy(-0.7f, -0.7f, -0.7f); // 缩小为原来的3/10
-                shapes.push_back(monkey);
-                // 测试高度准确性
-//                shared_ptr<Shape> cocacola = make_shared<ObjModel>("blenderObjs/cocacola.png",
-//                                                                   "cocacola.png", false, true, false);
-//                cocacola->moveBy(0, 0.24656f, 0); // 模型的-y为-1.232813
-//                cocacola->scaleBy(-0.95f, -0.8f, -0.95f); // 高缩小为原来的2/10
-//                shapes.push_back(cocacola);
-
-                GLfloat initHeight = mountain->getMapHeight(0, 0);
-                for (int i = 0; i < shapes.size(); i++) {
-                    if (shapes[i]) {
-                        if (i < shapes.size() - 1) {
-                            shapes[i]->worldMoveYTo(initHeight);
-                        }
-                        shapes[i]->draw();
-                    }
-                }
+            if (context->app->window != NULL && !context->headless) {
+                long initStartUS = Utils::getCurrTimeUS();
+                DemoApp::startWindow(std::unique_ptr<WindowProvider>(
+                        new AndroidWindowProvider(context->app->window, RenderBackend::isSoft())));
 
 //                renderByANativeWindowAPI(app->window);
 
-                GLESEngine_refresh();
+                app_log("first frame: %.1fms\n", (Utils::getCurrTimeUS() - initStartUS) / 1000.0f);
             }
             break;
         case APP_CMD_TERM_WINDOW:
             // The window is being hidden or closed, clean it up.
             app_log("cmd -- destroy window\n");
-            shapes.clear();
-
-            BaseShader::deleteSingletonProgram();
-            TextureUtils::deleteSimpleTexture();
-            GLESEngine_destroy();
+            if (context->headless) {
+                break;
+            }
+            DemoApp::stopWindow();
             break;
         case APP_CMD_GAINED_FOCUS:
             // When our app gains focus, we start monitoring the accelerometer.
@@ -289,63 +302,43 @@ ASensorManager *AcquireASensorManagerInstance(struct android_app *app) {
 
 void initTouchEventHandlerCallbacks() {
     touchEventHandler->setOnTouchDown([](float downX, float downY, float downMillis) {
+        touchDownMillis = downMillis;
+        touchMoved = false;
     });
     touchEventHandler->setOnTouchMove([](float deltaX, float deltaY, float currX, float currY,
                                          float currMillis, int fingers) {
+        if (fabsf(deltaX) + fabsf(deltaY) > TAP_MOVE_SLOP) {
+            touchMoved = true;
+        }
         float distance2radianFactor = M_PI / CoordinatesUtils::screenS; // 划过屏幕短边为一个PI，横竖一致，符合操作常理
         float rotateXradian = (float)(deltaY * distance2radianFactor);
         float rotateYradian = (float)(deltaX * distance2radianFactor);
         float transX = CoordinatesUtils::android2gles_distance(deltaX);
         float transY = CoordinatesUtils::android2gles_distance(deltaY);
-
-        // 获取该位置的高度和法向量
-        GLfloat height = 0;
-        glm::vec3 normal(0, 1.0f, 0);
-        GLfloat transXYZ[3];
-        shapes[0]->getTranslate(transXYZ);
-        height = shapes[0]->getMapHeight(transXYZ[0], transXYZ[2]);
-        if (transXYZ[0] >= 3.5f && transXYZ[0] <= 7.7f && transXYZ[2] >= -19.3f && transXYZ[2] <= -15.1f) {
-            height = 3.51f + 7.648166f; // tower的区域和高度
-        }
-        if (transXYZ[0] >= 12.0f-1.723f && transXYZ[0] <= 12.0f+1.723f && transXYZ[2] >= 30.0f-1.723f && transXYZ[2] <= 30.0f+1.723f) {
-            height = 12.0f + 1.721207f; // moon的区域和高度
-        }
-//        app_log("map location: x: %f, z: %f, y: %f, height: %f\n", transXYZ[0], transXYZ[2], transXYZ[1], height);
-        shapes[0]->getMapNormal(transXYZ[0], transXYZ[2], normal);
-
-        for (int i = 0; i < shapes.size() - 1; i++) {
-            if (shapes[i]) {
-                if (fingers == 1) {
-                    // 透视模式下乘5，视角是60度，观察者距离是10，感觉是10的一半
-                    shapes[i]->worldMoveBy(transX * 5, 0, -transY * 5);
-                    shapes[i]->worldMoveYTo(height);
-                } else {
-                    if (abs(deltaX) > abs(deltaY)) {
-                        shapes[i]->worldRotateBy(0, -rotateYradian, 0); // 对于矩阵变换来说，轴正向朝向自己，顺时针转为正
-                    } else {
-                        shapes[i]->worldMoveBy(0, -transY * 5, 0);
-                    }
-                }
-            }
-        }
-        // 设置角色的朝向和倾斜度
-        float directionYradian = atan2(deltaY, deltaX) - 1.57f;
-        shapes[shapes.size() - 1]->rotateYTo(directionYradian);
-
-        float rotateX = atan2(normal[2], normal[1]);
-        shapes[shapes.size() - 1]->rotateXTo(rotateX);
-        float rotateZ = atan2(normal[0], normal[1]);
-        shapes[shapes.size() - 1]->rotateZTo(-rotateZ);
+        DemoScene::drag(DemoApp::getShapes(), transX, transY, rotateYradian, fingers);
     });
     touchEventHandler->setOnTouchCancel([](float cancelX, float cancelY, float cancelMillis) {
         app_log("cancel\n");
     });
     touchEventHandler->setOnTouchUp([](float upX, float upY, float upMillis) {
+        if (touchMoved || upMillis - touchDownMillis > TAP_MAX_MILLIS) {
+            lastTapMillis = -1.0f;
+            return;
+        }
+        if (lastTapMillis >= 0.0f && upMillis - lastTapMillis < DOUBLE_TAP_MILLIS) {
+            DebugDraw &debugDraw = DemoApp::getDebugDraw();
+            debugDraw.setEnabled(!debugDraw.isEnabled());
+            app_log("debug draw: %s\n", debugDraw.isEnabled() ? "on" : "off");
+            lastTapMillis = -1.0f;
+        } else {
+            lastTapMillis = upMillis;
+        }
     });
     touchEventHandler->setOnScale(
             [](float scaleX1, float scaleY1, float scaleDistance, float currMillis) {
+                std::vector<std::shared_ptr<Shape>> &shapes = DemoApp::getShapes();
                 float scale = scaleDistance / CoordinatesUtils::screenS;
-                for (int i = 0; i < shapes.size() - 1; i++) {
+                for (size_t i = 0; i + 1 < shapes.size(); i++) {
                     if (shapes[i]) {
 //                        shapes[i]->worldScaleBy(scale, scale, scale);
                     }
@@ -353,7 +346,8 @@ void initTouchEventHandlerCallbacks() {
             });
     touchEventHandler->setOnRotate([](float rotateDeg, float currMillis) {
         float rotateZradian = rotateDeg * DEG_2_RADIAN;
-        for (int i = 0; i < shapes.size(); i++) {
+        std::vector<std::shared_ptr<Shape>> &shapes = DemoApp::getShapes();
+        for (size_t i = 0; i < shapes.size(); i++) {
             if (shapes[i]) {
 //                shapes[i]->rotateBy(0, 0, -rotateZradian); // 对于矩阵变换来说，轴正向朝向自己，顺时针转为正
             }
@@ -390,6 +384,22 @@ void android_main(struct android_app *app) {
         context.state = *(struct saved_state *) app->savedState;
     }
 
+    if (get_int_property(SOFT_RENDERER_PROPERTY, 0) == 1) {
+        app_log("render backend: soft rasterizer\n");
+        RenderBackend::set(RENDER_BACKEND_SOFT);
+    }
+    Assets::setProvider(std::unique_ptr<AssetProvider>(new AndroidAssetProvider(app->activity->assetManager)));
+    DemoApp::setDataPath(app->activity->internalDataPath);
+    profileMode = get_int_property(PROFILE_PROPERTY, 0);
+    if (profileMode == 1 || profileMode == 2) {
+        Profiler::setEnabled(true);
+    }
+    if (run_golden(app) || run_headless()) {
+        // 之后只处理事件，直到activity销毁
+        context.headless = 1;
+        ANativeActivity_finish(app->activity);
+    }
+
     // loop waiting for stuff to do.
     while (1) {
         // Read all pending events.
@@ -400,7 +410,7 @@ void android_main(struct android_app *app) {
         // If not animating, we will block forever waiting for events.
         // If animating, we loop until all events are read, then continue
         // to draw the next frame of animation.
-        while ((ident = ALooper_pollAll(/*context.animating ? 0 : */-1, NULL, &events,
+        while ((ident = ALooper_pollAll(/*context.animating ? 0 : */AssetLoader::hasPending() ? 0 : -1, NULL, &events,
                                                                     (void **) &source)) >= 0) {
             // Process this event.
             if (source != NULL) {
@@ -418,7 +428,8 @@ void android_main(struct android_app *app) {
                             float rotateXradian = event.data[0] * dT; // gyro返回的值单位是弧度/s
                             float rotateYradian = event.data[1] * dT;
                             float rotateZradian = event.data[2] * dT;
-                            for (int i = 0; i < shapes.size() - 1; i++) {
+                            std::vector<std::shared_ptr<Shape>> &shapes = DemoApp::getShapes();
+                            for (size_t i = 0; i + 1 < shapes.size(); i++) {
                                 if (shapes[i]) {
                                     shapes[i]->worldRotateBy(rotateXradian, rotateYradian, -rotateZradian);
                                 }
@@ -435,26 +446,18 @@ void android_main(struct android_app *app) {
                 return;
             }
 
-            if (app->window != NULL) {
+            if (app->window != NULL && !context.headless) {
 //                renderByANativeWindowAPI(app->window);
 
-                glClearColor(0.7f, 0.7f, 0.7f, 1.0f);
-                glClearDepthf(1.0f);
-                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-                for (int i = 0; i < shapes.size(); i++) {
-                    if (i == 3 && shapes[i]) { // moon
-                        shapes[i]->rotateBy(0.0f, 1.0f / 60.0f, 0.0f);
-                    }
-                    if (shapes[i]) {
-                        shapes[i]->draw();
-                    }
-                }
-
-                GLESEngine_refresh();
+                draw_frame(app);
             }
         }
 
+        // 没有事件时pollAll会一直阻塞，还有资源在加载时不等待，继续画帧直到都上传完
+        if (app->window != NULL && !context.headless && AssetLoader::hasPending()) {
+            draw_frame(app);
+        }
+
 //        if (context.animating) {
 //          // Done with events; draw next animation frame.
 //          context.state.angle += .01F;
@@ -0,0 +1,18 @@
+#include "AssetProvider.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+std::unique_ptr<AssetProvider> Assets::provider;
+
+int DirectoryAssetProvider::openFd(const char *assetName) {
+    std::string path = rootDir + "/" + assetName;
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+void Assets::setProvider(std::unique_ptr<AssetProvider> assetProvider) {
+    provider = std::move(assetProvider);
+}
+
+int Assets::openFd(const char *assetName) {
+    return provider ? provider->openFd(assetName) : -1;
+}
@@ -0,0 +1,42 @@
+#ifndef NATIVEACTIVITYDEMO_ASSETPROVIDER_H
+#define NATIVEACTIVITYDEMO_ASSETPROVIDER_H
+
+#include <memory>
+#include <string>
+
+/**
+ * 按asset路径（例如"blenderObjs/mountain.png"）打开只读的文件描述符，读取位置在文件的开头。
+ * android上是AAssetManager，开发机上是assets目录。
+ */
+class AssetProvider {
+public:
+    virtual ~AssetProvider() {}
+    // 失败返回-1
+    virtual int openFd(const char *assetName) = 0;
+};
+
+// 文件系统里的一个目录，和apk里的assets目录结构相同
+class DirectoryAssetProvider : public AssetProvider {
+public:
+    explicit DirectoryAssetProvider(const std::string &rootDir) : rootDir(rootDir) {}
+    int openFd(const char *assetName) override;
+
+private:
+    std::string rootDir;
+};
+
+/**
+ * 当前使用的AssetProvider，ObjMesh、TextureUtils、KtxTexture都通过它读取资源。
+ * 在创建场景之前设置，工作线程会并发调用openFd，provider需要线程安全。
+ */
+class Assets {
+public:
+    static void setProvider(std::unique_ptr<AssetProvider> assetProvider);
+    // 没有设置provider时返回-1
+    static int openFd(const char *assetName);
+
+private:
+    static std::unique_ptr<AssetProvider> provider;
+};
+
+#endif //NATIVEACTIVITYDEMO_ASSETPROVIDER_H
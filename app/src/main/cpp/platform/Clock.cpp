@@ -0,0 +1,20 @@
+#include "Clock.h"
+#include <ctime>
+
+ClockSource Clock::source = Clock::monotonicUS;
+
+void Clock::setSource(ClockSource clockSource) {
+    source = clockSource != nullptr ? clockSource : monotonicUS;
+}
+
+long Clock::monotonicUS() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+int64_t Clock::monotonicNS() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
@@ -0,0 +1,27 @@
+#ifndef NATIVEACTIVITYDEMO_CLOCK_H
+#define NATIVEACTIVITYDEMO_CLOCK_H
+
+#include <cstdint>
+
+// 返回微秒，只用于计算时间间隔
+typedef long (*ClockSource)();
+
+/**
+ * 引擎用的时间源，Utils::getCurrTimeUS通过它取时间。默认是单调时钟，不受系统时间调整的影响；
+ * 测试和回放时可以换成固定步长的时钟。
+ */
+class Clock {
+public:
+    // nullptr时恢复默认
+    static void setSource(ClockSource source);
+    static long nowUS() { return source(); }
+
+    static long monotonicUS();
+    // 不经过source，Profiler用它测量真实的耗时
+    static int64_t monotonicNS();
+
+private:
+    static ClockSource source;
+};
+
+#endif //NATIVEACTIVITYDEMO_CLOCK_H
@@ -0,0 +1,37 @@
+#include "PlatformLog.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+
+static void default_sink(const char *message) {
+    __android_log_write(ANDROID_LOG_DEBUG, "--==--", message);
+}
+#else
+#include <string.h>
+
+// logcat里每次调用是单独的一行，这里保持一致
+static void default_sink(const char *message) {
+    size_t length = strlen(message);
+    fputs(message, stderr);
+    if (length == 0 || message[length - 1] != '\n') {
+        fputc('\n', stderr);
+    }
+}
+#endif
+
+static PlatformLogSink current_sink = default_sink;
+
+void PlatformLog_set_sink(PlatformLogSink sink) {
+    current_sink = sink != NULL ? sink : default_sink;
+}
+
+void PlatformLog_print(const char *format, ...) {
+    char message[1024]; // 和logcat单条日志的长度差不多，更长的截断
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    current_sink(message);
+}
@@ -0,0 +1,24 @@
+#ifndef NATIVEACTIVITYDEMO_PLATFORMLOG_H
+#define NATIVEACTIVITYDEMO_PLATFORMLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 收到的是格式化好的一条日志，和logcat一样每次调用是一条
+typedef void (*PlatformLogSink)(const char *message);
+
+// 替换日志的输出，NULL时恢复默认：android上是logcat，其他平台是stderr
+void PlatformLog_set_sink(PlatformLogSink sink);
+
+void PlatformLog_print(const char *format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+        __attribute__((format(printf, 1, 2)))
+#endif
+        ;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //NATIVEACTIVITYDEMO_PLATFORMLOG_H
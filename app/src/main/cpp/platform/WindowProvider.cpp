@@ -0,0 +1,9 @@
+#include "WindowProvider.h"
+
+bool MemoryWindowProvider::lock(SoftTarget &target) {
+    target.pixels = pixels.data();
+    target.width = width;
+    target.height = height;
+    target.stride = width;
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef NATIVEACTIVITYDEMO_WINDOWPROVIDER_H
+#define NATIVEACTIVITYDEMO_WINDOWPROVIDER_H
+
+#include <EGL/egl.h>
+#include <cstdint>
+#include <vector>
+#include "../render/SoftRasterizer.h"
+
+/**
+ * 渲染的目的地。GL后端用getNativeWindow创建EGL window surface；
+ * 软件光栅化每帧lock得到像素buffer，画完后unlockAndPost。
+ */
+class WindowProvider {
+public:
+    virtual ~WindowProvider() {}
+
+    virtual int32_t getWidth() = 0;
+    virtual int32_t getHeight() = 0;
+    // 没有对应的原生窗口时返回0，只能用pbuffer或者软件光栅化
+    virtual EGLNativeWindowType getNativeWindow() = 0;
+    // 成功时target指向这一帧的buffer，之后必须调用unlockAndPost
+    virtual bool lock(SoftTarget &target) = 0;
+    virtual void unlockAndPost() = 0;
+};
+
+// 内存里的RGBA8888 buffer，用于headless的软件光栅化，画完的帧一直保留到下一次lock
+class MemoryWindowProvider : public WindowProvider {
+public:
+    MemoryWindowProvider(int32_t width, int32_t height)
+            : width(width), height(height), pixels((size_t)width * height) {}
+
+    int32_t getWidth() override { return width; }
+    int32_t getHeight() override { return height; }
+    EGLNativeWindowType getNativeWindow() override { return (EGLNativeWindowType)0; }
+    bool lock(SoftTarget &target) override;
+    void unlockAndPost() override {}
+
+    // 从上到下按行排列，没有行间的padding
+    const std::vector<uint32_t> &getPixels() const { return pixels; }
+
+private:
+    int32_t width;
+    int32_t height;
+    std::vector<uint32_t> pixels;
+};
+
+#endif //NATIVEACTIVITYDEMO_WINDOWPROVIDER_H
@@ -3,15 +3,9 @@
 //
 
 #include <unistd.h>
-#include "AndroidAssetUtils.h"
+#include "AndroidAssetProvider.h"
 
-AAssetManager *AndroidAssetUtils::assetManager = NULL;
-
-void AndroidAssetUtils::init(AAssetManager *assetMgr) {
-    assetManager = assetMgr;
-}
-
-int AndroidAssetUtils::openFdFromAsset(const char *assetName) {
+int AndroidAssetProvider::openFd(const char *assetName) {
     AAsset *asset = AAssetManager_open(assetManager, assetName, AASSET_MODE_STREAMING);
     if (asset == nullptr) {
         return -1;
@@ -0,0 +1,21 @@
+//
+// Created by mtdp on 2020-04-11.
+//
+
+#ifndef NATIVEACTIVITYDEMO_ANDROIDASSETPROVIDER_H
+#define NATIVEACTIVITYDEMO_ANDROIDASSETPROVIDER_H
+
+#include <android/asset_manager.h>
+#include "../AssetProvider.h"
+
+// apk里的assets，通过AAssetManager读取
+class AndroidAssetProvider : public AssetProvider {
+public:
+    explicit AndroidAssetProvider(AAssetManager *assetManager) : assetManager(assetManager) {}
+    int openFd(const char *assetName) override;
+
+private:
+    AAssetManager *assetManager;
+};
+
+#endif //NATIVEACTIVITYDEMO_ANDROIDASSETPROVIDER_H
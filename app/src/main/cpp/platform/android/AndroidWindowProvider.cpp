@@ -0,0 +1,27 @@
+#include "AndroidWindowProvider.h"
+#include <cerrno>
+#include <cstring>
+#include "../../app_log.h"
+
+AndroidWindowProvider::AndroidWindowProvider(ANativeWindow *window, bool soft) : window(window) {
+    if (soft) { // 不创建EGL surface，直接写窗口的buffer
+        ANativeWindow_setBuffersGeometry(window, 0, 0, WINDOW_FORMAT_RGBA_8888);
+    }
+}
+
+bool AndroidWindowProvider::lock(SoftTarget &target) {
+    ANativeWindow_Buffer buffer;
+    if (ANativeWindow_lock(window, &buffer, NULL) != 0) {
+        app_log("lock fail: %s\n", strerror(errno));
+        return false;
+    }
+    target.pixels = (uint32_t *) buffer.bits;
+    target.width = buffer.width;
+    target.height = buffer.height;
+    target.stride = buffer.stride;
+    return true;
+}
+
+void AndroidWindowProvider::unlockAndPost() {
+    ANativeWindow_unlockAndPost(window);
+}
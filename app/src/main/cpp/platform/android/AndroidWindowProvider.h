@@ -0,0 +1,22 @@
+#ifndef NATIVEACTIVITYDEMO_ANDROIDWINDOWPROVIDER_H
+#define NATIVEACTIVITYDEMO_ANDROIDWINDOWPROVIDER_H
+
+#include <android/native_window.h>
+#include "../WindowProvider.h"
+
+// android_app的窗口。软件光栅化时把buffer格式设成RGBA_8888，和SoftTarget的布局一致
+class AndroidWindowProvider : public WindowProvider {
+public:
+    AndroidWindowProvider(ANativeWindow *window, bool soft);
+
+    int32_t getWidth() override { return ANativeWindow_getWidth(window); }
+    int32_t getHeight() override { return ANativeWindow_getHeight(window); }
+    EGLNativeWindowType getNativeWindow() override { return window; }
+    bool lock(SoftTarget &target) override;
+    void unlockAndPost() override;
+
+private:
+    ANativeWindow *window;
+};
+
+#endif //NATIVEACTIVITYDEMO_ANDROIDWINDOWPROVIDER_H
@@ -0,0 +1,98 @@
+// 开发机上的入口，不需要窗口：headless测试和golden image回归测试，参数对应android上的debug.nativedemo.*属性。
+//   nativedemo-host --assets app/src/main/assets --backend soft --golden compare --golden-dir app/src/test/golden
+//   nativedemo-host --assets app/src/main/assets --backend gles --headless 300 --size 1080x1920 --readback
+// --profile FILE开启Profiler，结束时把各zone的统计写到FILE
+// GL后端需要EGL和GLES3的实现，没有显示器时用mesa的EGL_PLATFORM=surfaceless
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include "../../app_log.h"
+#include "../AssetProvider.h"
+#include "../../profiler/Profiler.h"
+#include "../../render/RenderBackend.h"
+#include "../../scene/DemoApp.h"
+
+static void usage(const char *program) {
+    fprintf(stderr, "usage: %s --assets DIR [--data DIR] [--backend soft|gles]\n"
+                    "          (--headless FRAMES [--size WxH] [--readback] | --golden compare|record [--golden-dir DIR])"
+                    " [--profile FILE]\n", program);
+}
+
+int main(int argc, char **argv) {
+    std::string assetsDir;
+    std::string dataDir = ".";
+    std::string backend = "soft";
+    std::string golden;
+    std::string goldenDir = "app/src/test/golden"; // golden不在assets里，默认在仓库根目录下运行
+    std::string profilePath;
+    HeadlessOptions headless = {0, 1080, 1920, false};
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--readback") == 0) {
+            headless.readback = true;
+            continue;
+        }
+        if (value == nullptr) {
+            usage(argv[0]);
+            return 2;
+        }
+        if (strcmp(arg, "--assets") == 0) {
+            assetsDir = value;
+        } else if (strcmp(arg, "--data") == 0) {
+            dataDir = value;
+        } else if (strcmp(arg, "--backend") == 0) {
+            backend = value;
+        } else if (strcmp(arg, "--headless") == 0) {
+            headless.frames = atoi(value);
+        } else if (strcmp(arg, "--size") == 0) {
+            if (sscanf(value, "%dx%d", &headless.width, &headless.height) != 2) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--golden") == 0) {
+            golden = value;
+        } else if (strcmp(arg, "--golden-dir") == 0) {
+            goldenDir = value;
+        } else if (strcmp(arg, "--profile") == 0) {
+            profilePath = value;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+    bool runGolden = golden == "compare" || golden == "record";
+    if (assetsDir.empty() || (backend != "soft" && backend != "gles") || (!golden.empty() && !runGolden) ||
+        (!runGolden && headless.frames <= 0)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (backend == "soft") {
+        RenderBackend::set(RENDER_BACKEND_SOFT);
+    } else {
+        setenv("EGL_PLATFORM", "surfaceless", 0); // 已经设置了的不覆盖
+    }
+    Assets::setProvider(std::unique_ptr<AssetProvider>(new DirectoryAssetProvider(assetsDir)));
+    mkdir(dataDir.c_str(), 0755);
+    DemoApp::setDataPath(dataDir);
+    if (!profilePath.empty()) {
+        Profiler::setEnabled(true);
+    }
+
+    int result;
+    if (runGolden) {
+        bool passed = false;
+        result = !DemoApp::runGolden(golden == "record", goldenDir, &passed) ? 2 : passed ? 0 : 1;
+    } else {
+        result = DemoApp::runHeadless(headless) ? 0 : 2;
+    }
+    if (!profilePath.empty() && result != 2 && !Profiler::exportJson(profilePath)) {
+        return 2;
+    }
+    return result;
+}
@@ -0,0 +1,99 @@
+#include "GpuTimer.h"
+#include <GLES2/gl2ext.h>
+#include <cstring>
+#include "../app_log.h"
+
+bool GpuTimer::available = false;
+bool GpuTimer::active = false;
+int GpuTimer::frameIndex = 0;
+GpuTimer::FrameQueries GpuTimer::frames[GpuTimer::FRAME_LATENCY];
+
+static bool hasExtension(const char *name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char *extension = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (extension != nullptr && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GpuTimer::init() {
+    release();
+    if (!hasExtension("GL_EXT_disjoint_timer_query")) {
+        app_log("gpu timer: GL_EXT_disjoint_timer_query not supported\n");
+        return;
+    }
+    // ES3上核心的查询函数就接受GL_TIME_ELAPSED_EXT，不需要取EXT版本的函数指针
+    for (FrameQueries &frame: frames) {
+        glGenQueries(MAX_PASSES, frame.queries);
+        frame.count = 0;
+    }
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint); // 读一次清掉之前的状态
+    frameIndex = 0;
+    active = false;
+    available = true;
+}
+
+void GpuTimer::release() {
+    if (!available) {
+        return;
+    }
+    if (active) {
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+        active = false;
+    }
+    for (FrameQueries &frame: frames) {
+        glDeleteQueries(MAX_PASSES, frame.queries);
+        frame.count = 0;
+    }
+    available = false;
+}
+
+void GpuTimer::beginFrame() {
+    if (!available) {
+        return;
+    }
+    frameIndex = (frameIndex + 1) % FRAME_LATENCY;
+    FrameQueries &frame = frames[frameIndex];
+    if (frame.count == 0) {
+        return;
+    }
+    // disjoint是从上次读取以来的状态，这时还没读回的结果可能都不准，一起丢掉
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    for (int i = 0; i < frame.count && !disjoint; i++) {
+        GLuint ready = GL_FALSE;
+        glGetQueryObjectuiv(frame.queries[i], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready) {
+            continue; // 不等待GPU
+        }
+        GLuint elapsedNs = 0; // 32位的纳秒，够表示4秒
+        glGetQueryObjectuiv(frame.queries[i], GL_QUERY_RESULT, &elapsedNs);
+        Profiler::recordGpu(frame.names[i], elapsedNs);
+    }
+    frame.count = 0;
+}
+
+bool GpuTimer::begin(const char *name) {
+    FrameQueries &frame = frames[frameIndex];
+    if (!available || active || !Profiler::isEnabled() || frame.count == MAX_PASSES) {
+        return false;
+    }
+    frame.names[frame.count] = name;
+    glBeginQuery(GL_TIME_ELAPSED_EXT, frame.queries[frame.count]);
+    active = true;
+    return true;
+}
+
+void GpuTimer::end() {
+    if (!active) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED_EXT);
+    frames[frameIndex].count++;
+    active = false;
+}
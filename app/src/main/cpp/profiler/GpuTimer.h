@@ -0,0 +1,68 @@
+#ifndef NATIVEACTIVITYDEMO_GPUTIMER_H
+#define NATIVEACTIVITYDEMO_GPUTIMER_H
+
+#include <GLES3/gl32.h>
+#include "Profiler.h"
+
+/**
+ * 用GL_EXT_disjoint_timer_query测量每个pass的GPU时间，结果交给Profiler::recordGpu。
+ * 查询结果要等GPU执行完才有，按帧轮流使用FRAME_LATENCY组查询对象，几帧之后再读，不等待GPU；
+ * 那时还没有结果或者发生了disjoint（降频、context切换等）的就丢掉。
+ * 同一时间只能有一个GL_TIME_ELAPSED_EXT查询，嵌套的pass只测量最外层。
+ * 不支持扩展或者Profiler没有开启时，所有方法都不做事。只能在GL线程调用。
+ */
+class GpuTimer {
+public:
+    static const int FRAME_LATENCY = 4;
+    static const int MAX_PASSES = 8; // 每帧最多测量的pass数
+
+    // GL context创建之后调用，检查扩展并创建查询对象
+    static void init();
+    // GL context销毁之前调用，还没读回的结果丢掉
+    static void release();
+    static bool isAvailable() { return available; }
+
+    // 每帧开始时调用，读回FRAME_LATENCY帧之前的结果
+    static void beginFrame();
+    // 开始了查询才返回true，这时需要调用end
+    static bool begin(const char *name);
+    static void end();
+
+private:
+    struct FrameQueries {
+        GLuint queries[MAX_PASSES];
+        const char *names[MAX_PASSES];
+        int count;
+    };
+
+    static bool available;
+    static bool active;
+    static int frameIndex;
+    static FrameQueries frames[FRAME_LATENCY];
+};
+
+// 作用域内的GPU耗时，name必须是字符串常量
+class GpuProfileZone {
+public:
+    explicit GpuProfileZone(const char *name) : started(GpuTimer::begin(name)) {}
+
+    ~GpuProfileZone() {
+        if (started) {
+            GpuTimer::end();
+        }
+    }
+
+    GpuProfileZone(const GpuProfileZone &) = delete;
+    GpuProfileZone &operator=(const GpuProfileZone &) = delete;
+
+private:
+    bool started;
+};
+
+#ifdef APP_PROFILER
+#define PROFILE_GPU_ZONE(name) GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(name)
+#else
+#define PROFILE_GPU_ZONE(name)
+#endif
+
+#endif //NATIVEACTIVITYDEMO_GPUTIMER_H
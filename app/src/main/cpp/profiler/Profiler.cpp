@@ -0,0 +1,327 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "../app_log.h"
+#include "../utils/cjson/cJSON.h"
+
+std::atomic<bool> Profiler::enabled(false);
+
+namespace {
+
+struct ZoneEvent {
+    const char *name;
+    int64_t beginNs;
+    int64_t endNs;
+};
+
+/**
+ * 单生产者单消费者：所属线程写，画帧的线程在endFrame里读。
+ * 写满时不覆盖还没取走的记录，写的一方丢掉新的记录并计数，所以同一个槽位不会同时被读写。
+ */
+struct ThreadRing {
+    ZoneEvent events[Profiler::RING_CAPACITY];
+    std::atomic<uint64_t> writeIndex{0}; // 写的一方发布，之前的槽位已经写好
+    std::atomic<uint64_t> readIndex{0}; // 读的一方发布，之前的槽位可以重新写
+    std::atomic<uint64_t> dropped{0}; // 只有写的一方增加
+    uint64_t droppedSeen = 0; // 只有读的一方访问，已经计入droppedEvents的部分
+    std::atomic<bool> retired{false}; // 线程已经退出，取完记录后释放
+};
+
+// 线程退出时标记它的ring buffer
+struct ThreadRingHolder {
+    ThreadRing *ring = nullptr;
+
+    ~ThreadRingHolder() {
+        if (ring != nullptr) {
+            ring->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+struct ZoneSample {
+    float ms;
+    uint32_t calls;
+};
+
+struct Zone {
+    std::string name;
+    bool gpu;
+    int64_t frameNs = 0; // 当前帧的累计
+    uint32_t frameCalls = 0;
+    std::vector<ZoneSample> samples; // 最近WINDOW_FRAMES帧，环形
+    size_t nextSample = 0;
+};
+
+thread_local ThreadRingHolder ringHolder;
+
+std::mutex ringsMutex; // 只在新线程第一次记录和endFrame取记录时加锁
+std::vector<std::unique_ptr<ThreadRing>> rings;
+
+// 以下只在画帧的线程访问
+std::vector<Zone> zones;
+std::unordered_map<const char *, size_t> zoneByPointer; // CPU zone的名字指针，同名的字符串常量可能有多个地址
+std::map<std::pair<std::string, bool>, size_t> zoneByName;
+int64_t frameBeginNs = 0;
+uint64_t frameCount = 0; // 统计以来的帧数
+uint64_t droppedEvents = 0;
+
+std::mutex exportMutex;
+std::string exportPath;
+std::atomic<bool> exportRequested(false);
+
+ThreadRing *registerThread() {
+    ThreadRing *ring = new ThreadRing();
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        rings.emplace_back(ring);
+    }
+    ringHolder.ring = ring;
+    return ring;
+}
+
+size_t findZone(const char *name, bool gpu) {
+    if (!gpu) {
+        auto it = zoneByPointer.find(name);
+        if (it != zoneByPointer.end()) {
+            return it->second;
+        }
+    }
+    auto key = std::make_pair(std::string(name), gpu);
+    auto it = zoneByName.find(key);
+    size_t index;
+    if (it != zoneByName.end()) {
+        index = it->second;
+    } else {
+        index = zones.size();
+        zones.emplace_back();
+        zones.back().name = name;
+        zones.back().gpu = gpu;
+        zoneByName[key] = index;
+    }
+    if (!gpu) {
+        zoneByPointer[name] = index;
+    }
+    return index;
+}
+
+void addToFrame(const char *name, bool gpu, int64_t ns) {
+    Zone &zone = zones[findZone(name, gpu)];
+    zone.frameNs += ns;
+    zone.frameCalls++;
+}
+
+// 取出ring里的记录，keep为false时只丢掉。[readIndex, writeIndex)之间的槽位写的一方不会再碰
+void drainRing(ThreadRing *ring, bool keep) {
+    uint64_t end = ring->writeIndex.load(std::memory_order_acquire);
+    if (keep) {
+        for (uint64_t i = ring->readIndex.load(std::memory_order_relaxed); i < end; i++) {
+            const ZoneEvent &event = ring->events[i & (Profiler::RING_CAPACITY - 1)];
+            addToFrame(event.name, false, event.endNs - event.beginNs);
+        }
+    }
+    ring->readIndex.store(end, std::memory_order_release);
+
+    uint64_t dropped = ring->dropped.load(std::memory_order_relaxed);
+    if (keep) {
+        droppedEvents += dropped - ring->droppedSeen;
+    }
+    ring->droppedSeen = dropped;
+}
+
+void drainRings(bool keep) {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (auto it = rings.begin(); it != rings.end();) {
+        ThreadRing *ring = it->get();
+        bool retired = ring->retired.load(std::memory_order_acquire); // 在取记录之前读，之后不会再有新的记录
+        drainRing(ring, keep);
+        it = retired ? rings.erase(it) : it + 1;
+    }
+}
+
+// 本帧出现过的zone各记一个样本
+void commitFrame() {
+    for (Zone &zone: zones) {
+        if (zone.frameCalls == 0) {
+            continue;
+        }
+        ZoneSample sample = {zone.frameNs / 1e6f, zone.frameCalls};
+        if (zone.samples.size() < Profiler::WINDOW_FRAMES) {
+            zone.samples.push_back(sample);
+        } else {
+            zone.samples[zone.nextSample] = sample;
+        }
+        zone.nextSample = (zone.nextSample + 1) % Profiler::WINDOW_FRAMES;
+        zone.frameNs = 0;
+        zone.frameCalls = 0;
+    }
+    frameCount++;
+}
+
+// 报告里保留3位小数就够了
+double rounded(float value) {
+    return std::round(value * 1000.0) / 1000.0;
+}
+
+} // namespace
+
+void Profiler::setEnabled(bool enable) {
+    if (enable && !isEnabled()) {
+        drainRings(false); // 关闭期间还在进行的zone留下的记录
+        frameBeginNs = 0;
+    }
+    enabled.store(enable, std::memory_order_relaxed);
+    app_log("profiler: %s\n", enable ? "enabled" : "disabled");
+}
+
+void Profiler::beginFrame() {
+    if (isEnabled()) {
+        frameBeginNs = Clock::monotonicNS();
+    }
+}
+
+void Profiler::endFrame() {
+    if (!isEnabled() || frameBeginNs == 0) {
+        return; // 中途开启时从下一个完整的帧开始
+    }
+    addToFrame("frame", false, Clock::monotonicNS() - frameBeginNs);
+    drainRings(true);
+    commitFrame();
+
+    if (exportRequested.exchange(false)) {
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(exportMutex);
+            path = exportPath;
+        }
+        exportJson(path);
+    }
+}
+
+void Profiler::reset() {
+    drainRings(false);
+    zones.clear();
+    zoneByPointer.clear();
+    zoneByName.clear();
+    frameBeginNs = 0;
+    frameCount = 0;
+    droppedEvents = 0;
+}
+
+void Profiler::record(const char *name, int64_t beginNs, int64_t endNs) {
+    ThreadRing *ring = ringHolder.ring;
+    if (ring == nullptr) {
+        ring = registerThread();
+    }
+    uint64_t index = ring->writeIndex.load(std::memory_order_relaxed);
+    if (index - ring->readIndex.load(std::memory_order_acquire) >= RING_CAPACITY) {
+        // 画帧的线程还没取走，例如在加载时没有画帧。只有这个线程写dropped，不需要read-modify-write
+        ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    ZoneEvent &event = ring->events[index & (RING_CAPACITY - 1)];
+    event.name = name;
+    event.beginNs = beginNs;
+    event.endNs = endNs;
+    ring->writeIndex.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::recordGpu(const char *name, int64_t elapsedNs) {
+    if (isEnabled()) {
+        addToFrame(name, true, elapsedNs);
+    }
+}
+
+std::vector<ProfileZoneStats> Profiler::getStats() {
+    std::vector<ProfileZoneStats> result;
+    for (const Zone &zone: zones) {
+        if (zone.samples.empty()) {
+            continue;
+        }
+        std::vector<float> sorted;
+        uint64_t calls = 0;
+        double sum = 0.0;
+        for (const ZoneSample &sample: zone.samples) {
+            sorted.push_back(sample.ms);
+            calls += sample.calls;
+            sum += sample.ms;
+        }
+        std::sort(sorted.begin(), sorted.end());
+        size_t rank = (sorted.size() * 99 + 99) / 100; // 最近秩法，和FrameStats一样
+        ProfileZoneStats stats;
+        stats.name = zone.name;
+        stats.gpu = zone.gpu;
+        stats.frames = sorted.size();
+        stats.callsPerFrame = (float)calls / sorted.size();
+        stats.minMs = sorted.front();
+        stats.avgMs = (float)(sum / sorted.size());
+        stats.p99Ms = sorted[rank > 0 ? rank - 1 : 0];
+        stats.maxMs = sorted.back();
+        result.push_back(stats);
+    }
+    return result;
+}
+
+void Profiler::logStats() {
+    for (const ProfileZoneStats &stats: getStats()) {
+        app_log("profiler %s %s: %zu frames, %.1f calls, min: %.3fms, avg: %.3fms, p99: %.3fms, max: %.3fms\n",
+                stats.gpu ? "gpu" : "cpu", stats.name.c_str(), stats.frames, stats.callsPerFrame, stats.minMs,
+                stats.avgMs, stats.p99Ms, stats.maxMs);
+    }
+    if (droppedEvents > 0) {
+        app_log("profiler: %llu events dropped\n", (unsigned long long)droppedEvents);
+    }
+}
+
+bool Profiler::exportJson(const std::string &path) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "frames", (double)frameCount);
+    cJSON_AddNumberToObject(root, "windowFrames", WINDOW_FRAMES);
+    cJSON_AddNumberToObject(root, "droppedEvents", (double)droppedEvents);
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        cJSON_AddNumberToObject(root, "threads", (double)rings.size());
+    }
+    cJSON *zonesJson = cJSON_AddArrayToObject(root, "zones");
+    for (const ProfileZoneStats &stats: getStats()) {
+        cJSON *json = cJSON_CreateObject();
+        cJSON_AddStringToObject(json, "name", stats.name.c_str());
+        cJSON_AddStringToObject(json, "type", stats.gpu ? "gpu" : "cpu");
+        cJSON_AddNumberToObject(json, "frames", (double)stats.frames);
+        cJSON_AddNumberToObject(json, "callsPerFrame", rounded(stats.callsPerFrame));
+        cJSON_AddNumberToObject(json, "minMs", rounded(stats.minMs));
+        cJSON_AddNumberToObject(json, "avgMs", rounded(stats.avgMs));
+        cJSON_AddNumberToObject(json, "p99Ms", rounded(stats.p99Ms));
+        cJSON_AddNumberToObject(json, "maxMs", rounded(stats.maxMs));
+        cJSON_AddItemToArray(zonesJson, json);
+    }
+
+    char *text = cJSON_Print(root);
+    cJSON_Delete(root);
+    FILE *file = fopen(path.c_str(), "w");
+    bool written = file != nullptr;
+    if (!written) {
+        app_log("profiler: can not write %s: %s\n", path.c_str(), strerror(errno));
+    } else {
+        fputs(text, file);
+        fclose(file);
+        app_log("profiler: exported %zu zones to %s\n", zones.size(), path.c_str());
+    }
+    free(text);
+    return written;
+}
+
+void Profiler::requestExport(const std::string &path) {
+    {
+        std::lock_guard<std::mutex> lock(exportMutex);
+        exportPath = path;
+    }
+    exportRequested.store(true);
+}
@@ -0,0 +1,90 @@
+#ifndef NATIVEACTIVITYDEMO_PROFILER_H
+#define NATIVEACTIVITYDEMO_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../config.h"
+#include "../platform/Clock.h"
+
+// 一个zone在统计窗口内的每帧耗时，同一帧里多次进入时累加。单位都是毫秒
+struct ProfileZoneStats {
+    std::string name;
+    bool gpu; // GpuTimer测量的GPU时间
+    size_t frames; // 出现过的帧数
+    float callsPerFrame;
+    float minMs;
+    float avgMs;
+    float p99Ms;
+    float maxMs;
+};
+
+/**
+ * 帧分析：用PROFILE_ZONE标记的代码段（任意线程）和GpuTimer测量的pass，按帧统计耗时。
+ * 记录时只写当前线程自己的ring buffer，不加锁；画帧的线程在endFrame里取出所有线程的记录，归到这一帧。
+ * 没有开启时PROFILE_ZONE只有一次relaxed的原子读，去掉config.h里的APP_PROFILER后完全没有开销。
+ * 除了record和requestExport，都只能在画帧的线程调用。
+ */
+class Profiler {
+public:
+    static const size_t WINDOW_FRAMES = 600; // 统计最近这么多帧
+    static const uint32_t RING_CAPACITY = 4096; // 每个线程的ring buffer能存的记录数，2的幂。写满后新的记录丢掉，计入droppedEvents
+
+    static void setEnabled(bool enable);
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    static void beginFrame();
+    // 整帧的耗时记为"frame"。有requestExport时在这里导出
+    static void endFrame();
+    // 丢掉已经统计的数据和各线程还没取出的记录，例如加载完成后只统计之后的帧
+    static void reset();
+
+    static std::vector<ProfileZoneStats> getStats();
+    static void logStats();
+    static bool exportJson(const std::string &path);
+    // 可以在任意线程调用，下一次endFrame时导出到path
+    static void requestExport(const std::string &path);
+
+    // 任意线程，ProfileZone析构时调用
+    static void record(const char *name, int64_t beginNs, int64_t endNs);
+    // GpuTimer读回结果时调用
+    static void recordGpu(const char *name, int64_t elapsedNs);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// 作用域内的CPU耗时，name必须是字符串常量（只保存指针）
+class ProfileZone {
+public:
+    explicit ProfileZone(const char *zoneName) : name(Profiler::isEnabled() ? zoneName : nullptr) {
+        if (name != nullptr) {
+            beginNs = Clock::monotonicNS();
+        }
+    }
+
+    ~ProfileZone() {
+        if (name != nullptr) {
+            Profiler::record(name, beginNs, Clock::monotonicNS());
+        }
+    }
+
+    ProfileZone(const ProfileZone &) = delete;
+    ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+    const char *name; // nullptr表示没有开启
+    int64_t beginNs = 0;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef APP_PROFILER
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name)
+#endif
+
+#endif //NATIVEACTIVITYDEMO_PROFILER_H
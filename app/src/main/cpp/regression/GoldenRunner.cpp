@@ -0,0 +1,241 @@
+#include "GoldenRunner.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sys/stat.h>
+#include "../app_log.h"
+#include "../platform/AssetProvider.h"
+#include "../scene/DemoScene.h"
+#include "../texture/TextureUtils.h"
+#include "../utils/FrameStats.h"
+#include "../utils/Utils.h"
+#include "../utils/cjson/cJSON.h"
+
+namespace {
+
+struct FrameResult {
+    int frame;
+    float frameMs; // 墙上时间
+    float cpuMs; // 进程所有线程的CPU时间，软件光栅化时包括工作线程
+    bool captured;
+    const char *status; // pass、fail、missing、size_mismatch、recorded、write_failed
+    ImageDiffResult diff;
+};
+
+struct PathResult {
+    std::string name;
+    float loadMs;
+    std::vector<FrameResult> frames;
+    FrameStatsSummary cpuSummary;
+};
+
+long getCpuTimeUS() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+bool makeDir(const std::string &path) {
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+        app_log("golden: mkdir %s failed: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+// 报告里保留几位小数就够了，避免float转double后打印出一长串
+double rounded(float value, double scale = 1000.0) {
+    return std::round(value * scale) / scale;
+}
+
+// decodePNG得到的是从下到上的行，翻转成和渲染结果相同的顺序
+uint8_t *loadGolden(AssetProvider &goldens, const std::string &fileName, uint32_t *w, uint32_t *h) {
+    uint8_t *image = (uint8_t *)TextureUtils::decodePNG(goldens, fileName.c_str(), w, h);
+    if (image == nullptr) {
+        return nullptr;
+    }
+    size_t rowBytes = (size_t)*w * 4;
+    std::vector<uint8_t> row(rowBytes);
+    for (uint32_t y = 0; y < *h / 2; y++) {
+        uint8_t *top = image + y * rowBytes;
+        uint8_t *bottom = image + (*h - 1 - y) * rowBytes;
+        memcpy(row.data(), top, rowBytes);
+        memcpy(top, bottom, rowBytes);
+        memcpy(bottom, row.data(), rowBytes);
+    }
+    return image;
+}
+
+void writeReport(const std::string &path, const GoldenOptions &options, const std::vector<PathResult> &results,
+                 bool passed) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "backend", options.backend.c_str());
+    cJSON_AddNumberToObject(root, "width", options.width);
+    cJSON_AddNumberToObject(root, "height", options.height);
+    cJSON_AddBoolToObject(root, "record", options.record);
+    cJSON_AddNumberToObject(root, "threshold", rounded(options.diff.threshold));
+    cJSON_AddNumberToObject(root, "maxBadRatio", rounded(options.diff.maxBadRatio, 1e6));
+    cJSON_AddBoolToObject(root, "passed", passed);
+    cJSON *paths = cJSON_AddArrayToObject(root, "paths");
+    for (const PathResult &result: results) {
+        cJSON *pathJson = cJSON_CreateObject();
+        cJSON_AddStringToObject(pathJson, "name", result.name.c_str());
+        cJSON_AddNumberToObject(pathJson, "loadMs", rounded(result.loadMs));
+        cJSON *cpu = cJSON_AddObjectToObject(pathJson, "cpuMs");
+        cJSON_AddNumberToObject(cpu, "avg", rounded(result.cpuSummary.avgMs));
+        cJSON_AddNumberToObject(cpu, "min", rounded(result.cpuSummary.minMs));
+        cJSON_AddNumberToObject(cpu, "p50", rounded(result.cpuSummary.p50Ms));
+        cJSON_AddNumberToObject(cpu, "p95", rounded(result.cpuSummary.p95Ms));
+        cJSON_AddNumberToObject(cpu, "p99", rounded(result.cpuSummary.p99Ms));
+        cJSON_AddNumberToObject(cpu, "max", rounded(result.cpuSummary.maxMs));
+        cJSON *frames = cJSON_AddArrayToObject(pathJson, "frames");
+        for (const FrameResult &frame: result.frames) {
+            cJSON *frameJson = cJSON_CreateObject();
+            cJSON_AddNumberToObject(frameJson, "frame", frame.frame);
+            cJSON_AddNumberToObject(frameJson, "frameMs", rounded(frame.frameMs));
+            cJSON_AddNumberToObject(frameJson, "cpuMs", rounded(frame.cpuMs));
+            if (frame.captured) {
+                cJSON_AddStringToObject(frameJson, "status", frame.status);
+            }
+            if (frame.captured && (strcmp(frame.status, "pass") == 0 || strcmp(frame.status, "fail") == 0)) {
+                cJSON_AddNumberToObject(frameJson, "diffPixels", frame.diff.diffPixels);
+                cJSON_AddNumberToObject(frameJson, "badPixels", frame.diff.badPixels);
+                cJSON_AddNumberToObject(frameJson, "badRatio", rounded(frame.diff.badRatio, 1e6));
+                cJSON_AddNumberToObject(frameJson, "maxDelta", rounded(frame.diff.maxDelta));
+                if (std::isinf(frame.diff.psnr)) { // 完全相同，JSON里没有Infinity
+                    cJSON_AddNullToObject(frameJson, "psnr");
+                } else {
+                    cJSON_AddNumberToObject(frameJson, "psnr", rounded(frame.diff.psnr));
+                }
+            }
+            cJSON_AddItemToArray(frames, frameJson);
+        }
+        cJSON_AddItemToArray(paths, pathJson);
+    }
+
+    char *json = cJSON_Print(root);
+    cJSON_Delete(root);
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == NULL) {
+        app_log("golden: can not write %s: %s\n", path.c_str(), strerror(errno));
+    } else {
+        fputs(json, file);
+        fclose(file);
+    }
+    free(json);
+}
+
+} // namespace
+
+const std::vector<CameraPath> &GoldenRunner::defaultPaths() {
+    static const std::vector<CameraPath> paths = {
+            // 场景的初始状态和单指向前走。每条路径都重新创建场景，第0帧只比较一次
+            {"walk", std::vector<CameraStep>(30, {0.0f, -0.02f, 0.0f, 1}), {0, 15, 30}},
+            // 双指横向拖动，原地转向塔
+            {"turn", std::vector<CameraStep>(24, {0.05f, 0.0f, 0.1f, 2}), {12, 24}},
+            // 斜着走向老房子和月亮，角色随地面倾斜
+            {"climb", std::vector<CameraStep>(20, {0.03f, -0.01f, 0.0f, 1}), {10, 20}},
+    };
+    return paths;
+}
+
+bool GoldenRunner::run(std::vector<std::shared_ptr<Shape>> &shapes, const GoldenHooks &hooks,
+                       const GoldenOptions &options, const std::vector<CameraPath> &paths) {
+    if (!makeDir(options.outputDir)) {
+        return false;
+    }
+    std::string recordDir = options.outputDir + "/" + options.backend;
+    if (options.record && !makeDir(recordDir)) {
+        return false;
+    }
+    size_t pixelBytes = (size_t)options.width * options.height * 4;
+    std::vector<uint8_t> pixels(pixelBytes);
+    std::vector<uint8_t> diffPixels(pixelBytes);
+    std::vector<PathResult> results;
+    bool passed = true;
+    DirectoryAssetProvider goldens(options.goldenDir);
+
+    for (const CameraPath &path: paths) {
+        PathResult result;
+        result.name = path.name;
+        long loadStartUS = Utils::getCurrTimeUS();
+        hooks.resetScene();
+        result.loadMs = (Utils::getCurrTimeUS() - loadStartUS) / 1000.0f;
+
+        FrameStats cpuStats;
+        int frameCount = (int)path.steps.size() + 1;
+        for (int frame = 0; frame < frameCount; frame++) {
+            if (frame > 0 && path.steps[frame - 1].fingers > 0) {
+                const CameraStep &step = path.steps[frame - 1];
+                DemoScene::drag(shapes, step.transX, step.transY, step.rotateYradian, step.fingers);
+            }
+            long startUS = Utils::getCurrTimeUS();
+            long cpuStartUS = getCpuTimeUS();
+            hooks.drawFrame();
+            long cpuUS = getCpuTimeUS() - cpuStartUS;
+            FrameResult frameResult = {frame, (Utils::getCurrTimeUS() - startUS) / 1000.0f, cpuUS / 1000.0f,
+                                       false, "", {0, 0, 0.0f, 0.0f, INFINITY, true}};
+            cpuStats.add(cpuUS);
+
+            frameResult.captured = std::find(path.captureFrames.begin(), path.captureFrames.end(), frame) !=
+                                   path.captureFrames.end();
+            if (!frameResult.captured) {
+                result.frames.push_back(frameResult);
+                continue;
+            }
+            hooks.readPixels(pixels.data());
+            char fileName[128];
+            snprintf(fileName, sizeof(fileName), "%s_%d", path.name.c_str(), frame);
+
+            if (options.record) {
+                std::string file = recordDir + "/" + fileName + ".png";
+                bool written = TextureUtils::encodePNG(file.c_str(), pixels.data(), options.width, options.height);
+                frameResult.status = written ? "recorded" : "write_failed";
+                passed = passed && written;
+                result.frames.push_back(frameResult);
+                continue;
+            }
+
+            uint32_t goldenW = 0;
+            uint32_t goldenH = 0;
+            uint8_t *golden = loadGolden(goldens, std::string(fileName) + ".png", &goldenW, &goldenH);
+            if (golden == nullptr) {
+                frameResult.status = "missing";
+            } else if (goldenW != options.width || goldenH != options.height) {
+                frameResult.status = "size_mismatch";
+            } else {
+                frameResult.diff = ImageDiff::compare(golden, pixels.data(), options.width, options.height,
+                                                      options.diff, diffPixels.data());
+                frameResult.status = frameResult.diff.passed ? "pass" : "fail";
+            }
+            free(golden);
+
+            if (strcmp(frameResult.status, "pass") != 0) {
+                passed = false;
+                std::string prefix = options.outputDir + "/" + fileName;
+                TextureUtils::encodePNG((prefix + "_actual.png").c_str(), pixels.data(), options.width,
+                                        options.height);
+                if (strcmp(frameResult.status, "fail") == 0) {
+                    TextureUtils::encodePNG((prefix + "_diff.png").c_str(), diffPixels.data(), options.width,
+                                            options.height);
+                }
+                app_log("golden: %s %s, bad pixels: %u(%.3f%%), max delta: %.3f\n", fileName, frameResult.status,
+                        frameResult.diff.badPixels, frameResult.diff.badRatio * 100.0f, frameResult.diff.maxDelta);
+            }
+            result.frames.push_back(frameResult);
+        }
+        result.cpuSummary = cpuStats.summarize();
+        app_log("golden: path %s, load: %.1fms, cpu avg: %.2fms, p99: %.2fms\n", path.name.c_str(), result.loadMs,
+                result.cpuSummary.avgMs, result.cpuSummary.p99Ms);
+        results.push_back(result);
+    }
+
+    std::string reportPath = options.outputDir + "/golden_report.json";
+    writeReport(reportPath, options, results, passed);
+    app_log("golden: %s, report: %s\n", passed ? "passed" : "FAILED", reportPath.c_str());
+    return passed;
+}
@@ -0,0 +1,56 @@
+#ifndef NATIVEACTIVITYDEMO_GOLDENRUNNER_H
+#define NATIVEACTIVITYDEMO_GOLDENRUNNER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ImageDiff.h"
+#include "../view/Shape.h"
+
+// 一帧的相机操作，参数和DemoScene::drag相同。fingers为0时这一帧不动
+struct CameraStep {
+    float transX;
+    float transY;
+    float rotateYradian;
+    int fingers;
+};
+
+// 固定的相机路径，第0帧是场景的初始状态，第i帧在第i-1步之后
+struct CameraPath {
+    std::string name;
+    std::vector<CameraStep> steps;
+    std::vector<int> captureFrames; // 和golden比较的帧
+};
+
+// 由调用者提供的渲染环境，GoldenRunner只负责驱动相机、计时和比较
+struct GoldenHooks {
+    std::function<void()> resetScene; // 重新创建场景，返回时资源已经全部加载
+    std::function<void()> drawFrame; // 画一帧，返回时这一帧已经完成，可以读取
+    std::function<void(void *rgba)> readPixels; // RGBA8，从上到下按行排列
+};
+
+struct GoldenOptions {
+    std::string backend; // golden按渲染后端分开存放
+    uint32_t width;
+    uint32_t height;
+    std::string goldenDir; // 文件系统路径，golden的文件名是<path>_<frame>.png。golden不打包进apk
+    std::string outputDir; // 文件系统路径，写入报告、失败时的实际输出和差异图
+    bool record; // 不比较，把所有采样帧写到outputDir/<backend>/，用来更新golden
+    ImageDiffOptions diff;
+};
+
+/**
+ * golden image回归测试：沿着固定的相机路径渲染DemoScene，按帧和goldenDir里的golden比较，
+ * 把每帧的CPU时间和比较结果写到outputDir/golden_report.json。没有通过的帧另存实际输出和差异图。
+ */
+class GoldenRunner {
+public:
+    static const std::vector<CameraPath> &defaultPaths();
+
+    // 全部通过（record时全部写入成功）返回true
+    static bool run(std::vector<std::shared_ptr<Shape>> &shapes, const GoldenHooks &hooks,
+                    const GoldenOptions &options, const std::vector<CameraPath> &paths = defaultPaths());
+};
+
+#endif //NATIVEACTIVITYDEMO_GOLDENRUNNER_H
@@ -0,0 +1,84 @@
+#include "ImageDiff.h"
+#include <algorithm>
+#include <cmath>
+
+static const float MAX_YIQ_DELTA = 35215.0f; // 黑和白的距离
+
+// 两个像素在YIQ空间的加权距离的平方
+static float yiqDelta(const uint8_t *a, const uint8_t *b) {
+    float dr = (float)a[0] - b[0];
+    float dg = (float)a[1] - b[1];
+    float db = (float)a[2] - b[2];
+    float y = dr * 0.29889531f + dg * 0.58662247f + db * 0.11448223f;
+    float i = dr * 0.59597799f - dg * 0.27417610f - db * 0.32180189f;
+    float q = dr * 0.21147017f - dg * 0.52261711f + db * 0.31114694f;
+    return 0.5053f * y * y + 0.299f * i * i + 0.1957f * q * q;
+}
+
+static bool matchesNeighborhood(const uint8_t *expected, const uint8_t *actualPixel, uint32_t w, uint32_t h,
+                                uint32_t x, uint32_t y, int radius, float maxDelta) {
+    int32_t x0 = std::max((int32_t)x - radius, 0);
+    int32_t x1 = std::min((int32_t)x + radius, (int32_t)w - 1);
+    int32_t y0 = std::max((int32_t)y - radius, 0);
+    int32_t y1 = std::min((int32_t)y + radius, (int32_t)h - 1);
+    for (int32_t ny = y0; ny <= y1; ny++) {
+        for (int32_t nx = x0; nx <= x1; nx++) {
+            if (yiqDelta(expected + ((size_t)ny * w + nx) * 4, actualPixel) <= maxDelta) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+ImageDiffResult ImageDiff::compare(const uint8_t *expected, const uint8_t *actual, uint32_t w, uint32_t h,
+                                   const ImageDiffOptions &options, uint8_t *diffRgba) {
+    ImageDiffResult result = {0, 0, 0.0f, 0.0f, INFINITY, true};
+    float maxDelta = MAX_YIQ_DELTA * options.threshold * options.threshold;
+    float largestDelta = 0.0f;
+    double squaredError = 0.0;
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            size_t offset = ((size_t)y * w + x) * 4;
+            const uint8_t *e = expected + offset;
+            const uint8_t *a = actual + offset;
+            for (int c = 0; c < 3; c++) {
+                double d = (double)e[c] - a[c];
+                squaredError += d * d;
+            }
+            float delta = yiqDelta(e, a);
+            largestDelta = std::max(largestDelta, delta);
+            uint8_t *out = diffRgba ? diffRgba + offset : nullptr;
+            if (delta <= maxDelta) {
+                if (out) { // 灰度，向白色淡化
+                    float luma = e[0] * 0.29889531f + e[1] * 0.58662247f + e[2] * 0.11448223f;
+                    uint8_t gray = (uint8_t)(255.0f + (luma - 255.0f) * 0.1f);
+                    out[0] = out[1] = out[2] = gray;
+                    out[3] = 255;
+                }
+                continue;
+            }
+            result.diffPixels++;
+            bool matched = options.searchRadius > 0 &&
+                           matchesNeighborhood(expected, a, w, h, x, y, options.searchRadius, maxDelta);
+            if (!matched) {
+                result.badPixels++;
+            }
+            if (out) {
+                out[0] = 255;
+                out[1] = matched ? 255 : 0;
+                out[2] = 0;
+                out[3] = 255;
+            }
+        }
+    }
+    size_t pixelCount = (size_t)w * h;
+    result.badRatio = pixelCount > 0 ? (float)result.badPixels / pixelCount : 0.0f;
+    result.maxDelta = std::sqrt(largestDelta / MAX_YIQ_DELTA);
+    if (squaredError > 0.0) {
+        double mse = squaredError / (pixelCount * 3.0);
+        result.psnr = (float)(10.0 * std::log10(255.0 * 255.0 / mse));
+    }
+    result.passed = result.badRatio <= options.maxBadRatio;
+    return result;
+}
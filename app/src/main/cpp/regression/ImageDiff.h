@@ -0,0 +1,35 @@
+#ifndef NATIVEACTIVITYDEMO_IMAGEDIFF_H
+#define NATIVEACTIVITYDEMO_IMAGEDIFF_H
+
+#include <cstdint>
+
+struct ImageDiffOptions {
+    // YIQ色差的阈值，0到1，超过的像素算不同。0.1大约是人眼刚能分辨的差异
+    float threshold = 0.1f;
+    // 不同的像素允许在golden的这个邻域内找到匹配，容忍光栅化边缘一个像素的偏移
+    int searchRadius = 1;
+    // 邻域里也找不到匹配的像素超过这个比例时不通过
+    float maxBadRatio = 0.002f;
+};
+
+struct ImageDiffResult {
+    uint32_t diffPixels; // 色差超过阈值的像素
+    uint32_t badPixels; // 其中邻域里也找不到匹配的
+    float badRatio;
+    float maxDelta; // 最大色差，和threshold同一个尺度
+    float psnr; // 整张图RGB的PSNR，完全相同时为INFINITY
+    bool passed;
+};
+
+/**
+ * 用感知色差比较渲染结果和golden image：按YIQ空间的加权距离判断单个像素是否不同（和pixelmatch相同的公式），
+ * 再用邻域匹配排除抗锯齿、边缘偏移造成的差异。图片都是RGBA8，从上到下按行排列，不比较alpha。
+ */
+class ImageDiff {
+public:
+    // diffRgba不为nullptr时写入差异图：淡化的golden灰度图上，邻域里找到匹配的像素标黄，没有找到的标红
+    static ImageDiffResult compare(const uint8_t *expected, const uint8_t *actual, uint32_t w, uint32_t h,
+                                   const ImageDiffOptions &options, uint8_t *diffRgba = nullptr);
+};
+
+#endif //NATIVEACTIVITYDEMO_IMAGEDIFF_H
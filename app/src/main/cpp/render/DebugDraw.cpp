@@ -0,0 +1,106 @@
+#include "DebugDraw.h"
+#include "../shader/BaseShader.h"
+#include "../gles/GLStateCache.h"
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+void packColor(const GLfloat color[4], GLubyte outColor[4]) {
+    for (int i = 0; i < 4; i++) {
+        GLfloat c = color[i] < 0.0f ? 0.0f : (color[i] > 1.0f ? 1.0f : color[i]);
+        outColor[i] = (GLubyte)(c * 255.0f + 0.5f);
+    }
+}
+
+} // namespace
+
+DebugDraw::~DebugDraw() {
+    release();
+}
+
+void DebugDraw::addVertex(const GLfloat position[4], const GLubyte color[4]) {
+    vertices.emplace_back();
+    Vertex &vertex = vertices.back();
+    memcpy(vertex.position, position, sizeof(vertex.position));
+    memcpy(vertex.color, color, sizeof(vertex.color));
+}
+
+void DebugDraw::addLine(const GLfloat from[4], const GLfloat to[4], const GLfloat color[4]) {
+    if (!enabled) return;
+    GLubyte packed[4];
+    packColor(color, packed);
+    addVertex(from, packed);
+    addVertex(to, packed);
+}
+
+void DebugDraw::addLineLoop(const GLfloat *points, int count, const GLfloat color[4]) {
+    if (!enabled || count < 2) return;
+    GLubyte packed[4];
+    packColor(color, packed);
+    for (int i = 0; i < count; i++) {
+        addVertex(points + i * 4, packed);
+        addVertex(points + (i + 1) % count * 4, packed);
+    }
+}
+
+void DebugDraw::addBox(const glm::mat4 &transform, const GLfloat *corners, const GLfloat color[4]) {
+    if (!enabled) return;
+    static const int edges[12][2] = {
+            {0, 1}, {1, 2}, {2, 3}, {3, 0}, // 上
+            {4, 5}, {5, 6}, {6, 7}, {7, 4}, // 下
+            {0, 4}, {1, 5}, {2, 6}, {3, 7}  // 竖边
+    };
+    glm::vec4 transformed[8];
+    for (int i = 0; i < 8; i++) {
+        transformed[i] = transform * glm::vec4(corners[i * 3], corners[i * 3 + 1], corners[i * 3 + 2], 1.0f);
+    }
+    GLubyte packed[4];
+    packColor(color, packed);
+    for (auto &edge: edges) {
+        addVertex(&transformed[edge[0]][0], packed);
+        addVertex(&transformed[edge[1]][0], packed);
+    }
+}
+
+GLsizei DebugDraw::upload() {
+    if (vertices.empty()) {
+        return 0;
+    }
+    if (vao == 0) {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        GLStateCache::bindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void *)offsetof(Vertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(BaseShader::VERTEX_COLOR_LOCATION, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex),
+                              (const void *)offsetof(Vertex, color));
+        glEnableVertexAttribArray(BaseShader::VERTEX_COLOR_LOCATION);
+        GLStateCache::bindVertexArray(0);
+    }
+    size_t bytes = vertices.size() * sizeof(Vertex);
+    if (bytes > capacityBytes) {
+        capacityBytes = bytes > capacityBytes * 2 ? bytes : capacityBytes * 2;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    // 每帧重新分配（orphan），上一帧的数据GPU可能还在用，驱动会给一块新的存储，不需要等待
+    glBufferData(GL_ARRAY_BUFFER, capacityBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    GLsizei count = (GLsizei)vertices.size();
+    vertices.clear();
+    return count;
+}
+
+void DebugDraw::release() {
+    vertices.clear();
+    if (vao != 0) {
+        GLStateCache::deleteVertexArrays(1, &vao);
+        GLStateCache::deleteBuffers(1, &vbo);
+        vao = 0;
+        vbo = 0;
+    }
+    capacityBytes = 0;
+}
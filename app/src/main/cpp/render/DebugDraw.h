@@ -0,0 +1,53 @@
+#ifndef NATIVEACTIVITYDEMO_DEBUGDRAW_H
+#define NATIVEACTIVITYDEMO_DEBUGDRAW_H
+
+#include <GLES3/gl32.h>
+#include <cstdint>
+#include <vector>
+#include "../utils/libglm0_9_6_3/glm/glm.hpp"
+
+/**
+ * 调试用的线框，比如模型的包围盒。一帧内所有的线段先收集在cpu侧，由RenderQueue::flush一次上传到流式VBO，
+ * 用一个GL_LINES的DrawPacket画完，开销和线框的数量基本无关。关闭后add*直接返回。
+ * 顶点都是裁剪坐标（带w分量），3D的线框在add时用cpu变换。
+ */
+class DebugDraw {
+public:
+    ~DebugDraw();
+
+    void setEnabled(bool enabled_) { enabled = enabled_; }
+    bool isEnabled() const { return enabled; }
+    void setLineWidth(GLfloat width) { lineWidth = width; }
+    GLfloat getLineWidth() const { return lineWidth; }
+
+    // color是RGBA，0-1
+    void addLine(const GLfloat from[4], const GLfloat to[4], const GLfloat color[4]);
+    // points是count个vec4，首尾相连
+    void addLineLoop(const GLfloat *points, int count, const GLfloat color[4]);
+    // corners是8个顶点的xyz，顺序和Shape::initWrapBox一致：0-3是上面，4-7是下面，i和i+4上下对应
+    void addBox(const glm::mat4 &transform, const GLfloat *corners, const GLfloat color[4]);
+
+    // 上传本帧收集的顶点并清空，返回顶点数，0表示不需要绘制
+    GLsizei upload();
+    GLuint getVao() const { return vao; }
+
+    // context销毁前调用
+    void release();
+
+private:
+    struct Vertex {
+        GLfloat position[4];
+        GLubyte color[4]; // 归一化的RGBA
+    };
+
+    std::vector<Vertex> vertices;
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    size_t capacityBytes = 0;
+    bool enabled = true;
+    GLfloat lineWidth = 5.0f;
+
+    void addVertex(const GLfloat position[4], const GLubyte color[4]);
+};
+
+#endif //NATIVEACTIVITYDEMO_DEBUGDRAW_H
@@ -0,0 +1,3 @@
+#include "RenderBackend.h"
+
+RenderBackendType RenderBackend::current = RENDER_BACKEND_GLES;
@@ -0,0 +1,23 @@
+#ifndef NATIVEACTIVITYDEMO_RENDERBACKEND_H
+#define NATIVEACTIVITYDEMO_RENDERBACKEND_H
+
+enum RenderBackendType {
+    RENDER_BACKEND_GLES, // Shape::submit生成DrawPacket，由RenderQueue交给GL
+    RENDER_BACKEND_SOFT  // Shape::submitSoft交给SoftRasterizer，整个过程不调用GL
+};
+
+/**
+ * 当前使用的渲染后端，在创建场景之前设置。软件光栅化时Shape的子类不创建GL对象，
+ * 资源通过ResourceCache同步加载cpu侧的数据。
+ */
+class RenderBackend {
+public:
+    static void set(RenderBackendType type) { current = type; }
+    static RenderBackendType get() { return current; }
+    static bool isSoft() { return current == RENDER_BACKEND_SOFT; }
+
+private:
+    static RenderBackendType current;
+};
+
+#endif //NATIVEACTIVITYDEMO_RENDERBACKEND_H
@@ -0,0 +1,180 @@
+#include "RenderQueue.h"
+#include "../gles/GLStateCache.h"
+#include "../profiler/GpuTimer.h"
+#include "../profiler/Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include "../utils/libglm0_9_6_3/glm/glm.hpp"
+
+static const uint32_t DEPTH_BITS = 23;
+static const uint32_t DEPTH_MAX = (1u << DEPTH_BITS) - 1;
+
+static uint64_t quantizeDepth(GLfloat depth) {
+    if (depth < 0.0f) depth = 0.0f;
+    if (depth > 1.0f) depth = 1.0f;
+    return (uint64_t)(depth * DEPTH_MAX);
+}
+
+uint64_t RenderQueue::makeSortKey(const DrawPacket &packet) {
+    uint64_t depth = quantizeDepth(packet.depth);
+    uint64_t program = packet.program & 0xffu;
+    uint64_t texture = packet.texture & 0xffffu;
+    uint64_t vao = packet.vao & 0xffffu;
+    if (packet.blend == BLEND_OPAQUE) {
+        // 状态优先，相同状态内从前往后，利用early-z减少overdraw
+        return (program << 55) | (texture << 39) | (vao << 23) | depth;
+    }
+    // 半透明必须从后往前，状态只能在深度相同时再合并
+    return (1ull << 63) | ((DEPTH_MAX - depth) << 40) | (program << 32) | (texture << 16) | vao;
+}
+
+uint32_t RenderQueue::countStateChanges(const DrawPacket *prev, const DrawPacket &curr) {
+    if (prev == nullptr) {
+        return 5; // 第一次绘制，所有状态都要设置
+    }
+    // 变换矩阵和颜色因子在各自的ObjectBlock里，不算状态切换
+    uint32_t changes = 0;
+    if (prev->program != curr.program) changes++;
+    if (prev->texture != curr.texture) changes++;
+    if (prev->vao != curr.vao) changes++;
+    if (prev->blend != curr.blend) changes++;
+    if (prev->lineWidth != curr.lineWidth) changes++;
+    return changes;
+}
+
+void RenderQueue::clear() {
+    packets.clear();
+    sortedKeys.clear();
+}
+
+void RenderQueue::release() {
+    clear();
+    uniformRing.release();
+    debugDraw.release();
+}
+
+void RenderQueue::setLight(const GLfloat position[3], const GLfloat color[3]) {
+    memcpy(frameBlock.lightPosition, position, sizeof(GLfloat) * 3);
+    memcpy(frameBlock.lightColor, color, sizeof(GLfloat) * 3);
+}
+
+void RenderQueue::submit(const DrawPacket &packet) {
+    packets.push_back(packet);
+    packets.back().sortKey = makeSortKey(packet);
+}
+
+void RenderQueue::flush() {
+    PROFILE_ZONE("render queue");
+    GLsizei debugVertices = debugDraw.upload();
+    if (debugVertices > 0) {
+        DrawPacket packet;
+        packet.program = BaseShader::getProgram(SHADER_ALPHA | SHADER_VERTEX_COLOR); // 顶点已经是裁剪坐标
+        packet.vao = debugDraw.getVao();
+        packet.mode = GL_LINES;
+        packet.count = debugVertices;
+        packet.lineWidth = debugDraw.getLineWidth();
+        packet.blend = BLEND_ALPHA;
+        packet.depth = 0.0f; // 半透明里最后画
+        submit(packet);
+    }
+
+    stats.packets = (uint32_t)packets.size();
+    stats.stateChangesUnsorted = 0;
+    stats.stateChangesSorted = 0;
+
+    const DrawPacket *prev = nullptr;
+    for (const DrawPacket &packet: packets) {
+        stats.stateChangesUnsorted += countStateChanges(prev, packet);
+        prev = &packet;
+    }
+
+    sortedKeys.clear();
+    for (uint32_t i = 0; i < packets.size(); i++) {
+        sortedKeys.emplace_back(packets[i].sortKey, i);
+    }
+    std::sort(sortedKeys.begin(), sortedKeys.end()); // key相同时按提交顺序
+
+    // 先把本帧所有的uniform数据写进ring buffer，unmap之后才能绘制
+    static const glm::mat4 identity(1.0f);
+    size_t blockSize = sizeof(ObjectBlock) > sizeof(FrameBlock) ? sizeof(ObjectBlock) : sizeof(FrameBlock);
+    size_t slotSize = (blockSize + UniformRing::MAX_ALIGNMENT - 1) / UniformRing::MAX_ALIGNMENT * UniformRing::MAX_ALIGNMENT;
+    uniformRing.beginFrame(slotSize * (packets.size() + 1));
+
+    GLintptr frameOffset = 0;
+    auto frame = (FrameBlock *)uniformRing.allocate(sizeof(FrameBlock), &frameOffset);
+    if (frame != nullptr) {
+        memcpy(frame, &frameBlock, sizeof(FrameBlock));
+    }
+    objectOffsets.clear();
+    for (const auto &entry: sortedKeys) {
+        const DrawPacket &packet = packets[entry.second];
+        GLintptr offset = -1;
+        auto object = (ObjectBlock *)uniformRing.allocate(sizeof(ObjectBlock), &offset);
+        if (object != nullptr) {
+            const GLfloat *mat4 = packet.transformMat4 != nullptr ? packet.transformMat4 : &identity[0][0];
+            memcpy(object->transformMat4, mat4, sizeof(object->transformMat4));
+            memcpy(object->modelColorFactor, packet.colorFactor, sizeof(object->modelColorFactor));
+            memcpy(object->uvRect, packet.uvRect, sizeof(object->uvRect));
+        }
+        objectOffsets.push_back(offset);
+    }
+    uniformRing.unmap();
+
+    GLuint ubo = uniformRing.getBuffer();
+    GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, BaseShader::FRAME_BLOCK_BINDING, ubo,
+                                  frameOffset, sizeof(FrameBlock));
+
+    // 重复的状态设置由GLStateCache过滤。不透明的排在前面，GPU时间按不透明和半透明两个pass统计
+    prev = nullptr;
+    bool gpuPass = GpuTimer::begin("opaque");
+    bool blendedPass = false;
+    for (size_t i = 0; i < sortedKeys.size(); i++) {
+        const DrawPacket &packet = packets[sortedKeys[i].second];
+        if (objectOffsets[i] < 0) {
+            continue; // ring buffer分配失败，跳过
+        }
+        if (packet.blend != BLEND_OPAQUE && !blendedPass) {
+            blendedPass = true;
+            if (gpuPass) {
+                GpuTimer::end();
+            }
+            gpuPass = GpuTimer::begin("transparent");
+        }
+        stats.stateChangesSorted += countStateChanges(prev, packet);
+
+        GLStateCache::useProgram(packet.program);
+        if (packet.blend == BLEND_OPAQUE) {
+            GLStateCache::disable(GL_BLEND);
+        } else {
+            GLStateCache::enable(GL_BLEND);
+        }
+        GLStateCache::activeTexture(GL_TEXTURE0);
+        GLStateCache::bindTexture(GL_TEXTURE_2D, packet.texture);
+        GLStateCache::bindVertexArray(packet.vao);
+        if (packet.mode == GL_LINES || packet.mode == GL_LINE_STRIP || packet.mode == GL_LINE_LOOP) {
+            GLStateCache::lineWidth(packet.lineWidth);
+        }
+        GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, BaseShader::OBJECT_BLOCK_BINDING, ubo,
+                                      objectOffsets[i], sizeof(ObjectBlock));
+
+        if (packet.instanceCount != 1) {
+            if (packet.indexType == 0) {
+                glDrawArraysInstanced(packet.mode, packet.first, packet.count, packet.instanceCount);
+            } else {
+                glDrawElementsInstanced(packet.mode, packet.count, packet.indexType,
+                                        (const void *)(uintptr_t)packet.first, packet.instanceCount);
+            }
+        } else if (packet.indexType == 0) {
+            glDrawArrays(packet.mode, packet.first, packet.count);
+        } else {
+            glDrawElements(packet.mode, packet.count, packet.indexType, (const void *)(uintptr_t)packet.first);
+        }
+        prev = &packet;
+    }
+    if (gpuPass) {
+        GpuTimer::end();
+    }
+    uniformRing.endFrame();
+
+    packets.clear();
+}
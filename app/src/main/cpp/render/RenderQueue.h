@@ -0,0 +1,85 @@
+#ifndef NATIVEACTIVITYDEMO_RENDERQUEUE_H
+#define NATIVEACTIVITYDEMO_RENDERQUEUE_H
+
+#include <GLES3/gl32.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "UniformRing.h"
+#include "DebugDraw.h"
+#include "../shader/BaseShader.h"
+#include "../texture/Texture.h"
+
+enum BlendMode : uint8_t {
+    BLEND_OPAQUE = 0, // 不透明，关闭blend，从前往后画
+    BLEND_ALPHA = 1   // 半透明，开启blend，从后往前画
+};
+
+// 一次绘制调用所需的全部状态，由Shape::submit生成，帧末统一排序后再提交给GL。
+// transformMat4、colorFactor和uvRect在flush时写入ObjectBlock。
+struct DrawPacket {
+    uint64_t sortKey = 0;
+    const GLfloat *transformMat4 = nullptr; // 指向Shape的modelMat4，只在当前帧内有效
+    GLuint program = 0; // BaseShader::getProgram按特性组合得到的program
+    GLuint texture = 0;
+    GLuint vao = 0;
+    GLenum mode = GL_TRIANGLES;
+    GLsizei count = 0;
+    GLenum indexType = 0; // 0表示使用glDrawArrays
+    GLuint first = 0; // glDrawArrays的起始顶点，或者glDrawElements的索引字节偏移
+    GLsizei instanceCount = 1; // 大于1时使用实例化绘制，每个实例的矩阵在vao的实例属性中
+    GLfloat depth = 0.0f; // 归一化的相机距离，0-1，越小离相机越近
+    GLfloat colorFactor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    GLfloat uvRect[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    GLfloat lineWidth = 1.0f;
+    BlendMode blend = BLEND_OPAQUE;
+
+    // 纹理对象和它在图集中的区域，图集里的纹理共用同一个id，排序后可以连续绘制
+    void setTexture(const Texture &tex) {
+        texture = tex.id;
+        memcpy(uvRect, tex.uvRect, sizeof(uvRect));
+    }
+};
+
+struct RenderQueueStats {
+    uint32_t packets;
+    uint32_t stateChangesUnsorted; // 按提交顺序直接绘制时需要的状态切换次数
+    uint32_t stateChangesSorted; // 排序后实际发生的状态切换次数
+};
+
+/**
+ * 每帧收集所有Shape的DrawPacket，按64位的key排序后统一绘制，尽量减少GL状态切换。
+ * key的布局：
+ * 不透明：[63]0 | [55-62]program | [39-54]texture | [23-38]vao | [0-22]depth（从前往后）
+ * 半透明：[63]1 | [40-62]反转的depth（从后往前） | [32-39]program | [16-31]texture | [0-15]vao
+ * 每个packet的uniform数据写入UniformRing中的一个ObjectBlock，绘制前只需glBindBufferRange。
+ */
+class RenderQueue {
+public:
+    void clear();
+    void submit(const DrawPacket &packet);
+    void flush();
+    // context销毁前调用
+    void release();
+
+    void setLight(const GLfloat position[3], const GLfloat color[3]);
+
+    // 调试线框，flush时作为一个packet和其它packet一起排序绘制
+    DebugDraw &getDebugDraw() { return debugDraw; }
+
+    const RenderQueueStats &getStats() const { return stats; }
+
+    static uint64_t makeSortKey(const DrawPacket &packet);
+    static uint32_t countStateChanges(const DrawPacket *prev, const DrawPacket &curr);
+
+private:
+    std::vector<DrawPacket> packets;
+    std::vector<std::pair<uint64_t, uint32_t>> sortedKeys; // key和packets中的下标
+    std::vector<GLintptr> objectOffsets; // 按排序后的顺序，每个packet的ObjectBlock在ring中的偏移
+    UniformRing uniformRing;
+    DebugDraw debugDraw;
+    FrameBlock frameBlock = {{0.0f, 3.0f, -10.0f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}};
+    RenderQueueStats stats = {0, 0, 0};
+};
+
+#endif //NATIVEACTIVITYDEMO_RENDERQUEUE_H
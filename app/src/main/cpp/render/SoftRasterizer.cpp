@@ -0,0 +1,653 @@
+#include "SoftRasterizer.h"
+#include "../shader/BaseShader.h"
+#include "../profiler/Profiler.h"
+#include "../texture/MipmapGenerator.h"
+#include "../utils/Utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// x、y超出±GUARD_BAND * w的部分才在裁剪坐标里裁掉，viewport之外、guard band之内的交给光栅化时的包围盒。
+// 限制屏幕坐标的范围，边函数用float计算时精度足够
+const float GUARD_BAND = 4.0f;
+const float SUBPIXEL = 256.0f; // 顶点的屏幕坐标对齐到1/256像素
+const int MAX_CLIP_VERTICES = 8; // 三角形被5个平面裁剪后最多8个顶点
+const float SHININESS = 40.0f; // 和BaseShader的shininessFactor一致
+
+// 4个float一组的运算，覆盖和深度测试用。没有SIMD时逐个计算，结果相同
+#if defined(__SSE2__)
+typedef __m128 Float4;
+typedef __m128 Mask4;
+inline Float4 set4(float v) { return _mm_set1_ps(v); }
+inline Float4 set4(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+inline Float4 load4(const float *p) { return _mm_loadu_ps(p); }
+inline void store4(float *p, Float4 v) { _mm_storeu_ps(p, v); }
+inline Float4 add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 div4(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+inline Mask4 greater4(Float4 a, Float4 b) { return _mm_cmpgt_ps(a, b); }
+inline Mask4 greaterEqual4(Float4 a, Float4 b) { return _mm_cmpge_ps(a, b); }
+inline Mask4 less4(Float4 a, Float4 b) { return _mm_cmplt_ps(a, b); }
+inline Mask4 lessEqual4(Float4 a, Float4 b) { return _mm_cmple_ps(a, b); }
+inline Mask4 and4(Mask4 a, Mask4 b) { return _mm_and_ps(a, b); }
+inline int bits4(Mask4 m) { return _mm_movemask_ps(m); }
+#elif defined(__ARM_NEON)
+typedef float32x4_t Float4;
+typedef uint32x4_t Mask4;
+inline Float4 set4(float v) { return vdupq_n_f32(v); }
+inline Float4 set4(float a, float b, float c, float d) {
+    const float v[4] = {a, b, c, d};
+    return vld1q_f32(v);
+}
+inline Float4 load4(const float *p) { return vld1q_f32(p); }
+inline void store4(float *p, Float4 v) { vst1q_f32(p, v); }
+inline Float4 add4(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 sub4(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 mul4(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+#if defined(__aarch64__)
+inline Float4 div4(Float4 a, Float4 b) { return vdivq_f32(a, b); }
+#else
+inline Float4 div4(Float4 a, Float4 b) { // armv7的NEON没有除法
+    float va[4], vb[4];
+    vst1q_f32(va, a);
+    vst1q_f32(vb, b);
+    for (int i = 0; i < 4; i++) {
+        va[i] /= vb[i];
+    }
+    return vld1q_f32(va);
+}
+#endif
+inline Mask4 greater4(Float4 a, Float4 b) { return vcgtq_f32(a, b); }
+inline Mask4 greaterEqual4(Float4 a, Float4 b) { return vcgeq_f32(a, b); }
+inline Mask4 less4(Float4 a, Float4 b) { return vcltq_f32(a, b); }
+inline Mask4 lessEqual4(Float4 a, Float4 b) { return vcleq_f32(a, b); }
+inline Mask4 and4(Mask4 a, Mask4 b) { return vandq_u32(a, b); }
+inline int bits4(Mask4 m) {
+    return (int)((vgetq_lane_u32(m, 0) & 1) | (vgetq_lane_u32(m, 1) & 2) |
+                 (vgetq_lane_u32(m, 2) & 4) | (vgetq_lane_u32(m, 3) & 8));
+}
+#else
+struct Float4 {
+    float v[4];
+};
+typedef int Mask4; // 每一位对应一个lane
+inline Float4 set4(float v) { return Float4{{v, v, v, v}}; }
+inline Float4 set4(float a, float b, float c, float d) { return Float4{{a, b, c, d}}; }
+inline Float4 load4(const float *p) { return Float4{{p[0], p[1], p[2], p[3]}}; }
+inline void store4(float *p, Float4 v) {
+    for (int i = 0; i < 4; i++) p[i] = v.v[i];
+}
+#define SOFT_FLOAT4_OP(name, expr) \
+    inline Float4 name(Float4 a, Float4 b) { \
+        Float4 r; \
+        for (int i = 0; i < 4; i++) r.v[i] = expr; \
+        return r; \
+    }
+#define SOFT_MASK4_OP(name, expr) \
+    inline Mask4 name(Float4 a, Float4 b) { \
+        Mask4 r = 0; \
+        for (int i = 0; i < 4; i++) r |= (expr) ? (1 << i) : 0; \
+        return r; \
+    }
+SOFT_FLOAT4_OP(add4, a.v[i] + b.v[i])
+SOFT_FLOAT4_OP(sub4, a.v[i] - b.v[i])
+SOFT_FLOAT4_OP(mul4, a.v[i] * b.v[i])
+SOFT_FLOAT4_OP(div4, a.v[i] / b.v[i])
+SOFT_MASK4_OP(greater4, a.v[i] > b.v[i])
+SOFT_MASK4_OP(greaterEqual4, a.v[i] >= b.v[i])
+SOFT_MASK4_OP(less4, a.v[i] < b.v[i])
+SOFT_MASK4_OP(lessEqual4, a.v[i] <= b.v[i])
+#undef SOFT_FLOAT4_OP
+#undef SOFT_MASK4_OP
+inline Mask4 and4(Mask4 a, Mask4 b) { return a & b; }
+inline int bits4(Mask4 m) { return m; }
+#endif
+
+inline float snap(float v) {
+    return std::floor(v * SUBPIXEL + 0.5f) / SUBPIXEL;
+}
+
+inline float clamp01(float v) {
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+// 内存里的字节顺序是R、G、B、A
+inline uint32_t packColor(const float color[4]) {
+    uint32_t r = (uint32_t)(clamp01(color[0]) * 255.0f + 0.5f);
+    uint32_t g = (uint32_t)(clamp01(color[1]) * 255.0f + 0.5f);
+    uint32_t b = (uint32_t)(clamp01(color[2]) * 255.0f + 0.5f);
+    uint32_t a = (uint32_t)(clamp01(color[3]) * 255.0f + 0.5f);
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+inline void normalize3(float v[3]) {
+    float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length > 0.0f) {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+}
+
+// 裁剪平面，返回值不小于0时在内侧
+inline float planeDistance(const float clip[4], int plane) {
+    switch (plane) {
+        case 0: return clip[2] + clip[3]; // 近裁剪面，z >= -w
+        case 1: return GUARD_BAND * clip[3] - clip[0];
+        case 2: return GUARD_BAND * clip[3] + clip[0];
+        case 3: return GUARD_BAND * clip[3] - clip[1];
+        default: return GUARD_BAND * clip[3] + clip[1];
+    }
+}
+const int CLIP_PLANES = 5;
+
+// 按GL_REPEAT取一个level上的双线性插值，结果是0-1
+void sampleBilinear(const uint8_t *texels, uint32_t w, uint32_t h, float u, float v, float out[4]) {
+    float x = (u - std::floor(u)) * w - 0.5f;
+    float y = (v - std::floor(v)) * h - 0.5f;
+    float fx = std::floor(x);
+    float fy = std::floor(y);
+    float ax = x - fx;
+    float ay = y - fy;
+    int32_t x0 = (int32_t)fx;
+    int32_t y0 = (int32_t)fy;
+    x0 = x0 < 0 ? x0 + (int32_t)w : (x0 >= (int32_t)w ? x0 - (int32_t)w : x0);
+    y0 = y0 < 0 ? y0 + (int32_t)h : (y0 >= (int32_t)h ? y0 - (int32_t)h : y0);
+    int32_t x1 = x0 + 1 < (int32_t)w ? x0 + 1 : 0;
+    int32_t y1 = y0 + 1 < (int32_t)h ? y0 + 1 : 0;
+    const uint8_t *p00 = texels + ((size_t)y0 * w + x0) * 4;
+    const uint8_t *p10 = texels + ((size_t)y0 * w + x1) * 4;
+    const uint8_t *p01 = texels + ((size_t)y1 * w + x0) * 4;
+    const uint8_t *p11 = texels + ((size_t)y1 * w + x1) * 4;
+    for (int c = 0; c < 4; c++) {
+        float bottom = p00[c] + (p10[c] - p00[c]) * ax;
+        float top = p01[c] + (p11[c] - p01[c]) * ax;
+        out[c] = (bottom + (top - bottom) * ay) * (1.0f / 255.0f);
+    }
+}
+
+// GL_LINEAR_MIPMAP_LINEAR，lod是log2(纹素/像素)
+void sampleTrilinear(const SoftTexture &texture, float u, float v, float lod, float out[4]) {
+    if (!(lod > 0.0f) || texture.levels <= 1) { // 放大或者lod是NaN
+        sampleBilinear(texture.pixels, texture.width, texture.height, u, v, out);
+        return;
+    }
+    lod = std::min(lod, (float)(texture.levels - 1));
+    int level = (int)lod;
+    float fraction = lod - level;
+    const uint8_t *texels = texture.pixels + MipmapGenerator::levelOffset(texture.width, texture.height, level);
+    sampleBilinear(texels, MipmapGenerator::levelSize(texture.width, level),
+                   MipmapGenerator::levelSize(texture.height, level), u, v, out);
+    if (fraction > 0.0f && level + 1 < texture.levels) {
+        float next[4];
+        texels = texture.pixels + MipmapGenerator::levelOffset(texture.width, texture.height, level + 1);
+        sampleBilinear(texels, MipmapGenerator::levelSize(texture.width, level + 1),
+                       MipmapGenerator::levelSize(texture.height, level + 1), u, v, next);
+        for (int c = 0; c < 4; c++) {
+            out[c] += (next[c] - out[c]) * fraction;
+        }
+    }
+}
+
+} // namespace
+
+SoftRasterizer::SoftRasterizer(unsigned int threadCount): threadCount(threadCount), nextTile(0), shadedPixels(0) {
+    if (threadCount > 0) {
+        pool.reset(new ThreadPool(threadCount));
+    }
+    memset(&stats, 0, sizeof(stats));
+    memset(&pendingStats, 0, sizeof(pendingStats));
+}
+
+void SoftRasterizer::setTarget(const SoftTarget &newTarget) {
+    target = newTarget;
+    depthStride = (target.width + 3) & ~3;
+    depth.resize((size_t)depthStride * target.height);
+    tilesX = (target.width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY = (target.height + TILE_SIZE - 1) / TILE_SIZE;
+    bins.resize((size_t)tilesX * tilesY);
+    if (viewport[2] == 0 || viewport[3] == 0) {
+        setViewport(0, 0, target.width, target.height); // 没有设置过时和GL一样，是整个surface
+    }
+}
+
+void SoftRasterizer::setViewport(int32_t x, int32_t y, int32_t width, int32_t height) {
+    viewport[0] = x;
+    viewport[1] = y;
+    viewport[2] = width;
+    viewport[3] = height;
+}
+
+void SoftRasterizer::setLight(const GLfloat position[3], const GLfloat color[3]) {
+    memcpy(lightPosition, position, sizeof(lightPosition));
+    memcpy(lightColor, color, sizeof(lightColor));
+}
+
+void SoftRasterizer::clear(const GLfloat color[4]) {
+    clearColor = packColor(color);
+    clearPending = true;
+}
+
+void SoftRasterizer::submit(const SoftDraw &draw) {
+    if (target.pixels == nullptr || draw.positions == nullptr || draw.indices == nullptr) {
+        return;
+    }
+    long startUS = Utils::getCurrTimeUS();
+    DrawState state;
+    state.texture = (draw.features & SHADER_TEXTURED) && draw.texture && draw.texture->pixels ? draw.texture : nullptr;
+    memcpy(state.colorFactor, draw.colorFactor, sizeof(state.colorFactor));
+    state.features = draw.features;
+    uint32_t drawIndex = (uint32_t)draws.size();
+    draws.push_back(state);
+    pendingStats.draws++;
+
+    // 和BaseShader的顶点shader一样：gl_Position = transformMat4 * vPosition，
+    // 法向量归一化后也乘上transformMat4，modelVertex取gl_Position的xyz
+    static const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    const float *m = (draw.features & SHADER_TRANSFORM) && draw.transformMat4 ? draw.transformMat4 : identity;
+    bool textured = (draw.features & SHADER_TEXTURED) && draw.texCoords != nullptr;
+    bool lit = (draw.features & SHADER_LIT) && draw.normals != nullptr;
+    vertices.resize(draw.vertexCount);
+    for (uint32_t i = 0; i < draw.vertexCount; i++) {
+        const float *p = draw.positions + i * 3;
+        Vertex &vertex = vertices[i];
+        for (int r = 0; r < 4; r++) {
+            vertex.clip[r] = m[r] * p[0] + m[4 + r] * p[1] + m[8 + r] * p[2] + m[12 + r];
+        }
+        memset(vertex.varyings, 0, sizeof(vertex.varyings));
+        if (textured) {
+            vertex.varyings[0] = draw.texCoords[i * 2];
+            vertex.varyings[1] = draw.texCoords[i * 2 + 1];
+        }
+        if (lit) {
+            float n[3] = {draw.normals[i * 3], draw.normals[i * 3 + 1], draw.normals[i * 3 + 2]};
+            normalize3(n);
+            for (int r = 0; r < 3; r++) {
+                vertex.varyings[2 + r] = m[r] * n[0] + m[4 + r] * n[1] + m[8 + r] * n[2];
+                vertex.varyings[5 + r] = vertex.clip[r];
+            }
+        }
+    }
+
+    for (uint32_t t = 0; t + 2 < draw.indexCount; t += 3) {
+        const GLushort *index = draw.indices + t;
+        if (index[0] >= draw.vertexCount || index[1] >= draw.vertexCount || index[2] >= draw.vertexCount) {
+            continue;
+        }
+        const Vertex *corners[3] = {&vertices[index[0]], &vertices[index[1]], &vertices[index[2]]};
+        pendingStats.triangles++;
+
+        // 三个顶点都在同一个平面外面的直接丢掉，包括远裁剪面和viewport的四边
+        uint32_t outside = 0x3F;
+        bool needClip = false;
+        for (const Vertex *vertex: corners) {
+            const float *c = vertex->clip;
+            uint32_t code = (c[0] > c[3] ? 1 : 0) | (c[0] < -c[3] ? 2 : 0) | (c[1] > c[3] ? 4 : 0) |
+                            (c[1] < -c[3] ? 8 : 0) | (c[2] > c[3] ? 16 : 0) | (c[2] < -c[3] ? 32 : 0);
+            outside &= code;
+            for (int plane = 0; plane < CLIP_PLANES; plane++) {
+                needClip = needClip || planeDistance(c, plane) < 0.0f;
+            }
+        }
+        if (outside != 0) {
+            continue;
+        }
+        if (!needClip) {
+            addTriangle(*corners[0], *corners[1], *corners[2], drawIndex);
+            continue;
+        }
+
+        // Sutherland-Hodgman，varying在裁剪坐标里是线性的，直接插值
+        pendingStats.clippedTriangles++;
+        Vertex polygons[2][MAX_CLIP_VERTICES];
+        int count = 3;
+        for (int i = 0; i < 3; i++) {
+            polygons[0][i] = *corners[i];
+        }
+        int src = 0;
+        for (int plane = 0; plane < CLIP_PLANES && count >= 3; plane++) {
+            const Vertex *in = polygons[src];
+            Vertex *out = polygons[1 - src];
+            int outCount = 0;
+            for (int i = 0; i < count; i++) {
+                const Vertex &a = in[i];
+                const Vertex &b = in[(i + 1) % count];
+                float da = planeDistance(a.clip, plane);
+                float db = planeDistance(b.clip, plane);
+                if (da >= 0.0f) {
+                    out[outCount++] = a;
+                }
+                if ((da >= 0.0f) != (db >= 0.0f) && outCount < MAX_CLIP_VERTICES) {
+                    float s = da / (da - db);
+                    Vertex &v = out[outCount++];
+                    for (int k = 0; k < 4; k++) {
+                        v.clip[k] = a.clip[k] + (b.clip[k] - a.clip[k]) * s;
+                    }
+                    for (int k = 0; k < VARYING_COUNT; k++) {
+                        v.varyings[k] = a.varyings[k] + (b.varyings[k] - a.varyings[k]) * s;
+                    }
+                }
+            }
+            count = outCount;
+            src = 1 - src;
+        }
+        for (int i = 1; i + 1 < count; i++) {
+            addTriangle(polygons[src][0], polygons[src][i], polygons[src][i + 1], drawIndex);
+        }
+    }
+    pendingStats.setupMs += (Utils::getCurrTimeUS() - startUS) / 1000.0f;
+}
+
+void SoftRasterizer::addTriangle(const Vertex &a, const Vertex &b, const Vertex &c, uint32_t drawIndex) {
+    const Vertex *corners[3] = {&a, &b, &c};
+    Triangle tri;
+    float sx[3], sy[3];
+    for (int i = 0; i < 3; i++) {
+        const float *clip = corners[i]->clip;
+        float invW = 1.0f / clip[3];
+        // viewport变换，GL的y轴向上，target的第一行在最上面
+        sx[i] = snap(viewport[0] + (clip[0] * invW * 0.5f + 0.5f) * viewport[2]);
+        sy[i] = snap(target.height - (viewport[1] + (clip[1] * invW * 0.5f + 0.5f) * viewport[3]));
+        tri.z[i] = clip[2] * invW * 0.5f + 0.5f;
+        tri.invW[i] = invW;
+        for (int k = 0; k < VARYING_COUNT; k++) {
+            tri.varyings[i][k] = corners[i]->varyings[k] * invW;
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        int from = (i + 1) % 3;
+        int to = (i + 2) % 3;
+        bool forward = sx[from] < sx[to] || (sx[from] == sx[to] && sy[from] < sy[to]);
+        int start = forward ? from : to;
+        int end = forward ? to : from;
+        Edge &edge = tri.edges[i];
+        edge.x = sx[start];
+        edge.y = sy[start];
+        edge.dx = sx[end] - sx[start];
+        edge.dy = sy[end] - sy[start];
+        edge.sign = forward ? 1.0f : -1.0f;
+    }
+    const Edge &e0 = tri.edges[0];
+    float area = ((sx[0] - e0.x) * e0.dy - (sy[0] - e0.y) * e0.dx) * e0.sign;
+    if (area == 0.0f || !std::isfinite(area)) {
+        return; // 退化成线或者点，GL也不会画
+    }
+    float orientation = area > 0.0f ? 1.0f : -1.0f;
+    area *= orientation;
+    for (int i = 0; i < 3; i++) {
+        Edge &edge = tri.edges[i];
+        edge.sign *= orientation;
+        // 内部为正的边函数是A * x + B * y + C，左边（A > 0）和上边（A == 0，B > 0，y向下）包括边上的像素
+        float gradientX = edge.sign * edge.dy;
+        float gradientY = -edge.sign * edge.dx;
+        edge.inclusive = gradientX > 0.0f || (gradientX == 0.0f && gradientY > 0.0f);
+    }
+
+    // 纹理LOD需要的屏幕空间导数：u/w、v/w和1/w在屏幕上都是线性的
+    for (int axis = 0; axis < 2; axis++) {
+        float du = 0.0f, dv = 0.0f, dq = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            const Edge &edge = tri.edges[i];
+            float gradient = (axis == 0 ? edge.sign * edge.dy : -edge.sign * edge.dx) / area;
+            du += gradient * tri.varyings[i][0];
+            dv += gradient * tri.varyings[i][1];
+            dq += gradient * tri.invW[i];
+        }
+        tri.lodGradients[axis][0] = du;
+        tri.lodGradients[axis][1] = dv;
+        tri.lodGradients[axis][2] = dq;
+    }
+
+    // 覆盖的像素中心在[min - 0.5, max - 0.5]之间，再和viewport、target求交
+    float minX = std::min(sx[0], std::min(sx[1], sx[2]));
+    float maxX = std::max(sx[0], std::max(sx[1], sx[2]));
+    float minY = std::min(sy[0], std::min(sy[1], sy[2]));
+    float maxY = std::max(sy[0], std::max(sy[1], sy[2]));
+    int32_t viewportTop = target.height - (viewport[1] + viewport[3]);
+    int32_t viewportBottom = target.height - viewport[1] - 1;
+    tri.minX = std::max({(int32_t)std::ceil(minX - 0.5f), viewport[0], 0});
+    tri.maxX = std::min({(int32_t)std::floor(maxX - 0.5f), viewport[0] + viewport[2] - 1, target.width - 1});
+    tri.minY = std::max({(int32_t)std::ceil(minY - 0.5f), viewportTop, 0});
+    tri.maxY = std::min({(int32_t)std::floor(maxY - 0.5f), viewportBottom, target.height - 1});
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY) {
+        return; // 比一个像素还小，没有覆盖任何像素中心
+    }
+    tri.draw = drawIndex;
+    triangles.push_back(tri);
+    pendingStats.rasterTriangles++;
+    binTriangle((uint32_t)triangles.size() - 1);
+}
+
+void SoftRasterizer::binTriangle(uint32_t triangleIndex) {
+    const Triangle &tri = triangles[triangleIndex];
+    int32_t tileX0 = tri.minX / TILE_SIZE;
+    int32_t tileX1 = tri.maxX / TILE_SIZE;
+    int32_t tileY0 = tri.minY / TILE_SIZE;
+    int32_t tileY1 = tri.maxY / TILE_SIZE;
+    bool single = tileX0 == tileX1 && tileY0 == tileY1;
+    for (int32_t ty = tileY0; ty <= tileY1; ty++) {
+        for (int32_t tx = tileX0; tx <= tileX1; tx++) {
+            // 跨多个tile的三角形，排除包围盒内但在某条边外侧的tile。取tile里边函数最大的角，
+            // 比它还小一个像素以上才排除，不受浮点误差的影响
+            bool rejected = false;
+            float left = tx * TILE_SIZE + 0.5f;
+            float right = std::min((tx + 1) * TILE_SIZE, target.width) - 0.5f;
+            float top = ty * TILE_SIZE + 0.5f;
+            float bottom = std::min((ty + 1) * TILE_SIZE, target.height) - 0.5f;
+            for (int i = 0; i < 3 && !single && !rejected; i++) {
+                const Edge &edge = tri.edges[i];
+                float px = edge.sign * edge.dy > 0.0f ? right : left;
+                float py = -edge.sign * edge.dx > 0.0f ? bottom : top;
+                float value = ((px - edge.x) * edge.dy - (py - edge.y) * edge.dx) * edge.sign;
+                rejected = value < -(std::fabs(edge.dx) + std::fabs(edge.dy));
+            }
+            if (!rejected) {
+                bins[(size_t)ty * tilesX + tx].push_back(triangleIndex);
+                pendingStats.binnedTriangles++;
+            }
+        }
+    }
+}
+
+void SoftRasterizer::flush() {
+    if (target.pixels == nullptr) {
+        return;
+    }
+    long startUS = Utils::getCurrTimeUS();
+    shadedPixels = 0;
+    nextTile = 0;
+    // 工作线程和调用线程一起从nextTile领取tile，tile比线程少时不需要唤醒所有的线程
+    unsigned int workers = pool ? std::min(threadCount, (unsigned int)std::max(tilesX * tilesY - 1, 0)) : 0;
+    finishedWorkers = 0;
+    for (unsigned int i = 0; i < workers; i++) {
+        pool->post([this]() {
+            rasterizeTiles();
+            std::lock_guard<std::mutex> lock(mutex);
+            finishedWorkers++;
+            finishedCondition.notify_one();
+        });
+    }
+    rasterizeTiles();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finishedCondition.wait(lock, [this, workers]() { return finishedWorkers == workers; });
+    }
+
+    clearPending = false;
+    draws.clear();
+    triangles.clear();
+    for (auto &bin: bins) {
+        bin.clear();
+    }
+    pendingStats.shadedPixels = shadedPixels;
+    pendingStats.rasterMs = (Utils::getCurrTimeUS() - startUS) / 1000.0f;
+    stats = pendingStats;
+    memset(&pendingStats, 0, sizeof(pendingStats));
+}
+
+void SoftRasterizer::rasterizeTiles() {
+    PROFILE_ZONE("soft raster tiles"); // 每个参与的线程各记一次
+    int32_t tileCount = tilesX * tilesY;
+    for (int32_t tile = nextTile++; tile < tileCount; tile = nextTile++) {
+        rasterizeTile(tile);
+    }
+}
+
+void SoftRasterizer::rasterizeTile(int32_t tile) {
+    int32_t x0 = (tile % tilesX) * TILE_SIZE;
+    int32_t y0 = (tile / tilesX) * TILE_SIZE;
+    int32_t x1 = std::min(x0 + TILE_SIZE, target.width) - 1;
+    int32_t y1 = std::min(y0 + TILE_SIZE, target.height) - 1;
+    if (clearPending) {
+        for (int32_t y = y0; y <= y1; y++) {
+            std::fill(target.pixels + (size_t)y * target.stride + x0, target.pixels + (size_t)y * target.stride + x1 + 1,
+                      clearColor);
+            std::fill(depth.begin() + (size_t)y * depthStride + x0, depth.begin() + (size_t)y * depthStride + x1 + 1,
+                      1.0f);
+        }
+    }
+    for (uint32_t index: bins[tile]) {
+        const Triangle &tri = triangles[index];
+        rasterizeTriangle(tri, std::max(x0, tri.minX), std::max(y0, tri.minY), std::min(x1, tri.maxX),
+                          std::min(y1, tri.maxY));
+    }
+}
+
+void SoftRasterizer::rasterizeTriangle(const Triangle &tri, int32_t x0, int32_t y0, int32_t x1, int32_t y1) {
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+    const DrawState &state = draws[tri.draw];
+    Float4 edgeX[3], edgeDy[3], edgeSign[3];
+    for (int i = 0; i < 3; i++) {
+        edgeX[i] = set4(tri.edges[i].x);
+        edgeDy[i] = set4(tri.edges[i].dy);
+        edgeSign[i] = set4(tri.edges[i].sign);
+    }
+    Float4 zero = set4(0.0f);
+    Float4 one = set4(1.0f);
+    Float4 z0 = set4(tri.z[0]);
+    Float4 z1 = set4(tri.z[1]);
+    Float4 z2 = set4(tri.z[2]);
+    Float4 firstColumn = set4(x0 + 0.25f);
+    Float4 lastColumn = set4(x1 + 0.75f);
+    uint32_t shaded = 0;
+    int32_t xStart = x0 & ~3; // 和depthStride一样按4对齐
+    for (int32_t y = y0; y <= y1; y++) {
+        float py = y + 0.5f;
+        uint32_t *colorRow = target.pixels + (size_t)y * target.stride;
+        float *depthRow = depth.data() + (size_t)y * depthStride;
+        float rowTerms[3];
+        for (int i = 0; i < 3; i++) {
+            rowTerms[i] = (py - tri.edges[i].y) * tri.edges[i].dx;
+        }
+        for (int32_t x = xStart; x <= x1; x += 4) {
+            Float4 px = set4(x + 0.5f, x + 1.5f, x + 2.5f, x + 3.5f);
+            Mask4 mask = and4(greaterEqual4(px, firstColumn), lessEqual4(px, lastColumn));
+            // 每条边都和addTriangle、binTriangle里同样的顺序计算：((px - x) * dy - (py - y) * dx) * sign
+            Float4 e[3];
+            for (int i = 0; i < 3; i++) {
+                e[i] = mul4(sub4(mul4(sub4(px, edgeX[i]), edgeDy[i]), set4(rowTerms[i])), edgeSign[i]);
+                mask = and4(mask, tri.edges[i].inclusive ? greaterEqual4(e[i], zero) : greater4(e[i], zero));
+            }
+            if (bits4(mask) == 0) {
+                continue;
+            }
+            Float4 inverseSum = div4(one, add4(add4(e[0], e[1]), e[2]));
+            Float4 b0 = mul4(e[0], inverseSum);
+            Float4 b1 = mul4(e[1], inverseSum);
+            Float4 b2 = mul4(e[2], inverseSum);
+            Float4 z = add4(add4(mul4(b0, z0), mul4(b1, z1)), mul4(b2, z2));
+            // GL_LESS，超过远裁剪面的也不画
+            mask = and4(mask, and4(less4(z, load4(depthRow + x)), lessEqual4(z, one)));
+            int bits = bits4(mask);
+            if (bits == 0) {
+                continue;
+            }
+            float bary[3][4], depths[4];
+            store4(bary[0], b0);
+            store4(bary[1], b1);
+            store4(bary[2], b2);
+            store4(depths, z);
+            for (int lane = 0; lane < 4; lane++) {
+                if (bits & (1 << lane)) {
+                    float weights[3] = {bary[0][lane], bary[1][lane], bary[2][lane]};
+                    colorRow[x + lane] = shade(tri, state, weights, colorRow[x + lane]);
+                    depthRow[x + lane] = depths[lane];
+                    shaded++;
+                }
+            }
+        }
+    }
+    shadedPixels += shaded;
+}
+
+// 和BaseShader的片元shader一致
+uint32_t SoftRasterizer::shade(const Triangle &tri, const DrawState &state, const float bary[3],
+                               uint32_t dst) const {
+    float w = 1.0f / (bary[0] * tri.invW[0] + bary[1] * tri.invW[1] + bary[2] * tri.invW[2]);
+    float varyings[VARYING_COUNT];
+    for (int k = 0; k < VARYING_COUNT; k++) {
+        varyings[k] = (bary[0] * tri.varyings[0][k] + bary[1] * tri.varyings[1][k] + bary[2] * tri.varyings[2][k]) * w;
+    }
+
+    float color[4];
+    memcpy(color, state.colorFactor, sizeof(color));
+    if ((state.features & SHADER_TEXTURED) && state.texture == nullptr) {
+        color[0] = color[1] = color[2] = 0.0f; // 和GL采样不完整的纹理一样，得到(0, 0, 0, 1)
+    } else if (state.texture != nullptr) {
+        const SoftTexture &texture = *state.texture;
+        // d(u)/dx = (d(u/w)/dx - u * d(1/w)/dx) * w，两个方向取较大的作为LOD
+        float rho2 = 0.0f;
+        for (int axis = 0; axis < 2; axis++) {
+            const float *gradient = tri.lodGradients[axis];
+            float du = (gradient[0] - varyings[0] * gradient[2]) * w * texture.width;
+            float dv = (gradient[1] - varyings[1] * gradient[2]) * w * texture.height;
+            rho2 = std::max(rho2, du * du + dv * dv);
+        }
+        float texel[4];
+        sampleTrilinear(texture, varyings[0], varyings[1], 0.5f * std::log2(rho2), texel);
+        for (int c = 0; c < 4; c++) {
+            color[c] *= texel[c];
+        }
+    }
+
+    if (state.features & SHADER_LIT) {
+        float normal[3] = {varyings[2], varyings[3], varyings[4]};
+        normalize3(normal);
+        float light[3] = {lightPosition[0] - varyings[5], lightPosition[1] - varyings[6],
+                          lightPosition[2] - varyings[7]};
+        normalize3(light);
+        float cosAngle = std::max(0.0f, normal[0] * light[0] + normal[1] * light[1] + normal[2] * light[2]);
+        float half[3] = {light[0], light[1], light[2] - 1.0f}; // 观察方向是(0, 0, -1)
+        normalize3(half);
+        float specular = std::pow(std::max(0.0f, normal[0] * half[0] + normal[1] * half[1] + normal[2] * half[2]),
+                                  SHININESS);
+        for (int c = 0; c < 3; c++) {
+            color[c] = color[c] * 0.68f + cosAngle * lightColor[c] * 0.17f + specular * lightColor[c] * 0.15f;
+        }
+    }
+
+    if (!(state.features & SHADER_ALPHA)) {
+        color[3] = 1.0f;
+        return packColor(color);
+    }
+    // GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA，alpha通道也一样
+    float alpha = clamp01(color[3]);
+    float result[4];
+    for (int c = 0; c < 4; c++) {
+        float destination = ((dst >> (c * 8)) & 0xFF) * (1.0f / 255.0f);
+        result[c] = clamp01(color[c]) * alpha + destination * (1.0f - alpha);
+    }
+    return packColor(result);
+}
@@ -0,0 +1,146 @@
+#ifndef NATIVEACTIVITYDEMO_SOFTRASTERIZER_H
+#define NATIVEACTIVITYDEMO_SOFTRASTERIZER_H
+
+#include <GLES3/gl32.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "../texture/SoftTexture.h"
+#include "../utils/ThreadPool.h"
+
+// 渲染目标，RGBA8888，内存里的字节顺序是R、G、B、A，第一行是屏幕最上面一行。
+// 和WINDOW_FORMAT_RGBA_8888的ANativeWindow_Buffer布局一致，也可以指向普通内存
+struct SoftTarget {
+    uint32_t *pixels = nullptr;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t stride = 0; // 每行的像素数，不小于width
+};
+
+// 一次绘制，对应一个DrawPacket。顶点数据在submit里就处理完了，只有texture需要保持到flush结束
+struct SoftDraw {
+    const GLfloat *transformMat4 = nullptr; // 列优先，和ObjectBlock里的transformMat4一样；nullptr时为单位矩阵
+    const GLfloat *positions = nullptr; // 3个为一组
+    const GLfloat *texCoords = nullptr; // 2个为一组，nullptr时和GL没有启用这个属性一样，取(0, 0)
+    const GLfloat *normals = nullptr; // 3个为一组，LIT时需要
+    uint32_t vertexCount = 0;
+    const GLushort *indices = nullptr; // GL_TRIANGLES
+    uint32_t indexCount = 0;
+    const SoftTexture *texture = nullptr; // TEXTURED时为nullptr，和GL没有加载成功的纹理一样采样到黑色
+    GLfloat colorFactor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    uint32_t features = 0; // ShaderFeature，支持TRANSFORM、LIT、TEXTURED和ALPHA
+};
+
+struct SoftRasterizerStats {
+    uint32_t draws;
+    uint32_t triangles; // 提交的三角形
+    uint32_t clippedTriangles; // 需要裁剪的三角形
+    uint32_t rasterTriangles; // 裁剪后送去光栅化的三角形
+    uint32_t binnedTriangles; // 三角形和tile相交的次数
+    uint32_t shadedPixels; // 通过深度测试、执行了着色的像素
+    float setupMs; // 顶点变换、裁剪和分块，发生在submit里
+    float rasterMs; // flush
+};
+
+/**
+ * 不依赖GPU的软件光栅化，输出和BaseShader的各个特性组合一致：透视校正的纹理坐标、三线性过滤（GL_REPEAT）、
+ * 同样的光照公式，深度测试为GL_LESS，ALPHA时按SRC_ALPHA, ONE_MINUS_SRC_ALPHA混合。
+ * submit时在调用线程做顶点变换、齐次裁剪（近裁剪面和guard band），把三角形按提交顺序分到64x64的tile里；
+ * flush时各线程每次领取一个tile，按顺序光栅化其中的三角形，tile之间没有共享的像素，结果和线程数无关。
+ * 覆盖和深度测试用SSE2/NEON一次处理4个像素，着色逐像素。
+ * 没有排序，半透明的物体需要在不透明的之后提交。只能在一个线程里调用。
+ */
+class SoftRasterizer {
+public:
+    static const int TILE_SIZE = 64;
+
+    // threadCount是额外的工作线程数，调用线程也参与光栅化，为0时只用调用线程
+    explicit SoftRasterizer(unsigned int threadCount = ThreadPool::defaultThreadCount());
+
+    // 深度缓冲随target的尺寸分配，target的内存由调用者持有，flush之前不能释放
+    void setTarget(const SoftTarget &target);
+    // GL的约定：(x, y)是左下角。没有设置时是整个target
+    void setViewport(int32_t x, int32_t y, int32_t width, int32_t height);
+    void setLight(const GLfloat position[3], const GLfloat color[3]);
+    // 在flush时按tile清除颜色和深度（1.0）
+    void clear(const GLfloat color[4]);
+
+    void submit(const SoftDraw &draw);
+    // 光栅化所有提交的三角形，返回时target里是完整的一帧
+    void flush();
+
+    const SoftRasterizerStats &getStats() const { return stats; }
+
+private:
+    static const int VARYING_COUNT = 8; // u, v, 法向量xyz, 变换后的顶点坐标xyz
+
+    // 裁剪坐标和varying，varying在投影后被除以w
+    struct Vertex {
+        float clip[4];
+        float varyings[VARYING_COUNT];
+    };
+
+    struct DrawState {
+        const SoftTexture *texture;
+        float colorFactor[4];
+        uint32_t features;
+    };
+
+    // 三角形的边。为了让相邻三角形的公共边得到完全相同（符号相反）的结果，总是从坐标较小的端点开始计算
+    struct Edge {
+        float x, y; // 起点
+        float dx, dy;
+        float sign; // 乘上它之后三角形内部为正
+        bool inclusive; // 刚好落在边上的像素是否属于这个三角形（top-left规则）
+    };
+
+    struct Triangle {
+        Edge edges[3]; // edges[i]是顶点i对面的边，它的值和顶点i的重心坐标成正比
+        float z[3];
+        float invW[3];
+        float varyings[3][VARYING_COUNT]; // 已经除以w
+        float lodGradients[2][3]; // u/w、v/w和1/w对屏幕x、y的导数，用于计算纹理的LOD
+        int32_t minX, minY, maxX, maxY; // 像素范围，已经和viewport、target求交
+        uint32_t draw;
+    };
+
+    std::unique_ptr<ThreadPool> pool;
+    unsigned int threadCount;
+
+    SoftTarget target;
+    std::vector<float> depth;
+    int32_t depthStride = 0; // 4的倍数，4个像素一组读写时不会越过行尾
+    int32_t viewport[4] = {0, 0, 0, 0};
+    float lightPosition[3] = {0.0f, 0.0f, 0.0f};
+    float lightColor[3] = {1.0f, 1.0f, 1.0f};
+    bool clearPending = false;
+    uint32_t clearColor = 0;
+
+    std::vector<Vertex> vertices; // submit里变换后的顶点，只在submit内使用
+    std::vector<DrawState> draws;
+    std::vector<Triangle> triangles;
+    int32_t tilesX = 0;
+    int32_t tilesY = 0;
+    std::vector<std::vector<uint32_t>> bins; // 每个tile里的三角形下标，按提交顺序
+
+    std::atomic<int32_t> nextTile;
+    std::mutex mutex;
+    std::condition_variable finishedCondition;
+    unsigned int finishedWorkers = 0;
+
+    SoftRasterizerStats stats; // 上一次flush的
+    SoftRasterizerStats pendingStats; // 这一帧正在统计的
+    std::atomic<uint32_t> shadedPixels;
+
+    void addTriangle(const Vertex &a, const Vertex &b, const Vertex &c, uint32_t drawIndex);
+    void binTriangle(uint32_t triangleIndex);
+    void rasterizeTiles();
+    void rasterizeTile(int32_t tile);
+    void rasterizeTriangle(const Triangle &tri, int32_t x0, int32_t y0, int32_t x1, int32_t y1);
+    uint32_t shade(const Triangle &tri, const DrawState &state, const float bary[3], uint32_t dst) const;
+};
+
+#endif //NATIVEACTIVITYDEMO_SOFTRASTERIZER_H
@@ -0,0 +1,93 @@
+#include "UniformRing.h"
+#include "../app_log.h"
+#include "../gles/GLStateCache.h"
+
+static const size_t MIN_SEGMENT_SIZE = 64 * 1024;
+static const GLuint64 FENCE_TIMEOUT_NS = 100 * 1000 * 1000; // 100ms
+
+UniformRing::~UniformRing() {
+    release();
+}
+
+void UniformRing::release() {
+    for (GLsync &fence: fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (buffer != 0) {
+        GLStateCache::deleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    segmentSize = 0;
+    mapped = nullptr;
+}
+
+size_t UniformRing::alignUp(size_t size) const {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+void UniformRing::resize(size_t newSegmentSize) {
+    release();
+    GLint align = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+    alignment = (size_t)align;
+    segmentSize = alignUp(newSegmentSize);
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, segmentSize * FRAME_COUNT, nullptr, GL_DYNAMIC_DRAW);
+    app_log("UniformRing resize: segment: %zu bytes, alignment: %zu\n", segmentSize, alignment);
+}
+
+void UniformRing::beginFrame(size_t requiredBytes) {
+    if (buffer == 0 || requiredBytes > segmentSize) {
+        size_t newSize = segmentSize > MIN_SEGMENT_SIZE ? segmentSize : MIN_SEGMENT_SIZE;
+        while (newSize < requiredBytes) {
+            newSize *= 2;
+        }
+        resize(newSize);
+    }
+
+    segment = (segment + 1) % FRAME_COUNT;
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    if (fences[segment] != nullptr) {
+        // 三帧之前的fence，正常情况下已经signaled，这里几乎不会阻塞
+        GLenum result = glClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+            // GPU可能还在读这一段，不能不同步地覆盖，交给驱动等待
+            app_log("UniformRing fence %s, map synchronized\n",
+                    result == GL_TIMEOUT_EXPIRED ? "timeout" : "wait failed");
+            access &= ~GL_MAP_UNSYNCHRONIZED_BIT;
+        }
+        glDeleteSync(fences[segment]);
+        fences[segment] = nullptr;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    mapped = (GLubyte *)glMapBufferRange(GL_UNIFORM_BUFFER, segmentSize * segment, segmentSize, access);
+    used = 0;
+}
+
+void *UniformRing::allocate(size_t size, GLintptr *outOffset) {
+    size_t alignedSize = alignUp(size);
+    if (mapped == nullptr || used + alignedSize > segmentSize) {
+        return nullptr;
+    }
+    void *ptr = mapped + used;
+    *outOffset = (GLintptr)(segmentSize * segment + used);
+    used += alignedSize;
+    return ptr;
+}
+
+void UniformRing::unmap() {
+    if (mapped == nullptr) return;
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glUnmapBuffer(GL_UNIFORM_BUFFER);
+    mapped = nullptr;
+}
+
+void UniformRing::endFrame() {
+    if (buffer == 0) return;
+    fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,47 @@
+#ifndef NATIVEACTIVITYDEMO_UNIFORMRING_H
+#define NATIVEACTIVITYDEMO_UNIFORMRING_H
+
+#include <GLES3/gl32.h>
+#include <cstddef>
+
+/**
+ * 一个大的GL_UNIFORM_BUFFER，分成FRAME_COUNT段轮流使用，每帧从当前段中顺序分配uniform block。
+ * 每段用完后插入fence，再次轮到这一段时GPU一般早已读完，map时不需要同步；等待超时或失败时改为同步的map。
+ * 分配出的偏移按GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT对齐，直接用于glBindBufferRange。
+ */
+class UniformRing {
+public:
+    ~UniformRing();
+
+    // 对齐要求的上限，用来估算本帧需要的大小
+    static const size_t MAX_ALIGNMENT = 256;
+
+    // 映射下一段，requiredBytes是本帧预计需要的大小，不够时重新分配整个buffer
+    void beginFrame(size_t requiredBytes);
+    // 返回写入位置，outOffset是相对buffer起点的偏移。空间不足时返回nullptr
+    void *allocate(size_t size, GLintptr *outOffset);
+    // 解除映射，之后才能用于绘制
+    void unmap();
+    // 本帧的绘制命令都提交后调用，插入fence
+    void endFrame();
+
+    GLuint getBuffer() const { return buffer; }
+    // context销毁前调用
+    void release();
+
+private:
+    static const int FRAME_COUNT = 3;
+
+    GLuint buffer = 0;
+    size_t segmentSize = 0;
+    size_t alignment = 0;
+    int segment = 0;
+    size_t used = 0;
+    GLubyte *mapped = nullptr;
+    GLsync fences[FRAME_COUNT] = {nullptr};
+
+    size_t alignUp(size_t size) const;
+    void resize(size_t newSegmentSize);
+};
+
+#endif //NATIVEACTIVITYDEMO_UNIFORMRING_H
@@ -0,0 +1,217 @@
+#include "AssetLoader.h"
+#include "ResourceCache.h"
+#include "../app_log.h"
+#include "../profiler/Profiler.h"
+#include "../texture/TextureUtils.h"
+#include "../texture/TextureUploader.h"
+#include "../texture/MipmapGenerator.h"
+#include "../texture/TextureAtlas.h"
+#include "../utils/Utils.h"
+#include <cstdlib>
+
+std::unique_ptr<ThreadPool> AssetLoader::pool;
+std::mutex AssetLoader::readyMutex;
+std::deque<std::unique_ptr<AssetLoader::LoadJob>> AssetLoader::readyJobs;
+std::unordered_map<std::string, std::vector<AssetLoader::MeshCallback>> AssetLoader::meshCallbacks;
+std::unordered_map<std::string, std::vector<AssetLoader::TextureCallback>> AssetLoader::textureCallbacks;
+uint32_t AssetLoader::generation = 0;
+uint32_t AssetLoader::pendingJobs = 0;
+
+AssetLoader::LoadJob::~LoadJob() {
+    free(image);
+}
+
+void AssetLoader::loadMesh(const char *assetObjName, bool needGenHeightMap, bool hasTexCoords,
+                           bool isSmoothLight, MeshCallback callback) {
+    std::string key = ResourceCache::makeMeshKey(assetObjName, needGenHeightMap, hasTexCoords, isSmoothLight);
+    std::shared_ptr<ObjMesh> mesh = ResourceCache::findMesh(key);
+    if (mesh) {
+        callback(mesh);
+        return;
+    }
+    std::vector<MeshCallback> &callbacks = meshCallbacks[key];
+    callbacks.push_back(std::move(callback));
+    if (callbacks.size() > 1) {
+        return; // 同一个资源已经在加载中，完成后一起回调
+    }
+
+    std::unique_ptr<LoadJob> job(new LoadJob());
+    job->type = JOB_MESH;
+    job->name = assetObjName;
+    job->key = key;
+    job->needGenHeightMap = needGenHeightMap;
+    job->hasTexCoords = hasTexCoords;
+    job->isSmoothLight = isSmoothLight;
+    post(std::move(job));
+}
+
+void AssetLoader::loadTexture(const char *assetPngName, TextureCallback callback, TextureOption option) {
+    std::string key = ResourceCache::makeTextureKey(assetPngName, option);
+    std::shared_ptr<Texture> texture = ResourceCache::findTexture(key);
+    if (!texture) {
+        texture = TextureAtlas::find(assetPngName); // 已经在图集里的不需要重新解码
+        if (texture) {
+            ResourceCache::putTexture(key, texture);
+        }
+    }
+    if (texture) {
+        callback(texture);
+        return;
+    }
+    std::vector<TextureCallback> &callbacks = textureCallbacks[key];
+    callbacks.push_back(std::move(callback));
+    if (callbacks.size() > 1) {
+        return;
+    }
+
+    std::unique_ptr<LoadJob> job(new LoadJob());
+    job->type = JOB_TEXTURE;
+    job->name = assetPngName;
+    job->key = key;
+    job->option = option;
+    post(std::move(job));
+}
+
+void AssetLoader::reloadTexture(const char *assetPngName, TextureOption option, TextureCallback callback) {
+    std::unique_ptr<LoadJob> job(new LoadJob());
+    job->type = JOB_TEXTURE;
+    job->name = assetPngName;
+    job->key = ResourceCache::makeTextureKey(assetPngName, option);
+    job->option = option;
+    job->reloadCallback = std::move(callback);
+    post(std::move(job));
+}
+
+void AssetLoader::post(std::unique_ptr<LoadJob> job) {
+    if (!pool) {
+        pool.reset(new ThreadPool(ThreadPool::defaultThreadCount()));
+    }
+    job->generation = generation;
+    job->requestUS = Utils::getCurrTimeUS();
+    pendingJobs++;
+    LoadJob *rawJob = job.release(); // std::function要求可拷贝，只能传裸指针
+    pool->post([rawJob] { runJob(rawJob); });
+}
+
+void AssetLoader::runJob(LoadJob *job) {
+    PROFILE_ZONE("asset decode");
+    job->startUS = Utils::getCurrTimeUS();
+    if (job->type == JOB_MESH) {
+        job->meshData = ObjMesh::parse(job->name.c_str(), job->needGenHeightMap,
+                                       job->hasTexCoords, job->isSmoothLight);
+    } else {
+        job->ktx = KtxTexture::read(KtxTexture::ktxNameFor(job->name.c_str()).c_str());
+        if (!job->ktx) {
+            job->image = TextureUtils::decodePNG(job->name.c_str(), &job->width, &job->height);
+            job->levels = MipmapGenerator::build(&job->image, job->width, job->height);
+            job->format = TextureUtils::applyOption(&job->image, job->width, job->height, job->levels, job->option);
+        }
+    }
+    job->decodedUS = Utils::getCurrTimeUS();
+
+    std::lock_guard<std::mutex> lock(readyMutex);
+    readyJobs.emplace_back(job);
+}
+
+void AssetLoader::pump(long budgetUS) {
+    long pumpStartUS = Utils::getCurrTimeUS();
+    TextureUploader::pump(); // 先继续上一帧没传完的纹理，按字节数限制
+    while (Utils::getCurrTimeUS() - pumpStartUS < budgetUS) {
+        std::unique_ptr<LoadJob> job;
+        {
+            std::lock_guard<std::mutex> lock(readyMutex);
+            if (readyJobs.empty()) {
+                return;
+            }
+            job = std::move(readyJobs.front());
+            readyJobs.pop_front();
+        }
+        if (job->generation != generation) {
+            continue; // cancelAll之前提交的
+        }
+        uploadJob(job.get());
+    }
+}
+
+void AssetLoader::uploadJob(LoadJob *job) {
+    PROFILE_ZONE("asset upload");
+    long uploadStartUS = Utils::getCurrTimeUS();
+    if (job->type == JOB_MESH) {
+        std::shared_ptr<ObjMesh> mesh = job->meshData ? ObjMesh::upload(*job->meshData) : nullptr;
+        pendingJobs--;
+        ResourceCache::putMesh(job->key, mesh);
+        std::vector<MeshCallback> callbacks = std::move(meshCallbacks[job->key]);
+        meshCallbacks.erase(job->key);
+        for (MeshCallback &callback: callbacks) {
+            callback(mesh);
+        }
+    } else if (job->ktx) {
+        // 压缩后的数据量只有RGBA8的1/8到1/4，直接整体上传
+        std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+        KtxTexture::upload(&texture->id, *job->ktx);
+        texture->bytes = job->ktx->data.size();
+        finishTexture(job->key, texture, job->reloadCallback);
+    } else if (job->image != nullptr && TextureAtlas::accepts(job->width, job->height)) {
+        // 小纹理装进图集，数据量很小，直接上传
+        finishTexture(job->key, TextureAtlas::add(job->name, job->image, job->width, job->height),
+                      job->reloadCallback);
+    } else if (job->image != nullptr) {
+        // 大纹理分多帧通过PBO上传，上传完才回调。job在这之后就释放了，回调需要的信息都拷贝一份
+        void *image = job->image;
+        job->image = nullptr;
+        std::string key = job->key;
+        std::string name = job->name;
+        uint32_t jobGeneration = job->generation;
+        long requestUS = job->requestUS;
+        TextureCallback reloadCallback = job->reloadCallback;
+        TextureUploader::enqueue(image, job->width, job->height, job->levels, job->format,
+                                 [key, name, jobGeneration, requestUS, uploadStartUS, reloadCallback](
+                                         const std::shared_ptr<Texture> &texture) {
+            if (jobGeneration != generation) {
+                return;
+            }
+            finishTexture(key, texture, reloadCallback);
+            app_log("asset %s: streamed in %.1fms, total %.1fms\n", name.c_str(),
+                    (Utils::getCurrTimeUS() - uploadStartUS) / 1000.0f,
+                    (Utils::getCurrTimeUS() - requestUS) / 1000.0f);
+        }); // 上传完之前仍然算在pendingJobs里
+    } else {
+        // 和loadPNGTexture一致，解码失败时也生成纹理对象（不完整的纹理采样为黑色）
+        std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+        TextureUtils::uploadTexture(&texture->id, 0, 0, nullptr);
+        finishTexture(job->key, texture, job->reloadCallback);
+    }
+    long doneUS = Utils::getCurrTimeUS();
+
+    // 关键路径：排队等工作线程 -> 读取解码 -> 排队等GL线程 -> 上传和回调
+    app_log("asset %s: queued %.1fms, decode %.1fms, wait upload %.1fms, upload %.1fms, total %.1fms\n",
+            job->name.c_str(),
+            (job->startUS - job->requestUS) / 1000.0f, (job->decodedUS - job->startUS) / 1000.0f,
+            (uploadStartUS - job->decodedUS) / 1000.0f, (doneUS - uploadStartUS) / 1000.0f,
+            (doneUS - job->requestUS) / 1000.0f);
+}
+
+void AssetLoader::finishTexture(const std::string &key, const std::shared_ptr<Texture> &texture,
+                                const TextureCallback &reloadCallback) {
+    pendingJobs--;
+    if (reloadCallback) {
+        reloadCallback(texture);
+        return;
+    }
+    ResourceCache::putTexture(key, texture);
+    std::vector<TextureCallback> callbacks = std::move(textureCallbacks[key]);
+    textureCallbacks.erase(key);
+    for (TextureCallback &callback: callbacks) {
+        callback(texture);
+    }
+}
+
+void AssetLoader::cancelAll() {
+    TextureUploader::cancelAll();
+    generation++;
+    pendingJobs = 0;
+    meshCallbacks.clear();
+    textureCallbacks.clear();
+    std::lock_guard<std::mutex> lock(readyMutex);
+    readyJobs.clear();
+}
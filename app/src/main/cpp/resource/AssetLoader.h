@@ -0,0 +1,91 @@
+#ifndef NATIVEACTIVITYDEMO_ASSETLOADER_H
+#define NATIVEACTIVITYDEMO_ASSETLOADER_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../view/ObjMesh.h"
+#include "../texture/Texture.h"
+#include "../texture/KtxTexture.h"
+#include "../texture/PixelConverter.h"
+#include "../utils/ThreadPool.h"
+
+/**
+ * 异步加载obj和png：文件读取、解码、mipmap生成、解析和高度图生成在工作线程，
+ * 完成后的cpu侧数据排队等待GL线程在pump中上传，每帧上传的时间有预算，纹理通过TextureUploader分帧上传。
+ * 上传完成后登记到ResourceCache，并在GL线程回调。已经在缓存里的资源会立即回调。
+ * 除了工作线程内部，所有接口都只能在GL线程调用。
+ */
+class AssetLoader {
+public:
+    typedef std::function<void(const std::shared_ptr<ObjMesh> &)> MeshCallback;
+    typedef std::function<void(const std::shared_ptr<Texture> &)> TextureCallback;
+
+    // mesh读取失败时回调的参数为nullptr
+    static void loadMesh(const char *assetObjName, bool needGenHeightMap, bool hasTexCoords,
+                         bool isSmoothLight, MeshCallback callback);
+    static void loadTexture(const char *assetPngName, TextureCallback callback, TextureOption option = TEXTURE_RGBA8);
+    // 给TextureManager用：不查缓存，重新读取并上传成新的纹理，结果也不登记到缓存（缓存里的还是原来的Texture对象）
+    static void reloadTexture(const char *assetPngName, TextureOption option, TextureCallback callback);
+
+    // 每帧调用一次，mesh超过budgetUS后剩下的留到下一帧，纹理按TextureUploader的字节预算分帧上传
+    static void pump(long budgetUS);
+    static bool hasPending() { return pendingJobs > 0; }
+
+    // context销毁前调用，丢弃还没完成的请求和回调，工作线程里正在执行的结果会在之后被丢弃
+    static void cancelAll();
+
+private:
+    enum JobType {
+        JOB_MESH,
+        JOB_TEXTURE
+    };
+
+    struct LoadJob {
+        JobType type;
+        std::string name;
+        std::string key;
+        bool needGenHeightMap = false;
+        bool hasTexCoords = false;
+        bool isSmoothLight = false;
+        uint32_t generation = 0;
+
+        std::unique_ptr<ObjMeshData> meshData;
+        std::unique_ptr<KtxImage> ktx; // 有对应的ktx文件时使用压缩纹理，不再解码png
+        void *image = nullptr; // 带完整的mipmap链
+        uint32_t width = 0;
+        uint32_t height = 0;
+        int levels = 1;
+        TextureOption option = TEXTURE_RGBA8;
+        PixelFormat format = PIXEL_RGBA8888; // image转换后的格式
+        TextureCallback reloadCallback; // 非空时是reloadTexture的请求
+
+        // 各阶段的时间戳，微秒
+        long requestUS = 0; // GL线程提交
+        long startUS = 0; // 工作线程开始
+        long decodedUS = 0; // 读取、解码或解析完成，进入上传队列
+
+        ~LoadJob();
+    };
+
+    static std::unique_ptr<ThreadPool> pool;
+    static std::mutex readyMutex;
+    static std::deque<std::unique_ptr<LoadJob>> readyJobs; // 工作线程完成的，等待上传
+    static std::unordered_map<std::string, std::vector<MeshCallback>> meshCallbacks;
+    static std::unordered_map<std::string, std::vector<TextureCallback>> textureCallbacks;
+    static uint32_t generation;
+    static uint32_t pendingJobs;
+
+    static void post(std::unique_ptr<LoadJob> job);
+    static void runJob(LoadJob *job); // 工作线程
+    static void uploadJob(LoadJob *job);
+    static void finishTexture(const std::string &key, const std::shared_ptr<Texture> &texture,
+                              const TextureCallback &reloadCallback);
+};
+
+#endif //NATIVEACTIVITYDEMO_ASSETLOADER_H
@@ -0,0 +1,226 @@
+#include "ResourceCache.h"
+#include "TextureManager.h"
+#include "../app_log.h"
+#include "../texture/TextureUtils.h"
+#include "../texture/KtxTexture.h"
+#include "../texture/MipmapGenerator.h"
+#include "../texture/PixelConverter.h"
+#include "../texture/TextureAtlas.h"
+#include <cstdlib>
+
+std::unordered_map<std::string, std::weak_ptr<ObjMesh>> ResourceCache::meshes;
+std::unordered_map<std::string, std::weak_ptr<Texture>> ResourceCache::textures;
+std::unordered_map<std::string, std::weak_ptr<const ObjMeshData>> ResourceCache::meshDatas;
+std::unordered_map<std::string, std::weak_ptr<const SoftTexture>> ResourceCache::softTextures;
+ResourceCacheStats ResourceCache::stats = {0, 0, 0, 0};
+
+std::string ResourceCache::makeMeshKey(const char *assetObjName, bool needGenHeightMap,
+                                       bool hasTexCoords, bool isSmoothLight) {
+    std::string key(assetObjName);
+    key += needGenHeightMap ? "|h1" : "|h0";
+    key += hasTexCoords ? "t1" : "t0";
+    key += isSmoothLight ? "s1" : "s0";
+    return key;
+}
+
+std::string ResourceCache::makeTextureKey(const char *assetPngName, TextureOption option) {
+    std::string key(assetPngName);
+    if (option == TEXTURE_16BIT) {
+        key += "|16";
+    } else if (option == TEXTURE_16BIT_DIFFUSION) {
+        key += "|16d";
+    }
+    return key;
+}
+
+TextureOption ResourceCache::parseTextureKey(const std::string &key, std::string *assetPngName) {
+    size_t pos = key.rfind('|');
+    if (pos == std::string::npos) {
+        *assetPngName = key;
+        return TEXTURE_RGBA8;
+    }
+    *assetPngName = key.substr(0, pos);
+    return key.compare(pos, std::string::npos, "|16d") == 0 ? TEXTURE_16BIT_DIFFUSION : TEXTURE_16BIT;
+}
+
+std::shared_ptr<ObjMesh> ResourceCache::findMesh(const std::string &key) {
+    auto it = meshes.find(key);
+    std::shared_ptr<ObjMesh> mesh = it != meshes.end() ? it->second.lock() : nullptr;
+    if (mesh) {
+        stats.meshHits++;
+    } else {
+        stats.meshMisses++;
+    }
+    return mesh;
+}
+
+std::shared_ptr<Texture> ResourceCache::findTexture(const std::string &key) {
+    auto it = textures.find(key);
+    std::shared_ptr<Texture> texture = it != textures.end() ? it->second.lock() : nullptr;
+    if (texture) {
+        stats.textureHits++;
+    } else {
+        stats.textureMisses++;
+    }
+    return texture;
+}
+
+void ResourceCache::putMesh(const std::string &key, const std::shared_ptr<ObjMesh> &mesh) {
+    if (mesh) {
+        meshes[key] = mesh;
+    } else {
+        meshes.erase(key);
+    }
+}
+
+void ResourceCache::putTexture(const std::string &key, const std::shared_ptr<Texture> &texture) {
+    if (texture) {
+        textures[key] = texture;
+        TextureManager::track(key, texture);
+    } else {
+        textures.erase(key);
+    }
+}
+
+std::shared_ptr<ObjMesh> ResourceCache::getMesh(const char *assetObjName, bool needGenHeightMap,
+                                                bool hasTexCoords, bool isSmoothLight) {
+    std::string key = makeMeshKey(assetObjName, needGenHeightMap, hasTexCoords, isSmoothLight);
+    std::shared_ptr<ObjMesh> mesh = findMesh(key);
+    if (!mesh) {
+        mesh = ObjMesh::load(assetObjName, needGenHeightMap, hasTexCoords, isSmoothLight);
+        putMesh(key, mesh);
+    }
+    return mesh;
+}
+
+std::shared_ptr<Texture> ResourceCache::getTexture(const char *assetPngName, TextureOption option) {
+    std::string key = makeTextureKey(assetPngName, option);
+    std::shared_ptr<Texture> texture = findTexture(key);
+    if (texture) {
+        return texture;
+    }
+    texture = TextureAtlas::find(assetPngName); // 之前装进图集的，子纹理释放后区域仍然保留，图集里都是RGBA8
+    if (!texture) {
+        std::unique_ptr<KtxImage> ktx = KtxTexture::read(KtxTexture::ktxNameFor(assetPngName).c_str());
+        uint32_t w = 0, h = 0;
+        void *image = ktx ? nullptr : TextureUtils::decodePNG(assetPngName, &w, &h);
+        if (image != nullptr && TextureAtlas::accepts(w, h)) {
+            texture = TextureAtlas::add(assetPngName, image, w, h);
+        }
+        if (!texture) {
+            texture = std::make_shared<Texture>();
+            if (ktx) {
+                KtxTexture::upload(&texture->id, *ktx);
+                texture->bytes = ktx->data.size();
+            } else {
+                int levels = MipmapGenerator::build(&image, w, h);
+                PixelFormat format = TextureUtils::applyOption(&image, w, h, levels, option);
+                TextureUtils::uploadTexture(&texture->id, w, h, image, levels, format);
+                texture->bytes = image ? PixelConverter::levelOffset(w, h, levels, format) : 0;
+            }
+        }
+        free(image);
+    }
+    putTexture(key, texture);
+    return texture;
+}
+
+void ResourceCache::getTextures(const char *const *assetPngNames, int count, std::shared_ptr<Texture> *outTextures) {
+    std::vector<const char *> missNames;
+    std::vector<int> missIndices;
+    for (int i = 0; i < count; i++) {
+        outTextures[i] = findTexture(assetPngNames[i]);
+        if (!outTextures[i]) {
+            outTextures[i] = TextureAtlas::find(assetPngNames[i]);
+            if (outTextures[i]) {
+                putTexture(assetPngNames[i], outTextures[i]);
+                continue;
+            }
+            std::unique_ptr<KtxImage> ktx = KtxTexture::read(KtxTexture::ktxNameFor(assetPngNames[i]).c_str());
+            if (ktx) { // 压缩纹理读取很快，不需要并行
+                outTextures[i] = std::make_shared<Texture>();
+                KtxTexture::upload(&outTextures[i]->id, *ktx);
+                outTextures[i]->bytes = ktx->data.size();
+                putTexture(assetPngNames[i], outTextures[i]);
+                continue;
+            }
+            missNames.push_back(assetPngNames[i]);
+            missIndices.push_back(i);
+        }
+    }
+    if (missNames.empty()) {
+        return;
+    }
+
+    size_t missCount = missNames.size();
+    std::vector<void *> images(missCount, nullptr);
+    std::vector<uint32_t> ws(missCount, 0);
+    std::vector<uint32_t> hs(missCount, 0);
+    std::vector<int> levels(missCount, 1);
+    TextureUtils::decodePNGs(missNames.data(), (int)missCount, images.data(), ws.data(), hs.data(), levels.data());
+    for (size_t i = 0; i < missCount; i++) {
+        std::shared_ptr<Texture> texture;
+        if (images[i] != nullptr && TextureAtlas::accepts(ws[i], hs[i])) {
+            texture = TextureAtlas::add(missNames[i], images[i], ws[i], hs[i]);
+        }
+        if (!texture) {
+            texture = std::make_shared<Texture>();
+            TextureUtils::uploadTexture(&texture->id, ws[i], hs[i], images[i], levels[i]);
+            texture->bytes = images[i] ? MipmapGenerator::levelOffset(ws[i], hs[i], levels[i]) : 0;
+        }
+        free(images[i]);
+        putTexture(missNames[i], texture);
+        outTextures[missIndices[i]] = texture;
+    }
+}
+
+std::shared_ptr<const ObjMeshData> ResourceCache::getMeshData(const char *assetObjName, bool needGenHeightMap,
+                                                              bool hasTexCoords, bool isSmoothLight) {
+    std::string key = makeMeshKey(assetObjName, needGenHeightMap, hasTexCoords, isSmoothLight);
+    auto it = meshDatas.find(key);
+    std::shared_ptr<const ObjMeshData> data = it != meshDatas.end() ? it->second.lock() : nullptr;
+    if (data) {
+        stats.meshHits++;
+        return data;
+    }
+    stats.meshMisses++;
+    data = ObjMesh::parse(assetObjName, needGenHeightMap, hasTexCoords, isSmoothLight);
+    if (data) {
+        meshDatas[key] = data;
+    }
+    return data;
+}
+
+std::shared_ptr<const SoftTexture> ResourceCache::getSoftTexture(const char *assetPngName) {
+    auto it = softTextures.find(assetPngName);
+    std::shared_ptr<const SoftTexture> texture = it != softTextures.end() ? it->second.lock() : nullptr;
+    if (texture) {
+        stats.textureHits++;
+        return texture;
+    }
+    stats.textureMisses++;
+    uint32_t w = 0, h = 0;
+    void *image = TextureUtils::decodePNG(assetPngName, &w, &h); // 不使用ktx，软件光栅化只采样RGBA8
+    if (image == nullptr) {
+        return nullptr;
+    }
+    std::shared_ptr<SoftTexture> softTexture = std::make_shared<SoftTexture>();
+    softTexture->levels = MipmapGenerator::build(&image, w, h);
+    softTexture->pixels = (uint8_t *)image;
+    softTexture->width = w;
+    softTexture->height = h;
+    softTextures[assetPngName] = softTexture;
+    return softTexture;
+}
+
+void ResourceCache::clear() {
+    meshes.clear();
+    textures.clear();
+    meshDatas.clear();
+    softTextures.clear();
+}
+
+void ResourceCache::logStats() {
+    app_log("resource cache: mesh hits: %u, misses: %u; texture hits: %u, misses: %u\n",
+            stats.meshHits, stats.meshMisses, stats.textureHits, stats.textureMisses);
+}
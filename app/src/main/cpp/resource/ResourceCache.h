@@ -0,0 +1,64 @@
+#ifndef NATIVEACTIVITYDEMO_RESOURCECACHE_H
+#define NATIVEACTIVITYDEMO_RESOURCECACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../view/ObjMesh.h"
+#include "../texture/Texture.h"
+#include "../texture/SoftTexture.h"
+
+struct ResourceCacheStats {
+    uint32_t meshHits;
+    uint32_t meshMisses;
+    uint32_t textureHits;
+    uint32_t textureMisses;
+};
+
+/**
+ * 按asset路径共享mesh和纹理。缓存里只保存weak_ptr，资源的生命周期由使用者的shared_ptr决定，
+ * 最后一个使用者释放后GL对象随之删除，下次请求会重新加载。
+ * 只能在GL线程调用。
+ */
+class ResourceCache {
+public:
+    // 同一个obj用不同的解析参数得到的数据不同，参数也是key的一部分
+    static std::shared_ptr<ObjMesh> getMesh(const char *assetObjName, bool needGenHeightMap,
+                                            bool hasTexCoords, bool isSmoothLight);
+    static std::shared_ptr<Texture> getTexture(const char *assetPngName, TextureOption option = TEXTURE_RGBA8);
+    // 同步加载一批纹理，没有命中的在线程池中并行解码
+    static void getTextures(const char *const *assetPngNames, int count, std::shared_ptr<Texture> *outTextures);
+
+    // 软件光栅化用的cpu数据，同步加载，不调用GL，没有GL context时也可以使用。统计和GL资源的计在一起
+    static std::shared_ptr<const ObjMeshData> getMeshData(const char *assetObjName, bool needGenHeightMap,
+                                                          bool hasTexCoords, bool isSmoothLight);
+    static std::shared_ptr<const SoftTexture> getSoftTexture(const char *assetPngName);
+
+    // 给AssetLoader用：只查询不加载（同样计入命中统计），以及登记异步加载完成的资源
+    static std::string makeMeshKey(const char *assetObjName, bool needGenHeightMap,
+                                   bool hasTexCoords, bool isSmoothLight);
+    // 同一个png按不同的选项加载得到不同的纹理。RGBA8的key就是asset路径，图集也按它查找
+    static std::string makeTextureKey(const char *assetPngName, TextureOption option);
+    static TextureOption parseTextureKey(const std::string &key, std::string *assetPngName);
+    static std::shared_ptr<ObjMesh> findMesh(const std::string &key);
+    static std::shared_ptr<Texture> findTexture(const std::string &key);
+    static void putMesh(const std::string &key, const std::shared_ptr<ObjMesh> &mesh);
+    static void putTexture(const std::string &key, const std::shared_ptr<Texture> &texture);
+
+    // context销毁后调用，丢弃所有的记录
+    static void clear();
+
+    static const ResourceCacheStats &getStats() { return stats; }
+    static void logStats();
+
+private:
+    static std::unordered_map<std::string, std::weak_ptr<ObjMesh>> meshes;
+    static std::unordered_map<std::string, std::weak_ptr<Texture>> textures;
+    static std::unordered_map<std::string, std::weak_ptr<const ObjMeshData>> meshDatas;
+    static std::unordered_map<std::string, std::weak_ptr<const SoftTexture>> softTextures;
+    static ResourceCacheStats stats;
+};
+
+#endif //NATIVEACTIVITYDEMO_RESOURCECACHE_H
@@ -0,0 +1,167 @@
+#include "TextureManager.h"
+#include "AssetLoader.h"
+#include "ResourceCache.h"
+#include "../app_log.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+std::unordered_map<const Texture *, TextureManager::Entry> TextureManager::entries;
+size_t TextureManager::budgetBytes = 64 * 1024 * 1024;
+uint32_t TextureManager::idleFrames = 120;
+uint32_t TextureManager::frame = 0;
+size_t TextureManager::residentBytes = 0;
+size_t TextureManager::peakBytes = 0;
+uint32_t TextureManager::evictions = 0;
+uint32_t TextureManager::reloads = 0;
+
+void TextureManager::track(const std::string &name, const std::shared_ptr<Texture> &texture, bool evictable) {
+    if (!texture || texture->page) {
+        return; // 子纹理的显存由page统计
+    }
+    Entry &entry = entries[texture.get()];
+    if (entry.texture.lock() == texture) {
+        return; // 已经登记过
+    }
+    if (entry.resident) {
+        residentBytes -= entry.bytes; // 地址被新的Texture复用，旧的记录还没清理
+    }
+    entry = Entry();
+    entry.name = name;
+    entry.texture = texture;
+    entry.bytes = texture->bytes;
+    entry.lastUsedFrame = frame;
+    entry.evictable = evictable;
+    residentBytes += entry.bytes;
+    peakBytes = std::max(peakBytes, residentBytes);
+}
+
+bool TextureManager::use(const std::shared_ptr<Texture> &texture) {
+    auto it = entries.find(texture.get());
+    if (it == entries.end() || it->second.texture.lock() != texture) {
+        return true;
+    }
+    Entry &entry = it->second;
+    entry.lastUsedFrame = frame;
+    if (entry.resident) {
+        return true;
+    }
+    if (!entry.reloading) {
+        reload(entry);
+    }
+    return false;
+}
+
+void TextureManager::beginFrame() {
+    frame++;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.texture.expired()) { // 持有者都释放了，GL纹理已经随Texture删除
+            if (it->second.resident) {
+                residentBytes -= it->second.bytes;
+            }
+            it = entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (residentBytes <= budgetBytes) {
+        return;
+    }
+
+    // 最久没有使用的排在前面，最近idleFrames帧内用过的不换出，否则下一帧马上又要加载
+    std::vector<std::pair<uint32_t, const Texture *>> candidates;
+    for (auto &item: entries) {
+        const Entry &entry = item.second;
+        if (entry.evictable && entry.resident && entry.bytes > 0 && frame - entry.lastUsedFrame > idleFrames) {
+            candidates.emplace_back(entry.lastUsedFrame, item.first);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (auto &candidate: candidates) {
+        if (residentBytes <= budgetBytes) {
+            break;
+        }
+        Entry &entry = entries[candidate.second];
+        std::shared_ptr<Texture> texture = entry.texture.lock();
+        if (texture) {
+            evict(entry, texture);
+        }
+    }
+}
+
+void TextureManager::evict(Entry &entry, const std::shared_ptr<Texture> &texture) {
+    GLStateCache::deleteTextures(1, &texture->id);
+    texture->id = 0;
+    entry.resident = false;
+    residentBytes -= entry.bytes;
+    evictions++;
+    app_log("texture manager: evict %s (%.2fMB, unused for %u frames), resident %.2fMB\n", entry.name.c_str(),
+            entry.bytes / 1048576.0f, frame - entry.lastUsedFrame, residentBytes / 1048576.0f);
+}
+
+void TextureManager::reload(Entry &entry) {
+    entry.reloading = true;
+    std::weak_ptr<Texture> target = entry.texture;
+    std::string name;
+    TextureOption option = ResourceCache::parseTextureKey(entry.name, &name);
+    AssetLoader::reloadTexture(name.c_str(), option, [target](const std::shared_ptr<Texture> &fresh) {
+        onReloaded(target, fresh);
+    });
+}
+
+// 新加载的GL纹理交给原来的Texture对象，持有者拿到的shared_ptr不变
+void TextureManager::onReloaded(const std::weak_ptr<Texture> &target, const std::shared_ptr<Texture> &fresh) {
+    std::shared_ptr<Texture> texture = target.lock();
+    if (!texture) {
+        return; // 加载期间持有者都释放了，新纹理随fresh删除
+    }
+    auto it = entries.find(texture.get());
+    if (it == entries.end() || it->second.texture.lock() != texture) {
+        return; // clear之后的
+    }
+    Entry &entry = it->second;
+    texture->id = fresh->id;
+    texture->bytes = fresh->bytes;
+    texture->page = fresh->page;
+    memcpy(texture->uvRect, fresh->uvRect, sizeof(texture->uvRect));
+    fresh->id = 0;
+    entry.bytes = texture->page ? 0 : texture->bytes;
+    entry.resident = true;
+    entry.reloading = false;
+    residentBytes += entry.bytes;
+    peakBytes = std::max(peakBytes, residentBytes);
+    reloads++;
+    app_log("texture manager: reload %s (%.2fMB), resident %.2fMB\n", entry.name.c_str(),
+            entry.bytes / 1048576.0f, residentBytes / 1048576.0f);
+}
+
+void TextureManager::clear() {
+    entries.clear();
+    residentBytes = 0;
+}
+
+TextureManagerStats TextureManager::getStats() {
+    TextureManagerStats stats;
+    stats.budgetBytes = budgetBytes;
+    stats.residentBytes = residentBytes;
+    stats.peakBytes = peakBytes;
+    stats.textures = (uint32_t)entries.size();
+    stats.evictedTextures = 0;
+    for (auto &item: entries) {
+        if (!item.second.resident) {
+            stats.evictedTextures++;
+        }
+    }
+    stats.evictions = evictions;
+    stats.reloads = reloads;
+    return stats;
+}
+
+void TextureManager::logStats() {
+    TextureManagerStats stats = getStats();
+    app_log("texture manager: resident %.2fMB / budget %.2fMB (peak %.2fMB), textures: %u, evicted: %u; "
+            "evictions: %u, reloads: %u\n",
+            stats.residentBytes / 1048576.0f, stats.budgetBytes / 1048576.0f, stats.peakBytes / 1048576.0f,
+            stats.textures, stats.evictedTextures, stats.evictions, stats.reloads);
+}
@@ -0,0 +1,72 @@
+#ifndef NATIVEACTIVITYDEMO_TEXTUREMANAGER_H
+#define NATIVEACTIVITYDEMO_TEXTUREMANAGER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "../texture/Texture.h"
+
+struct TextureManagerStats {
+    size_t budgetBytes;
+    size_t residentBytes; // 当前在显存里的纹理字节数
+    size_t peakBytes;
+    uint32_t textures; // 登记的纹理数，包括被换出的
+    uint32_t evictedTextures; // 当前被换出、还没重新加载的
+    uint32_t evictions;
+    uint32_t reloads;
+};
+
+/**
+ * 纹理的显存预算。登记过的纹理按Texture::bytes统计显存占用，每帧beginFrame检查一次，
+ * 超出预算时把超过idleFrames帧没有使用的纹理按最久未使用的顺序换出：删除GL纹理，Texture对象本身保留，
+ * 持有者不需要知道。绘制前调用use，被换出的纹理通过AssetLoader重新加载，完成后把新的GL纹理放回原来的Texture对象，
+ * 加载完之前use返回false，这段时间里不绘制使用它的模型。
+ * 图集的page一直驻留，只计入占用，不会被换出。只能在GL线程调用。
+ */
+class TextureManager {
+public:
+    static void setBudget(size_t bytes) { budgetBytes = bytes; }
+    static void setIdleFrames(uint32_t frames) { idleFrames = frames; }
+
+    // name是ResourceCache的key，重新加载时从中得到asset路径和加载选项。ResourceCache登记纹理时调用，图集的子纹理不登记
+    static void track(const std::string &name, const std::shared_ptr<Texture> &texture, bool evictable = true);
+    // 记录这一帧用到了纹理，返回纹理是否可以直接绑定。没有登记的纹理总是返回true
+    static bool use(const std::shared_ptr<Texture> &texture);
+    // 每帧绘制前调用
+    static void beginFrame();
+
+    // context销毁后调用，丢弃所有的记录
+    static void clear();
+
+    static TextureManagerStats getStats();
+    static void logStats();
+
+private:
+    struct Entry {
+        std::string name;
+        std::weak_ptr<Texture> texture;
+        size_t bytes = 0;
+        uint32_t lastUsedFrame = 0;
+        bool evictable = true;
+        bool resident = true;
+        bool reloading = false;
+    };
+
+    // 以对象地址为key，Texture释放后地址可能被新的Texture复用，用weak_ptr确认是不是同一个
+    static std::unordered_map<const Texture *, Entry> entries;
+    static size_t budgetBytes;
+    static uint32_t idleFrames;
+    static uint32_t frame;
+    static size_t residentBytes;
+    static size_t peakBytes;
+    static uint32_t evictions;
+    static uint32_t reloads;
+
+    static void evict(Entry &entry, const std::shared_ptr<Texture> &texture);
+    static void reload(Entry &entry);
+    static void onReloaded(const std::weak_ptr<Texture> &target, const std::shared_ptr<Texture> &fresh);
+};
+
+#endif //NATIVEACTIVITYDEMO_TEXTUREMANAGER_H
@@ -0,0 +1,331 @@
+#include "DemoApp.h"
+#include <cstring>
+#include "DemoScene.h"
+#include "../app_log.h"
+#include "../gles/GLESEngine.h"
+#include "../gles/GLStateCache.h"
+#include "../profiler/GpuTimer.h"
+#include "../profiler/Profiler.h"
+#include "../regression/GoldenRunner.h"
+#include "../render/RenderBackend.h"
+#include "../render/RenderQueue.h"
+#include "../render/SoftRasterizer.h"
+#include "../resource/AssetLoader.h"
+#include "../resource/ResourceCache.h"
+#include "../resource/TextureManager.h"
+#include "../shader/BaseShader.h"
+#include "../shader/ProgramBinaryCache.h"
+#include "../texture/TextureUploader.h"
+#include "../texture/TextureUtils.h"
+#include "../utils/CoordinatesUtils.h"
+#include "../utils/FrameStats.h"
+#include "../utils/Utils.h"
+
+static RenderQueue renderQueue;
+static std::unique_ptr<SoftRasterizer> softRasterizer;
+static uint32_t frameCount = 0;
+static long lastFrameTimeUS = 0;
+static FrameStats frameStats; // 统计周期内的帧时间
+static const long UPLOAD_BUDGET_US = 4000; // 每帧用于上传异步加载结果的时间
+static const size_t UPLOAD_BUDGET_BYTES = 2 * 1024 * 1024; // 每帧通过PBO上传的纹理数据量
+static const size_t TEXTURE_BUDGET_BYTES = 64 * 1024 * 1024; // 超出后换出一段时间没用到的纹理
+static const uint32_t TEXTURE_IDLE_FRAMES = 120;
+
+std::string DemoApp::dataPath = ".";
+std::vector<std::shared_ptr<Shape>> DemoApp::shapes;
+std::unique_ptr<WindowProvider> DemoApp::window;
+int32_t DemoApp::width = 0;
+int32_t DemoApp::height = 0;
+
+DebugDraw &DemoApp::getDebugDraw() {
+    return renderQueue.getDebugDraw();
+}
+
+void DemoApp::startWindow(std::unique_ptr<WindowProvider> newWindow) {
+    window = std::move(newWindow);
+    if (!RenderBackend::isSoft()) {
+        GLESEngine_init(window->getNativeWindow());
+        GLStateCache::invalidate(); // 新的context，之前记录的状态都无效了
+    }
+    width = window->getWidth();
+    height = window->getHeight();
+    initScene();
+    drawFrame(); // 第一帧只有已经在缓存里的资源
+}
+
+void DemoApp::stopWindow() {
+    releaseScene();
+    if (!RenderBackend::isSoft()) {
+        GLESEngine_destroy();
+        GLStateCache::invalidate();
+    }
+    window.reset();
+}
+
+void DemoApp::drawFrame() {
+    Profiler::beginFrame();
+    GpuTimer::beginFrame();
+    bool soft = RenderBackend::isSoft();
+    if (soft) {
+        // 软件光栅化的渲染目标：窗口的buffer，或者headless模式的内存
+        SoftTarget target;
+        if (!window || !window->lock(target)) {
+            return;
+        }
+        softRasterizer->setTarget(target);
+        GLfloat clearColor[4] = {0.7f, 0.7f, 0.7f, 1.0f}; // 和GL模式一样
+        softRasterizer->clear(clearColor);
+    } else {
+        {
+            PROFILE_ZONE("upload");
+            AssetLoader::pump(UPLOAD_BUDGET_US);
+            TextureManager::beginFrame();
+        }
+
+        PROFILE_GPU_ZONE("clear");
+        glClearColor(0.7f, 0.7f, 0.7f, 1.0f);
+        glClearDepthf(1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        GLStateCache::resetStats();
+    }
+    {
+        PROFILE_ZONE("animate");
+        DemoScene::animate(shapes);
+    }
+    {
+        PROFILE_ZONE("submit");
+        for (size_t i = 0; i < shapes.size(); i++) {
+            if (shapes[i] && soft) {
+                shapes[i]->submitSoft(*softRasterizer);
+            } else if (shapes[i]) {
+                shapes[i]->submit(renderQueue);
+            }
+        }
+    }
+    if (soft) {
+        PROFILE_ZONE("soft flush");
+        softRasterizer->flush();
+        window->unlockAndPost();
+    } else {
+        renderQueue.flush();
+    }
+
+    if (++frameCount % 300 == 0 && soft) {
+        const SoftRasterizerStats &stats = softRasterizer->getStats();
+        app_log("soft rasterizer: draws: %u, triangles: %u(clipped: %u) -> %u, binned: %u, shaded pixels: %u; "
+                "setup: %.2fms, raster: %.2fms\n", stats.draws, stats.triangles, stats.clippedTriangles,
+                stats.rasterTriangles, stats.binnedTriangles, stats.shadedPixels, stats.setupMs, stats.rasterMs);
+    } else if (frameCount % 300 == 0) {
+        const RenderQueueStats &stats = renderQueue.getStats();
+        app_log("render queue: packets: %u, state changes: %u(submit order) -> %u(sorted)\n",
+                stats.packets, stats.stateChangesUnsorted, stats.stateChangesSorted);
+        const GLStateCacheStats &cacheStats = GLStateCache::getStats();
+        app_log("gl state cache: issued: %u, skipped: %u\n", cacheStats.issued, cacheStats.skipped);
+        TextureManager::logStats();
+    }
+
+    if (!soft) {
+        PROFILE_ZONE("swap");
+        GLESEngine_refresh();
+    }
+    Profiler::endFrame();
+
+    long nowUS = Utils::getCurrTimeUS();
+    if (lastFrameTimeUS != 0) {
+        frameStats.add(nowUS - lastFrameTimeUS);
+    }
+    lastFrameTimeUS = nowUS;
+    if (frameCount % 300 == 0) {
+        frameStats.log("frame time");
+        frameStats.clear();
+        if (Profiler::isEnabled()) {
+            Profiler::logStats();
+        }
+    }
+}
+
+/**
+ * 渲染目标准备好之后调用：设置屏幕参数，准备shader、纹理，创建场景里的模型。
+ * GL时宽高取自当前的surface，软件光栅化时由调用者设置。
+ */
+void DemoApp::initScene() {
+    bool soft = RenderBackend::isSoft();
+    if (!soft) {
+        width = GLESEngine_get_width();
+        height = GLESEngine_get_height();
+    }
+    int32_t viewport[4];
+    GLESEngine_compute_viewport(width, height, viewport);
+
+    CoordinatesUtils::screenW = width;
+    CoordinatesUtils::screenH = height;
+    CoordinatesUtils::screenS = width > height ? height : width;
+    CoordinatesUtils::screenL = width > height ? width : height;
+    CoordinatesUtils::glesViewportSize = viewport[2];
+
+    GLfloat lightPosition[3] = {0.0f, 3.0f, -10.0f}; // 光源位置
+    GLfloat lightColor[3] = {1.0f, 1.0f, 1.0f}; // 光源颜色
+    if (soft) {
+        if (!softRasterizer) {
+            softRasterizer.reset(new SoftRasterizer());
+        }
+        softRasterizer->setViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        softRasterizer->setLight(lightPosition, lightColor);
+    } else {
+        ProgramBinaryCache::init(dataPath.c_str());
+        GpuTimer::init();
+
+        // 提前准备场景用到的shader组合，避免第一次绘制时编译卡顿
+        BaseShader::getProgram(BaseShader::DEFAULT_FEATURES); // 模型
+        BaseShader::getProgram(SHADER_TRANSFORM | SHADER_TEXTURED); // 天空盒
+        BaseShader::getProgram(SHADER_ALPHA | SHADER_VERTEX_COLOR); // DebugDraw
+        TextureUtils::loadSimpleTexture(); // 加载一些纯色的纹理，当颜色用
+        TextureUploader::setFrameBudget(UPLOAD_BUDGET_BYTES);
+        TextureManager::setBudget(TEXTURE_BUDGET_BYTES);
+        TextureManager::setIdleFrames(TEXTURE_IDLE_FRAMES);
+        renderQueue.setLight(lightPosition, lightColor);
+
+        // 深度测试的基准,注意1.0代表从近裁剪面到远裁剪面 这一段范围！！并不是指Z轴的1个单位
+        // 深度，是一个normalized的值，范围是 0-1(不是z轴坐标)，对应Z轴是从近裁剪面到远裁剪面
+        // 所以这里的 1.0f 指的是，深度缓冲区中远裁剪面以内全部清除
+        glClearDepthf(1.0f);
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    DemoScene::build(shapes);
+}
+
+/**
+ * GL context销毁之前调用，释放场景和所有GL资源。
+ */
+void DemoApp::releaseScene() {
+    if (RenderBackend::isSoft()) { // 没有GL资源
+        shapes.clear();
+        ResourceCache::clear();
+        return;
+    }
+    AssetLoader::cancelAll();
+    TextureUploader::release();
+    shapes.clear();
+    renderQueue.release();
+    ResourceCache::clear();
+    TextureManager::clear();
+
+    BaseShader::deletePrograms();
+    TextureUtils::deleteSimpleTexture();
+    GpuTimer::release();
+}
+
+/**
+ * headless模式的渲染目标：软件光栅化时是内存，GL时是pbuffer。失败返回false
+ */
+bool DemoApp::beginHeadless(int32_t w, int32_t h) {
+    if (RenderBackend::isSoft()) { // 渲染到内存，不需要EGL
+        window.reset(new MemoryWindowProvider(w, h));
+        width = w;
+        height = h;
+        return true;
+    }
+    if (GLESEngine_init_headless(w, h) != 0) {
+        app_log("headless: init failed\n");
+        GLESEngine_destroy();
+        return false;
+    }
+    GLStateCache::invalidate();
+    return true;
+}
+
+void DemoApp::endHeadless() {
+    releaseScene();
+    if (RenderBackend::isSoft()) {
+        window.reset();
+    } else {
+        GLESEngine_destroy();
+        GLStateCache::invalidate();
+    }
+}
+
+// 创建场景，一直画帧直到资源全部加载完，返回画了多少帧
+int DemoApp::loadScene() {
+    initScene();
+    int loadFrames = 0;
+    while (AssetLoader::hasPending()) {
+        drawFrame();
+        loadFrames++;
+    }
+    return loadFrames;
+}
+
+// 当前帧的像素，RGBA8，从上到下按行排列
+void DemoApp::readFrame(void *rgba) {
+    if (RenderBackend::isSoft()) {
+        const std::vector<uint32_t> &pixels = ((MemoryWindowProvider *) window.get())->getPixels();
+        memcpy(rgba, pixels.data(), pixels.size() * sizeof(uint32_t));
+    } else {
+        GLESEngine_read_pixels(rgba);
+    }
+}
+
+bool DemoApp::runHeadless(const HeadlessOptions &options) {
+    if (!beginHeadless(options.width, options.height)) {
+        return false;
+    }
+    long loadStartUS = Utils::getCurrTimeUS();
+    // 加载过程不计入统计
+    int loadFrames = loadScene();
+    app_log("headless: assets loaded in %.1fms, %d frames\n", (Utils::getCurrTimeUS() - loadStartUS) / 1000.0f,
+            loadFrames);
+    Profiler::reset();
+
+    FrameStats stats;
+    for (int i = 0; i < options.frames; i++) {
+        long startUS = Utils::getCurrTimeUS();
+        drawFrame();
+        stats.add(Utils::getCurrTimeUS() - startUS);
+    }
+    stats.log("headless frame time");
+    if (Profiler::isEnabled()) {
+        Profiler::logStats();
+    }
+
+    if (options.readback) {
+        std::vector<uint8_t> pixels((size_t)width * height * 4);
+        readFrame(pixels.data());
+        std::string path = dataPath + "/headless.png";
+        if (TextureUtils::encodePNG(path.c_str(), pixels.data(), (uint32_t)width, (uint32_t)height)) {
+            app_log("headless: last frame saved to %s\n", path.c_str());
+        }
+    }
+
+    endHeadless();
+    return true;
+}
+
+bool DemoApp::runGolden(bool record, const std::string &goldenDir, bool *passed) {
+    if (!beginHeadless(GOLDEN_WIDTH, GOLDEN_HEIGHT)) {
+        return false;
+    }
+    GoldenOptions options;
+    options.backend = RenderBackend::isSoft() ? "soft" : "gles";
+    options.width = GOLDEN_WIDTH;
+    options.height = GOLDEN_HEIGHT;
+    options.goldenDir = goldenDir + "/" + options.backend;
+    options.outputDir = dataPath + "/golden";
+    options.record = record;
+
+    GoldenHooks hooks;
+    hooks.resetScene = []() {
+        if (!shapes.empty()) {
+            releaseScene();
+        }
+        loadScene();
+    };
+    hooks.drawFrame = drawFrame; // pbuffer上GLESEngine_refresh会glFinish，计时包括GPU完成这一帧
+    hooks.readPixels = readFrame;
+    *passed = GoldenRunner::run(shapes, hooks, options);
+
+    endHeadless();
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef NATIVEACTIVITYDEMO_DEMOAPP_H
+#define NATIVEACTIVITYDEMO_DEMOAPP_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "../platform/WindowProvider.h"
+#include "../render/DebugDraw.h"
+#include "../view/Shape.h"
+
+struct HeadlessOptions {
+    int frames;
+    int32_t width;
+    int32_t height;
+    bool readback; // 最后一帧保存到<dataPath>/headless.png
+};
+
+/**
+ * 和平台无关的demo主体：创建和释放场景、画帧、headless测试和golden image回归测试。
+ * android_main和开发机上的入口都只负责平台相关的部分（事件、窗口、参数），然后调用这里。
+ * 渲染后端由RenderBackend决定，资源通过Assets读取，都要在调用之前设置好。只能在一个线程里调用。
+ */
+class DemoApp {
+public:
+    // 可写的目录，保存program binary缓存和测试输出
+    static void setDataPath(const std::string &path) { dataPath = path; }
+
+    // 窗口可用时调用：GL时创建window surface，然后创建场景并画第一帧
+    static void startWindow(std::unique_ptr<WindowProvider> window);
+    // 窗口销毁之前调用，释放场景和GL资源
+    static void stopWindow();
+
+    // 先上传异步加载完成的资源，再画一帧
+    static void drawFrame();
+
+    // 不创建窗口，在pbuffer（软件光栅化时是内存）上等资源全部加载完，跑固定的帧数，输出帧时间统计。
+    // 初始化失败返回false
+    static bool runHeadless(const HeadlessOptions &options);
+    // 固定尺寸的headless渲染，和<goldenDir>/<后端>/里的图片比较，record时只录制，见GoldenRunner。
+    // golden是测试数据，不在assets里。初始化失败返回false，比较的结果在passed里
+    static bool runGolden(bool record, const std::string &goldenDir, bool *passed);
+
+    static std::vector<std::shared_ptr<Shape>> &getShapes() { return shapes; }
+    static DebugDraw &getDebugDraw();
+
+    static const int GOLDEN_WIDTH = 270;
+    static const int GOLDEN_HEIGHT = 480;
+
+private:
+    static std::string dataPath;
+    static std::vector<std::shared_ptr<Shape>> shapes;
+    static std::unique_ptr<WindowProvider> window; // 软件光栅化的窗口和headless的内存buffer
+    static int32_t width;
+    static int32_t height;
+
+    static void initScene();
+    static void releaseScene();
+    static bool beginHeadless(int32_t w, int32_t h);
+    static void endHeadless();
+    static int loadScene();
+    static void readFrame(void *rgba);
+};
+
+#endif //NATIVEACTIVITYDEMO_DEMOAPP_H
@@ -0,0 +1,152 @@
+#include "DemoScene.h"
+#include <cmath>
+#include "../view/ObjModel.h"
+#include "../view/SkyBox.h"
+#include "../view/InstancedModel.h"
+#include "../resource/ResourceCache.h"
+#include "../utils/libglm0_9_6_3/glm/ext.hpp"
+
+void DemoScene::build(std::vector<std::shared_ptr<Shape>> &shapes) {
+    using namespace std;
+    // blend跟物体渲染顺序有关，需要后渲染半透明物体
+//                shapes[0] = new Cube();
+//                shapes[0] = new Triangles();
+    shared_ptr<ObjModel> mountain = make_shared<ObjModel>("blenderObjs/mountain.png",
+                                                       "mountain.png", true, true, false);
+    mountain->scaleBy(9, 1.5, 9); // 长宽放大10倍
+    shapes.push_back(mountain);
+
+    // 房子的贴图不透明，用16位格式
+    shared_ptr<Shape> tower = make_shared<ObjModel>("blenderObjs/tower.png",
+                                                    "tower.png", false, true, false, TEXTURE_16BIT);
+    tower->moveBy(5.66, 3.51, -17.21);
+    shapes.push_back(tower);
+
+    shared_ptr<Shape> moodhouse = make_shared<ObjModel>("blenderObjs/moodhouse.png",
+                                                        "moodhouse.png", false, true, false,
+                                                        TEXTURE_16BIT);
+    moodhouse->rotateBy(0, 0.5, 0);
+    moodhouse->scaleBy(-0.8, -0.8, -0.8);
+    shapes.push_back(moodhouse);
+
+    shared_ptr<Shape> moon = make_shared<ObjModel>("blenderObjs/moon.png",
+                                                   "moon.png", false, true, false);
+    moon->moveBy(12, 12, 30);
+    shapes.push_back(moon);
+
+    shared_ptr<Shape> oldHouse = make_shared<ObjModel>("blenderObjs/oldhouse2.png",
+                                                       "oldhouse2.png", false, true, false,
+                                                       TEXTURE_16BIT);
+    oldHouse->moveBy(10.11f, 3.78f, 7.25f);
+    oldHouse->rotateBy(0, -0.3f, 0);
+    oldHouse->scaleBy(1.2f, 1.2f, 1.2f);
+    shapes.push_back(oldHouse);
+
+    shared_ptr<Shape> skybox = make_shared<SkyBox>();
+    skybox->scaleBy(40.0f, 40.0f, 40.0f);
+    shapes.push_back(skybox);
+
+#ifdef INSTANCING_STRESS_TEST
+    // 5000个相同的圆锥，一次实例化绘制
+    shared_ptr<InstancedModel> cones = make_shared<InstancedModel>("blenderObjs/cone.png",
+                                                                   "yellow.png", true, false);
+    shapes.push_back(cones);
+#endif
+
+    shared_ptr<Shape> monkey = make_shared<ObjModel>("blenderObjs/monkey.png",
+                                                     "brown.png", false, true, false);
+    monkey->moveBy(0, 0.294f, 0); // 模型的-y为-0.98
+    monkey->rotateBy(0, 3.14f, 0);
+    monkey->scaleBy(-0.7f, -0.7f, -0.7f); // 缩小为原来的3/10
+    shapes.push_back(monkey);
+    // 测试高度准确性
+//                shared_ptr<Shape> cocacola = make_shared<ObjModel>("blenderObjs/cocacola.png",
+//                                                                   "cocacola.png", false, true, false);
+//                cocacola->moveBy(0, 0.24656f, 0); // 模型的-y为-1.232813
+//                cocacola->scaleBy(-0.95f, -0.8f, -0.95f); // 高缩小为原来的2/10
+//                shapes.push_back(cocacola);
+
+    ObjModel *mountainPtr = mountain.get(); // 回调由mountain持有，不能再持有它的shared_ptr
+    vector<shared_ptr<Shape>> *shapesPtr = &shapes;
+    weak_ptr<Shape> weakMoodhouse = moodhouse;
+#ifdef INSTANCING_STRESS_TEST
+    weak_ptr<InstancedModel> weakCones = cones;
+#endif
+    mountain->setOnReady([=]() {
+        shared_ptr<Shape> moodhouse = weakMoodhouse.lock();
+        if (moodhouse) {
+            moodhouse->moveBy(0, mountainPtr->getMapHeight(0, 18), 18); // Shape的move*To是空实现
+        }
+#ifdef INSTANCING_STRESS_TEST
+        shared_ptr<InstancedModel> cones = weakCones.lock();
+        for (int x = 0; cones && x < 100; x++) {
+            for (int z = 0; z < 50; z++) {
+                GLfloat posX = -25.0f + x * 0.5f;
+                GLfloat posZ = -25.0f + z * 1.0f;
+                glm::mat4 instanceMat4 = glm::translate(glm::mat4(1),
+                        glm::vec3(posX, mountainPtr->getMapHeight(posX, posZ) + 0.2f, posZ)); // 模型的-y为-1
+                instanceMat4 = glm::scale(instanceMat4, glm::vec3(0.2f, 0.2f, 0.2f));
+                cones->addInstance(instanceMat4);
+            }
+        }
+#endif
+        GLfloat initHeight = mountainPtr->getMapHeight(0, 0);
+        for (int i = 0; i < (int)shapesPtr->size() - 1; i++) {
+            if ((*shapesPtr)[i]) {
+                (*shapesPtr)[i]->worldMoveYTo(initHeight);
+            }
+        }
+        ResourceCache::logStats();
+    });
+}
+
+void DemoScene::animate(std::vector<std::shared_ptr<Shape>> &shapes) {
+    if (shapes.size() > MOON_INDEX && shapes[MOON_INDEX]) {
+        shapes[MOON_INDEX]->rotateBy(0.0f, 1.0f / 60.0f, 0.0f);
+    }
+}
+
+void DemoScene::drag(std::vector<std::shared_ptr<Shape>> &shapes, float transX, float transY,
+                     float rotateYradian, int fingers) {
+    if (shapes.size() < 2 || !shapes[0]) {
+        return;
+    }
+    // 获取该位置的高度和法向量
+    GLfloat height = 0;
+    glm::vec3 normal(0, 1.0f, 0);
+    GLfloat transXYZ[3];
+    shapes[0]->getTranslate(transXYZ);
+    height = shapes[0]->getMapHeight(transXYZ[0], transXYZ[2]);
+    if (transXYZ[0] >= 3.5f && transXYZ[0] <= 7.7f && transXYZ[2] >= -19.3f && transXYZ[2] <= -15.1f) {
+        height = 3.51f + 7.648166f; // tower的区域和高度
+    }
+    if (transXYZ[0] >= 12.0f-1.723f && transXYZ[0] <= 12.0f+1.723f && transXYZ[2] >= 30.0f-1.723f && transXYZ[2] <= 30.0f+1.723f) {
+        height = 12.0f + 1.721207f; // moon的区域和高度
+    }
+//        app_log("map location: x: %f, z: %f, y: %f, height: %f\n", transXYZ[0], transXYZ[2], transXYZ[1], height);
+    shapes[0]->getMapNormal(transXYZ[0], transXYZ[2], normal);
+
+    for (size_t i = 0; i + 1 < shapes.size(); i++) {
+        if (shapes[i]) {
+            if (fingers == 1) {
+                // 透视模式下乘5，视角是60度，观察者距离是10，感觉是10的一半
+                shapes[i]->worldMoveBy(transX * 5, 0, -transY * 5);
+                shapes[i]->worldMoveYTo(height);
+            } else {
+                if (fabsf(transX) > fabsf(transY)) {
+                    shapes[i]->worldRotateBy(0, -rotateYradian, 0); // 对于矩阵变换来说，轴正向朝向自己，顺时针转为正
+                } else {
+                    shapes[i]->worldMoveBy(0, -transY * 5, 0);
+                }
+            }
+        }
+    }
+    // 设置角色的朝向和倾斜度
+    float directionYradian = atan2f(transY, transX) - 1.57f;
+    shapes[shapes.size() - 1]->rotateYTo(directionYradian);
+
+    float rotateX = atan2f(normal[2], normal[1]);
+    shapes[shapes.size() - 1]->rotateXTo(rotateX);
+    float rotateZ = atan2f(normal[0], normal[1]);
+    shapes[shapes.size() - 1]->rotateZTo(-rotateZ);
+}
@@ -0,0 +1,27 @@
+#ifndef NATIVEACTIVITYDEMO_DEMOSCENE_H
+#define NATIVEACTIVITYDEMO_DEMOSCENE_H
+
+#include <memory>
+#include <vector>
+#include "../view/Shape.h"
+
+/**
+ * main.cpp里的演示场景：山体、塔、木屋、月亮、老房子、天空盒、猴子，以及触摸对它们的操作。
+ * 窗口模式、headless模式和golden image回归测试用的是同一份场景。
+ * shapes[0]是山体，最后一个是猴子（角色），移动世界时不包括它。
+ */
+class DemoScene {
+public:
+    static const int MOON_INDEX = 3;
+
+    // 模型都是异步加载的，加载完成后才会出现。依赖山体高度的摆放在山体的onReady里，shapes需要一直有效
+    static void build(std::vector<std::shared_ptr<Shape>> &shapes);
+    // 每帧的动画：月亮自转
+    static void animate(std::vector<std::shared_ptr<Shape>> &shapes);
+    // 拖动：transX、transY是gles坐标下的距离（y向下为正），单指时贴着地面移动世界，
+    // 双指时横向拖动绕y轴旋转rotateYradian，纵向拖动升降。之后角色朝向拖动方向，并随地面倾斜
+    static void drag(std::vector<std::shared_ptr<Shape>> &shapes, float transX, float transY,
+                     float rotateYradian, int fingers);
+};
+
+#endif //NATIVEACTIVITYDEMO_DEMOSCENE_H
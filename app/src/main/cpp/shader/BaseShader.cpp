@@ -3,89 +3,206 @@
 //
 
 #include "BaseShader.h"
+#include <algorithm>
+#include <iterator>
+#include "ProgramBinaryCache.h"
 #include "../utils/ShaderUtils.h"
+#include "../gles/GLStateCache.h"
+#include "../utils/Utils.h"
+#include "../app_log.h"
 
 // three types of the precision: lowp, mediump and highp.
 // for vertex, if the precision is not specified, it is consider to be highest (highp).
-static const char *vert = "#version 300 es\n"
-                          "layout(location = 0) in vec4 vPosition;\n"
+// 两个shader中同名的uniform block必须完全一致，包括精度，所以block成员都显式声明为highp。
+#define UNIFORM_BLOCKS \
+    "layout(std140) uniform FrameBlock {\n" /* 每帧更新一次 */ \
+    "    highp vec4 lightPosition;\n" /* 光源位置，只用xyz */ \
+    "    highp vec4 lightColor;\n" /* 光源颜色，只用xyz */ \
+    "};\n" \
+    "layout(std140) uniform ObjectBlock {\n" /* 每次绘制一份，从ring buffer中分配 */ \
+    "    highp mat4 transformMat4;\n" \
+    "    highp vec4 modelColorFactor;\n" /* 物体本身颜色的乘法因子，实现控制物体的颜色和透明度 */ \
+    "    highp vec4 uvRect;\n" /* 纹理在图集中的区域：xy是起点，zw是缩放，不在图集中时为(0, 0, 1, 1) */ \
+    "};\n"
+
+// 源码里没有#version，编译时在最前面加上#version和特性对应的#define，见makeSource
+static const char *vert = "layout(location = 0) in vec4 vPosition;\n"
+                          "#ifdef TEXTURED\n"
                           "layout(location = 1) in vec2 vTexCoord;\n"
-                          "layout(location = 2) in vec3 vNormal;\n"
-
-                          "uniform int transformEnabled;\n" // transform开关
-                          "uniform mat4 transformMat4;\n"
-
                           "out vec2 texCoord;\n" // send to next stage(frag shader)
+                          "#endif\n"
+                          "#ifdef LIT\n"
+                          "layout(location = 2) in vec3 vNormal;\n"
                           "out vec3 modelNormal;\n"
                           "out vec3 modelVertex;\n"
+                          "#endif\n"
+                          "#ifdef TRANSFORM\n"
+                          "layout(location = 3) in mat4 instanceMat4;\n" // 实例化绘制时每个实例的model矩阵，占3-6四个location
+                          "#endif\n"
+                          "#ifdef VERTEX_COLOR\n"
+                          "layout(location = 7) in vec4 vColor;\n"
+                          "out vec4 vertexColor;\n"
+                          "#endif\n"
+
+                          UNIFORM_BLOCKS
 
                           "void main() {\n"
+                          "#ifdef TRANSFORM\n" // 在shader里进行缩放、旋转、平移操作等
+                          "    gl_Position = transformMat4 * instanceMat4 * vPosition;\n"
+                          "#else\n"
                           "    gl_Position = vPosition;\n"
-                          "    modelNormal = normalize(vNormal);\n" // 法向量，进行归一化，片元中仍需要。
-
-                          "    if (transformEnabled == 1) {\n" // 是否在shader里进行缩放、旋转、平移操作等
-                          "        gl_Position = transformMat4 * vPosition;\n"
-                          "        modelNormal = vec3(transformMat4 * vec4(modelNormal, 0.0));\n"
-                          "    }\n"
+                          "#endif\n"
 
+                          "#ifdef LIT\n"
+                          "    modelNormal = normalize(vNormal);\n" // 法向量，进行归一化，片元中仍需要。
+                          "#ifdef TRANSFORM\n"
+                          "    modelNormal = vec3(transformMat4 * instanceMat4 * vec4(modelNormal, 0.0));\n"
+                          "#endif\n"
                           "    modelVertex = vec3(gl_Position[0], gl_Position[1], gl_Position[2]);\n"
-                          "    texCoord = vTexCoord;\n"
+                          "#endif\n"
+
+                          "#ifdef TEXTURED\n"
+                          "    texCoord = uvRect.xy + vTexCoord * uvRect.zw;\n"
+                          "#endif\n"
+                          "#ifdef VERTEX_COLOR\n"
+                          "    vertexColor = vColor;\n"
+                          "#endif\n"
                           "}\n";
 
 // for fragment shader, Specifying the precision is compulsory.
-static const char *frag = "#version 300 es\n"
-                          "precision mediump float;\n"
+static const char *frag = "precision mediump float;\n"
 
+                          "#ifdef TEXTURED\n"
                           "in vec2 texCoord;\n" // 纹理坐标
+                          "uniform sampler2D textureUnit;\n"
+                          "#endif\n"
+                          "#ifdef LIT\n"
                           "in vec3 modelNormal;\n" // 法向量
                           "in vec3 modelVertex;\n" // 变换之后的顶点坐标
+                          "#endif\n"
+                          "#ifdef VERTEX_COLOR\n"
+                          "in vec4 vertexColor;\n"
+                          "#endif\n"
 
-                          "uniform sampler2D textureUnit;\n"
-                          "uniform vec4 modelColorFactor;\n" // 物体本身颜色的乘法因子，实现控制物体的颜色和透明度
-                          "uniform vec3 lightPosition;\n" // 光源位置
-                          "uniform vec3 lightColor;\n" // 光源颜色
+                          UNIFORM_BLOCKS
 
                           "out vec4 fColor;\n"
 
                           "void main() {\n"
+                          "#ifdef TEXTURED\n"
+                          "    vec4 color = texture(textureUnit, texCoord) * modelColorFactor;\n"
+                          "#else\n"
+                          "    vec4 color = modelColorFactor;\n"
+                          "#endif\n"
+                          "#ifdef VERTEX_COLOR\n"
+                          "    color *= vertexColor;\n"
+                          "#endif\n"
+
+                          "#ifdef LIT\n"
                           "    vec3 nNormal = normalize(modelNormal);\n"
-                          "    vec3 nLight = normalize(lightPosition - modelVertex);\n"
+                          "    vec3 nLight = normalize(lightPosition.xyz - modelVertex);\n"
                                // 漫反射光
                           "    float cosAngle = max(0.0, dot(nNormal, nLight));\n"
-                          "    vec4 diffuse = vec4(cosAngle * lightColor, 1.0);\n"
+                          "    vec4 diffuse = vec4(cosAngle * lightColor.xyz, 1.0);\n"
                                // 镜面反射光
                           "    vec3 nViewerPosition = vec3(0.0, 0.0, -1.0);\n"
                           "    vec3 nH = normalize(nLight + nViewerPosition);\n"
                           "    float shininessFactor = 40.0;\n" // 确定高光区域大小，值越大区域越小，1-200
                           "    float sIntensity = pow(max(0.0, dot(nNormal, nH)), shininessFactor);\n"
-                          "    vec4 specular = vec4(sIntensity * lightColor, 1.0);\n"
+                          "    vec4 specular = vec4(sIntensity * lightColor.xyz, 1.0);\n"
 
                           "    vec4 factor68 = vec4(0.68, 0.68, 0.68, 1.0);\n" // 透明度为1，物体本身提供100%的透明度
                           "    vec4 factor17 = vec4(0.17, 0.17, 0.17, 0.0);\n" // 透明度为0，光照不提供透明度通道
                           "    vec4 factor15 = vec4(0.15, 0.15, 0.15, 0.0);\n" // 透明度为0，光照不提供透明度通道
-                          "    fColor = texture(textureUnit, texCoord) * modelColorFactor * factor68 + diffuse * factor17 + specular * factor15;\n"
+                          "    color = color * factor68 + diffuse * factor17 + specular * factor15;\n"
+                          "#endif\n"
+
+                          "#ifdef ALPHA\n"
+                          "    fColor = color;\n"
+                          "#else\n"
+                          "    fColor = vec4(color.rgb, 1.0);\n" // 不混合，alpha不需要计算
+                          "#endif\n"
                           "}\n";
 
-GLuint BaseShader::vertShader = 0;
-GLuint BaseShader::fragShader = 0;
-GLuint BaseShader::program = 0;
+std::unique_ptr<ShaderReflection> BaseShader::shaders[VARIANT_COUNT];
+bool BaseShader::failed[VARIANT_COUNT];
+uint32_t BaseShader::generation = 0;
+
+std::string BaseShader::makeSource(const char *body, uint32_t features) {
+    std::string source = "#version 300 es\n";
+    if (features & SHADER_TRANSFORM) source += "#define TRANSFORM\n";
+    if (features & SHADER_LIT) source += "#define LIT\n";
+    if (features & SHADER_TEXTURED) source += "#define TEXTURED\n";
+    if (features & SHADER_ALPHA) source += "#define ALPHA\n";
+    if (features & SHADER_VERTEX_COLOR) source += "#define VERTEX_COLOR\n";
+    source += body;
+    return source;
+}
 
-GLuint BaseShader::getSingletonProgram() {
-    if (program == 0) {
-        vertShader = get_compiled_shader_vert(vert);
-        fragShader = get_compiled_shader_frag(frag);
+void BaseShader::createProgram(uint32_t features) {
+    long startUS = Utils::getCurrTimeUS();
+    // 每种组合的源码不同，program binary的key（源码的hash）自然区分开
+    std::string vertSource = makeSource(vert, features);
+    std::string fragSource = makeSource(frag, features);
+    GLuint program = ProgramBinaryCache::load(vertSource.c_str(), fragSource.c_str());
+    bool fromCache = program != 0;
+    if (!fromCache) {
+        GLuint vertShader = get_compiled_shader_vert(vertSource.c_str());
+        GLuint fragShader = get_compiled_shader_frag(fragSource.c_str());
         program = linkShader(vertShader, fragShader);
+        // 链接之后shader对象不再需要，program删除时随之释放
+        glDeleteShader(vertShader);
+        glDeleteShader(fragShader);
+        ProgramBinaryCache::save(program, vertSource.c_str(), fragSource.c_str());
+    }
+    // uniform block的binding、sampler的值不一定保存在binary里，两种方式得到的program都重新设置
+    if (program != 0) {
+        shaders[features].reset(new ShaderReflection(program)); // 之后按名字查询不再访问驱动
+        const ShaderReflection &reflection = *shaders[features];
+        // uniform block绑定到固定的binding point，之后只需要glBindBufferRange切换数据。
+        // 不带光照的组合没有用到FrameBlock，编译器会去掉它
+        GLuint frameBlock = reflection.getUniformBlockIndex("FrameBlock");
+        if (frameBlock != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program, frameBlock, FRAME_BLOCK_BINDING);
+        }
+        GLuint objectBlock = reflection.getUniformBlockIndex("ObjectBlock");
+        if (objectBlock != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program, objectBlock, OBJECT_BLOCK_BINDING);
+        }
+        GLStateCache::useProgram(program);
+        GLStateCache::uniform1i(reflection.getUniformLocation("textureUnit"), 0); // 没有纹理时location为-1，直接忽略
+        // 非实例化的vao不会启用instanceMat4，这时取的是通用属性值，设置为单位矩阵。
+        // 通用属性值属于context的状态，不随vao切换，设置一次即可。
+        glVertexAttrib4f(INSTANCE_MAT4_LOCATION, 1.0f, 0.0f, 0.0f, 0.0f);
+        glVertexAttrib4f(INSTANCE_MAT4_LOCATION + 1, 0.0f, 1.0f, 0.0f, 0.0f);
+        glVertexAttrib4f(INSTANCE_MAT4_LOCATION + 2, 0.0f, 0.0f, 1.0f, 0.0f);
+        glVertexAttrib4f(INSTANCE_MAT4_LOCATION + 3, 0.0f, 0.0f, 0.0f, 1.0f);
     }
-    return program;
+    app_log("shader warm-up: features 0x%x, %.2fms (%s)\n", features, (Utils::getCurrTimeUS() - startUS) / 1000.0f,
+            fromCache ? "program binary" : "compile and link");
 }
 
-void BaseShader::deleteSingletonProgram() {
-    if (program != 0) {
-        glDeleteShader(vertShader);
-        glDeleteShader(fragShader);
-        glDeleteProgram(program);
-        vertShader = 0;
-        fragShader = 0;
-        program = 0;
+const ShaderReflection *BaseShader::getShader(uint32_t features) {
+    features &= VARIANT_COUNT - 1;
+    if (!shaders[features] && !failed[features]) {
+        createProgram(features);
+        failed[features] = !shaders[features];
+    }
+    return shaders[features].get();
+}
+
+GLuint BaseShader::getProgram(uint32_t features) {
+    const ShaderReflection *shader = getShader(features);
+    return shader != nullptr ? shader->getProgram() : 0;
+}
+
+void BaseShader::deletePrograms() {
+    for (auto &shader: shaders) {
+        if (shader) {
+            GLStateCache::deleteProgram(shader->getProgram());
+            shader.reset();
+        }
     }
+    std::fill(std::begin(failed), std::end(failed), false); // 新的context重新尝试
+    generation++;
 }
@@ -6,15 +6,58 @@
 #define NATIVEACTIVITYDEMO_BASESHADER_H
 
 #include <GLES3/gl32.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "ShaderReflection.h"
+
+// 和shader中的uniform block一一对应，按std140布局
+struct FrameBlock {
+    GLfloat lightPosition[4];
+    GLfloat lightColor[4];
+};
+
+struct ObjectBlock {
+    GLfloat transformMat4[16];
+    GLfloat modelColorFactor[4];
+    GLfloat uvRect[4];
+};
+
+// shader的特性开关，每种组合编译成一个单独的program，shader里用#ifdef裁掉不需要的代码
+enum ShaderFeature : uint32_t {
+    SHADER_TRANSFORM = 1u << 0, // 顶点乘transformMat4和instanceMat4，否则顶点已经是裁剪坐标（比如2D包围盒）
+    SHADER_LIT = 1u << 1,       // Blinn-Phong光照，需要法向量
+    SHADER_TEXTURED = 1u << 2,  // 采样纹理，否则直接使用modelColorFactor作为颜色
+    SHADER_ALPHA = 1u << 3,     // 输出的alpha参与混合，否则固定为1
+    SHADER_VERTEX_COLOR = 1u << 4, // 颜色再乘上顶点属性vColor，用于DebugDraw
+    SHADER_FEATURE_BITS = 5
+};
 
 class BaseShader {
 public:
-    static GLuint getSingletonProgram();
-    static void deleteSingletonProgram();
+    static const GLuint FRAME_BLOCK_BINDING = 0;
+    static const GLuint OBJECT_BLOCK_BINDING = 1;
+    static const GLuint INSTANCE_MAT4_LOCATION = 3; // mat4属性占4个连续的location
+    static const GLuint VERTEX_COLOR_LOCATION = 7;
+
+    // 模型默认使用的组合
+    static const uint32_t DEFAULT_FEATURES = SHADER_TRANSFORM | SHADER_LIT | SHADER_TEXTURED;
+
+    // 第一次使用某个组合时编译（或从program binary加载）并生成反射信息，之后直接返回缓存的。
+    // 编译失败时返回nullptr，同一个context里不再重试。返回的指针在deletePrograms之前一直有效
+    static const ShaderReflection *getShader(uint32_t features = DEFAULT_FEATURES);
+    static GLuint getProgram(uint32_t features = DEFAULT_FEATURES);
+    static void deletePrograms();
+    // 每次deletePrograms加1，缓存了getShader结果的一方据此判断指针是否已经失效
+    static uint32_t getGeneration() { return generation; }
 private:
-    static GLuint program;
-    static GLuint vertShader;
-    static GLuint fragShader;
+    static const uint32_t VARIANT_COUNT = 1u << SHADER_FEATURE_BITS;
+    static std::unique_ptr<ShaderReflection> shaders[VARIANT_COUNT];
+    static bool failed[VARIANT_COUNT]; // 编译或链接失败过，避免每次draw都重新编译、打印错误
+    static uint32_t generation;
+
+    static std::string makeSource(const char *body, uint32_t features);
+    static void createProgram(uint32_t features); // 成功时结果放进shaders
 };
 
 #endif //NATIVEACTIVITYDEMO_BASESHADER_H
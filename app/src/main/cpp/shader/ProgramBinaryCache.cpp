@@ -0,0 +1,145 @@
+#include "ProgramBinaryCache.h"
+#include "../app_log.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const uint32_t FILE_MAGIC = 0x4E494250; // "PBIN"
+const uint32_t FILE_VERSION = 1;
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key; // 和文件名里的一致，防止文件被截断或者改名
+    uint32_t binaryFormat;
+    uint32_t length;
+};
+
+// 64位FNV-1a，只用来区分不同的源码和驱动，不需要抗碰撞
+uint64_t fnv1a(uint64_t hash, const char *str) {
+    if (str == nullptr) {
+        return hash;
+    }
+    for (const unsigned char *p = (const unsigned char *)str; *p != 0; p++) {
+        hash ^= *p;
+        hash *= 0x100000001B3ULL;
+    }
+    hash ^= 0xFF; // 分隔各段，"ab" + "c"和"a" + "bc"得到不同的hash
+    hash *= 0x100000001B3ULL;
+    return hash;
+}
+
+} // namespace
+
+std::string ProgramBinaryCache::cacheDir;
+int ProgramBinaryCache::supported = -1;
+
+void ProgramBinaryCache::init(const char *dir) {
+    cacheDir = dir != nullptr ? dir : "";
+    supported = -1; // 新的context可能来自不同的驱动配置，重新查询
+}
+
+bool ProgramBinaryCache::isSupported() {
+    if (supported < 0) {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        supported = formats > 0 ? 1 : 0;
+        if (!supported) {
+            app_log("program binary cache: driver has no program binary format\n");
+        }
+    }
+    return supported == 1 && !cacheDir.empty();
+}
+
+std::string ProgramBinaryCache::cachePath(const char *vertSource, const char *fragSource, uint64_t *outKey) {
+    uint64_t key = 0xCBF29CE484222325ULL;
+    key = fnv1a(key, vertSource);
+    key = fnv1a(key, fragSource);
+    key = fnv1a(key, (const char *)glGetString(GL_RENDERER));
+    key = fnv1a(key, (const char *)glGetString(GL_VERSION));
+    *outKey = key;
+    char name[64];
+    snprintf(name, sizeof(name), "/program_%016llx.bin", (unsigned long long)key);
+    return cacheDir + name;
+}
+
+GLuint ProgramBinaryCache::load(const char *vertSource, const char *fragSource) {
+    if (!isSupported()) {
+        return 0;
+    }
+    uint64_t key = 0;
+    std::string path = cachePath(vertSource, fragSource, &key);
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return 0; // 第一次启动
+    }
+    FileHeader header;
+    std::vector<uint8_t> binary;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == FILE_MAGIC &&
+              header.version == FILE_VERSION && header.key == key && header.length > 0;
+    if (ok) {
+        binary.resize(header.length);
+        ok = fread(binary.data(), 1, binary.size(), file) == binary.size();
+    }
+    fclose(file);
+
+    GLuint program = 0;
+    if (ok) {
+        program = glCreateProgram();
+        glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        if (linkStatus != GL_TRUE) {
+            glGetError(); // 不支持的binaryFormat会产生GL_INVALID_ENUM，不留给后面的检查
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    if (program == 0) {
+        // 驱动拒绝（比如驱动更新后GL_VERSION没变）或者文件损坏，删掉后由调用者重新编译保存
+        app_log("program binary cache: %s rejected, recompiling\n", path.c_str());
+        remove(path.c_str());
+    }
+    return program;
+}
+
+void ProgramBinaryCache::save(GLuint program, const char *vertSource, const char *fragSource) {
+    if (program == 0 || !isSupported()) {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<uint8_t> binary((size_t)length);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+    if (length <= 0) {
+        return;
+    }
+
+    FileHeader header;
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    std::string path = cachePath(vertSource, fragSource, &header.key);
+    header.binaryFormat = binaryFormat;
+    header.length = (uint32_t)length;
+    // 先写临时文件再改名，写到一半被杀掉不会留下不完整的缓存
+    std::string tmpPath = path + ".tmp";
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr) {
+        app_log("program binary cache: can not write %s\n", tmpPath.c_str());
+        return;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(binary.data(), 1, (size_t)length, file) == (size_t)length;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        return;
+    }
+    app_log("program binary cache: saved %s (%d bytes)\n", path.c_str(), length);
+}
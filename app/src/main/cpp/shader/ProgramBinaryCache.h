@@ -0,0 +1,31 @@
+#ifndef NATIVEACTIVITYDEMO_PROGRAMBINARYCACHE_H
+#define NATIVEACTIVITYDEMO_PROGRAMBINARYCACHE_H
+
+#include <GLES3/gl32.h>
+#include <cstdint>
+#include <string>
+
+/**
+ * 把链接好的program用glGetProgramBinary保存到应用的内部存储，下次启动（包括窗口销毁后重建context）
+ * 用glProgramBinary直接加载，跳过编译和链接。
+ * 文件按shader源码、GL_RENDERER和GL_VERSION的hash命名，驱动升级或源码修改后自然失效；
+ * 驱动拒绝加载时删除文件，由调用者重新编译再保存。只能在GL线程调用。
+ */
+class ProgramBinaryCache {
+public:
+    // cacheDir为nullptr时不使用缓存（比如取不到internalDataPath）
+    static void init(const char *cacheDir);
+
+    // 没有缓存或驱动拒绝时返回0
+    static GLuint load(const char *vertSource, const char *fragSource);
+    static void save(GLuint program, const char *vertSource, const char *fragSource);
+
+private:
+    static std::string cacheDir;
+    static int supported; // -1表示还没有查询GL_NUM_PROGRAM_BINARY_FORMATS
+
+    static bool isSupported();
+    static std::string cachePath(const char *vertSource, const char *fragSource, uint64_t *outKey);
+};
+
+#endif //NATIVEACTIVITYDEMO_PROGRAMBINARYCACHE_H
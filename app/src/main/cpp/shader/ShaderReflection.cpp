@@ -0,0 +1,76 @@
+#include "ShaderReflection.h"
+#include "../app_log.h"
+#include <vector>
+
+namespace {
+
+// 数组的名字是"name[0]"，同时按"name"记录，和glGetUniformLocation的查询方式一致
+std::string baseName(const char *name) {
+    std::string str(name);
+    size_t bracket = str.find('[');
+    return bracket == std::string::npos ? str : str.substr(0, bracket);
+}
+
+} // namespace
+
+ShaderReflection::ShaderReflection(GLuint program_): program(program_) {
+    GLint count = 0;
+    GLint maxLength = 0;
+    GLint size = 0;
+    GLenum type = 0;
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name((size_t)(maxLength > 0 ? maxLength : 1));
+    for (GLint i = 0; i < count; i++) {
+        glGetActiveUniform(program, (GLuint)i, (GLsizei)name.size(), nullptr, &size, &type, name.data());
+        GLint location = glGetUniformLocation(program, name.data());
+        if (location < 0) {
+            continue; // uniform block的成员
+        }
+        uniforms[name.data()] = location;
+        uniforms[baseName(name.data())] = location;
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    name.resize((size_t)(maxLength > 0 ? maxLength : 1));
+    for (GLint i = 0; i < count; i++) {
+        glGetActiveAttrib(program, (GLuint)i, (GLsizei)name.size(), nullptr, &size, &type, name.data());
+        attribs[name.data()] = glGetAttribLocation(program, name.data());
+    }
+
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+    name.resize((size_t)(maxLength > 0 ? maxLength : 1));
+    for (GLint i = 0; i < count; i++) {
+        glGetActiveUniformBlockName(program, (GLuint)i, (GLsizei)name.size(), nullptr, name.data());
+        blocks[name.data()] = (GLuint)i;
+    }
+}
+
+GLint ShaderReflection::getUniformLocation(const char *name) const {
+    auto it = uniforms.find(name);
+    return it != uniforms.end() ? it->second : -1;
+}
+
+GLint ShaderReflection::getAttribLocation(const char *name) const {
+    auto it = attribs.find(name);
+    return it != attribs.end() ? it->second : -1;
+}
+
+GLuint ShaderReflection::getUniformBlockIndex(const char *name) const {
+    auto it = blocks.find(name);
+    return it != blocks.end() ? it->second : GL_INVALID_INDEX;
+}
+
+void ShaderReflection::log() const {
+    app_log("program %u: %zu uniforms, %zu attributes, %zu uniform blocks\n", program, uniforms.size(),
+            attribs.size(), blocks.size());
+    for (auto &item: attribs) {
+        app_log("    attribute %s: %d\n", item.first.c_str(), item.second);
+    }
+    for (auto &item: blocks) {
+        app_log("    uniform block %s: %u\n", item.first.c_str(), item.second);
+    }
+}
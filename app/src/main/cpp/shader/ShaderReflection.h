@@ -0,0 +1,33 @@
+#ifndef NATIVEACTIVITYDEMO_SHADERREFLECTION_H
+#define NATIVEACTIVITYDEMO_SHADERREFLECTION_H
+
+#include <GLES3/gl32.h>
+#include <string>
+#include <unordered_map>
+
+/**
+ * 一个program的反射信息，链接（或从program binary加载）之后用glGetActiveUniform等接口一次性枚举，
+ * 缓存所有uniform、attribute的location和uniform block的index，之后按名字查询不再访问驱动。
+ * 只记录active的变量，被编译器优化掉的返回-1（block返回GL_INVALID_INDEX），和对应的GL接口一致。
+ * 由BaseShader为每个program创建一份，program删除时一起释放。
+ */
+class ShaderReflection {
+public:
+    explicit ShaderReflection(GLuint program);
+
+    GLuint getProgram() const { return program; }
+
+    GLint getUniformLocation(const char *name) const;
+    GLint getAttribLocation(const char *name) const;
+    GLuint getUniformBlockIndex(const char *name) const;
+
+    void log() const;
+
+private:
+    GLuint program;
+    std::unordered_map<std::string, GLint> uniforms; // 只有default block里的uniform，block成员没有location
+    std::unordered_map<std::string, GLint> attribs;
+    std::unordered_map<std::string, GLuint> blocks;
+};
+
+#endif //NATIVEACTIVITYDEMO_SHADERREFLECTION_H
@@ -0,0 +1,237 @@
+// GLStateCache的单元测试，链接GL桩库，不需要context：
+// 按一段固定的调用序列检查issued/skipped的次数和真正转发到GL的调用
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "GLStub.h"
+#include "TestCheck.h"
+#include "../gles/GLStateCache.h"
+
+namespace {
+
+void restart() {
+    GLStateCache::invalidate();
+    GLStateCache::resetStats();
+    GLStub::clearCalls();
+}
+
+void expectStats(uint32_t issued, uint32_t skipped, int line) {
+    const GLStateCacheStats &stats = GLStateCache::getStats();
+    if (stats.issued != issued || stats.skipped != skipped) {
+        fprintf(stderr, "line %d: expected %u issued, %u skipped, got %u issued, %u skipped\n",
+                line, issued, skipped, stats.issued, stats.skipped);
+        testFailures++;
+    }
+}
+
+void expectCalls(const std::vector<std::string> &expected, int line) {
+    const std::vector<std::string> &calls = GLStub::getCalls();
+    if (calls != expected) {
+        fprintf(stderr, "line %d: forwarded calls differ\n  expected:\n", line);
+        for (const std::string &call: expected) {
+            fprintf(stderr, "    %s\n", call.c_str());
+        }
+        fprintf(stderr, "  actual:\n");
+        for (const std::string &call: calls) {
+            fprintf(stderr, "    %s\n", call.c_str());
+        }
+        testFailures++;
+    }
+    GLStub::clearCalls();
+}
+
+const GLfloat RED[4] = {1.0f, 0.0f, 0.0f, 1.0f};
+const GLfloat GREEN[4] = {0.0f, 1.0f, 0.0f, 1.0f};
+const GLfloat IDENTITY[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+void testBindings() {
+    restart();
+    GLStateCache::useProgram(3);
+    GLStateCache::useProgram(3);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 7);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 7);
+    // 每个纹理单元分别记录
+    GLStateCache::activeTexture(GL_TEXTURE1);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 7);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 7);
+    // 只记录GL_TEXTURE_2D，其他target总是透传
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 9);
+    GLStateCache::bindTexture(GL_TEXTURE_CUBE_MAP, 9);
+    GLStateCache::bindVertexArray(5);
+    GLStateCache::bindVertexArray(5);
+    GLStateCache::bindVertexArray(6);
+    GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, 0, 11, 0, 64);
+    GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, 0, 11, 0, 64);
+    GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, 0, 11, 256, 64);
+    GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, 1, 11, 256, 64);
+    expectStats(13, 5, __LINE__);
+    expectCalls({
+            "glUseProgram(3)",
+            "glActiveTexture(0x84c0)",
+            "glBindTexture(0x0de1, 7)",
+            "glActiveTexture(0x84c1)",
+            "glBindTexture(0x0de1, 7)",
+            "glActiveTexture(0x84c0)",
+            "glBindTexture(0x8513, 9)",
+            "glBindTexture(0x8513, 9)",
+            "glBindVertexArray(5)",
+            "glBindVertexArray(6)",
+            "glBindBufferRange(0x8a11, 0, 11, 0, 64)",
+            "glBindBufferRange(0x8a11, 0, 11, 256, 64)",
+            "glBindBufferRange(0x8a11, 1, 11, 256, 64)",
+    }, __LINE__);
+}
+
+void testCapsAndFixedFunction() {
+    restart();
+    GLStateCache::enable(GL_BLEND);
+    GLStateCache::enable(GL_BLEND);
+    GLStateCache::disable(GL_BLEND);
+    GLStateCache::disable(GL_BLEND);
+    GLStateCache::enable(GL_DEPTH_TEST);
+    // 不认识的开关不记录
+    GLStateCache::enable(GL_DITHER);
+    GLStateCache::enable(GL_DITHER);
+    GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLStateCache::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    GLStateCache::depthFunc(GL_LEQUAL);
+    GLStateCache::depthFunc(GL_LEQUAL);
+    GLStateCache::depthMask(GL_FALSE);
+    GLStateCache::depthMask(GL_FALSE);
+    GLStateCache::lineWidth(2.0f);
+    GLStateCache::lineWidth(2.0f);
+    expectStats(9, 6, __LINE__);
+    expectCalls({
+            "glEnable(0x0be2)",
+            "glDisable(0x0be2)",
+            "glEnable(0x0b71)",
+            "glEnable(0x0bd0)",
+            "glEnable(0x0bd0)",
+            "glBlendFunc(0x0302, 0x0303)",
+            "glDepthFunc(0x0203)",
+            "glDepthMask(0)",
+            "glLineWidth(2)",
+    }, __LINE__);
+}
+
+void testUniforms() {
+    restart();
+    GLStateCache::useProgram(3);
+    GLStateCache::uniform4fv(2, RED);
+    GLStateCache::uniform4fv(2, RED);
+    GLStateCache::uniform4fv(2, GREEN);
+    GLStateCache::uniform1i(1, 0);
+    GLStateCache::uniform1i(1, 0);
+    GLStateCache::uniform1i(-1, 0); // 不计数也不转发
+    GLStateCache::uniformMatrix4fv(0, IDENTITY);
+    GLStateCache::uniformMatrix4fv(0, IDENTITY);
+    GLStateCache::uniform3fv(4, RED);
+    GLStateCache::uniform3fv(4, RED);
+    // uniform的值属于各自的program
+    GLStateCache::useProgram(4);
+    GLStateCache::uniform4fv(2, GREEN);
+    GLStateCache::useProgram(3);
+    GLStateCache::uniform4fv(2, GREEN);
+    expectStats(9, 5, __LINE__);
+    expectCalls({
+            "glUseProgram(3)",
+            "glUniform4fv(2, 1, 1 0 0 1)",
+            "glUniform4fv(2, 1, 0 1 0 1)",
+            "glUniform1i(1, 0)",
+            "glUniformMatrix4fv(0, 1, 0, 1)",
+            "glUniform3fv(4, 1, 1 0 0)",
+            "glUseProgram(4)",
+            "glUniform4fv(2, 1, 0 1 0 1)",
+            "glUseProgram(3)",
+    }, __LINE__);
+}
+
+// 一组状态设置，第一次全部转发，重复时全部过滤
+void setCommonState() {
+    GLStateCache::useProgram(3);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 7);
+    GLStateCache::enable(GL_BLEND);
+    GLStateCache::bindVertexArray(6);
+    GLStateCache::uniform4fv(2, GREEN);
+}
+
+const std::vector<std::string> COMMON_STATE_CALLS = {
+        "glUseProgram(3)",
+        "glActiveTexture(0x84c0)",
+        "glBindTexture(0x0de1, 7)",
+        "glEnable(0x0be2)",
+        "glBindVertexArray(6)",
+        "glUniform4fv(2, 1, 0 1 0 1)",
+};
+
+void testInvalidate() {
+    restart();
+    setCommonState();
+    expectStats(6, 0, __LINE__);
+    expectCalls(COMMON_STATE_CALLS, __LINE__);
+    setCommonState();
+    expectStats(6, 6, __LINE__);
+    expectCalls({}, __LINE__);
+
+    // context重建后记录的状态都不可信，同样的调用要重新转发
+    GLStateCache::invalidate();
+    GLStateCache::resetStats();
+    setCommonState();
+    expectStats(6, 0, __LINE__);
+    expectCalls(COMMON_STATE_CALLS, __LINE__);
+}
+
+void testDelete() {
+    restart();
+    setCommonState();
+    GLStub::clearCalls();
+    GLStateCache::resetStats();
+
+    // 删除后名字可能被GL复用，必须重新绑定
+    GLuint texture = 7;
+    GLStateCache::deleteTextures(1, &texture);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 7);
+    // 删除已绑定的vao后绑定回到0
+    GLuint vao = 6;
+    GLStateCache::deleteVertexArrays(1, &vao);
+    GLStateCache::bindVertexArray(0);
+    // 删除program后它的uniform记录也丢掉
+    GLStateCache::deleteProgram(3);
+    GLStateCache::useProgram(3);
+    GLStateCache::uniform4fv(2, GREEN);
+    // 删除的buffer不再算作已绑定
+    GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, 0, 11, 0, 64);
+    GLuint buffer = 11;
+    GLStateCache::deleteBuffers(1, &buffer);
+    GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, 0, 11, 0, 64);
+    expectStats(5, 1, __LINE__);
+    expectCalls({
+            "glDeleteTextures(1, 7)",
+            "glBindTexture(0x0de1, 7)",
+            "glDeleteVertexArrays(1, 6)",
+            "glDeleteProgram(3)",
+            "glUseProgram(3)",
+            "glUniform4fv(2, 1, 0 1 0 1)",
+            "glBindBufferRange(0x8a11, 0, 11, 0, 64)",
+            "glDeleteBuffers(1, 11)",
+            "glBindBufferRange(0x8a11, 0, 11, 0, 64)",
+    }, __LINE__);
+}
+
+} // namespace
+
+int main() {
+    testBindings();
+    testCapsAndFixedFunction();
+    testUniforms();
+    testInvalidate();
+    testDelete();
+    if (testFailures == 0) {
+        printf("GLStateCache: all checks passed\n");
+    }
+    return TEST_RESULT();
+}
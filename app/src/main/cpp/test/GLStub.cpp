@@ -0,0 +1,95 @@
+#include "GLStub.h"
+#include <GLES3/gl32.h>
+#include <cstdarg>
+#include <cstdio>
+
+std::vector<std::string> GLStub::calls;
+
+void GLStub::record(const char *format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    calls.emplace_back(buffer);
+}
+
+// gl32.h里的声明是extern "C"的，这里的定义沿用C链接
+
+GL_APICALL void GL_APIENTRY glUseProgram(GLuint program) {
+    GLStub::record("glUseProgram(%u)", program);
+}
+
+GL_APICALL void GL_APIENTRY glActiveTexture(GLenum texture) {
+    GLStub::record("glActiveTexture(0x%04x)", texture);
+}
+
+GL_APICALL void GL_APIENTRY glBindTexture(GLenum target, GLuint texture) {
+    GLStub::record("glBindTexture(0x%04x, %u)", target, texture);
+}
+
+GL_APICALL void GL_APIENTRY glBindVertexArray(GLuint array) {
+    GLStub::record("glBindVertexArray(%u)", array);
+}
+
+GL_APICALL void GL_APIENTRY glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset,
+                                              GLsizeiptr size) {
+    GLStub::record("glBindBufferRange(0x%04x, %u, %u, %ld, %ld)", target, index, buffer, (long)offset, (long)size);
+}
+
+GL_APICALL void GL_APIENTRY glEnable(GLenum cap) {
+    GLStub::record("glEnable(0x%04x)", cap);
+}
+
+GL_APICALL void GL_APIENTRY glDisable(GLenum cap) {
+    GLStub::record("glDisable(0x%04x)", cap);
+}
+
+GL_APICALL void GL_APIENTRY glBlendFunc(GLenum sfactor, GLenum dfactor) {
+    GLStub::record("glBlendFunc(0x%04x, 0x%04x)", sfactor, dfactor);
+}
+
+GL_APICALL void GL_APIENTRY glDepthFunc(GLenum func) {
+    GLStub::record("glDepthFunc(0x%04x)", func);
+}
+
+GL_APICALL void GL_APIENTRY glDepthMask(GLboolean flag) {
+    GLStub::record("glDepthMask(%d)", flag);
+}
+
+GL_APICALL void GL_APIENTRY glLineWidth(GLfloat width) {
+    GLStub::record("glLineWidth(%g)", width);
+}
+
+GL_APICALL void GL_APIENTRY glUniform1i(GLint location, GLint v0) {
+    GLStub::record("glUniform1i(%d, %d)", location, v0);
+}
+
+GL_APICALL void GL_APIENTRY glUniform3fv(GLint location, GLsizei count, const GLfloat *value) {
+    GLStub::record("glUniform3fv(%d, %d, %g %g %g)", location, count, value[0], value[1], value[2]);
+}
+
+GL_APICALL void GL_APIENTRY glUniform4fv(GLint location, GLsizei count, const GLfloat *value) {
+    GLStub::record("glUniform4fv(%d, %d, %g %g %g %g)", location, count, value[0], value[1], value[2], value[3]);
+}
+
+GL_APICALL void GL_APIENTRY glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose,
+                                               const GLfloat *value) {
+    GLStub::record("glUniformMatrix4fv(%d, %d, %d, %g)", location, count, transpose, value[0]);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteProgram(GLuint program) {
+    GLStub::record("glDeleteProgram(%u)", program);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteTextures(GLsizei n, const GLuint *textures) {
+    GLStub::record("glDeleteTextures(%d, %u)", n, textures[0]);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteVertexArrays(GLsizei n, const GLuint *arrays) {
+    GLStub::record("glDeleteVertexArrays(%d, %u)", n, arrays[0]);
+}
+
+GL_APICALL void GL_APIENTRY glDeleteBuffers(GLsizei n, const GLuint *buffers) {
+    GLStub::record("glDeleteBuffers(%d, %u)", n, buffers[0]);
+}
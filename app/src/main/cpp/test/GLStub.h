@@ -0,0 +1,22 @@
+#ifndef NATIVEACTIVITYDEMO_GLSTUB_H
+#define NATIVEACTIVITYDEMO_GLSTUB_H
+
+#include <string>
+#include <vector>
+
+/**
+ * 代替libGLESv2链接的GL桩库，不需要context。GLStateCache用到的gl*函数只把调用记成
+ * "glBindTexture(0x0de1, 7)"这样的字符串，测试检查哪些调用真正转发到了GL。
+ */
+class GLStub {
+public:
+    static const std::vector<std::string> &getCalls() { return calls; }
+    static void clearCalls() { calls.clear(); }
+
+    static void record(const char *format, ...);
+
+private:
+    static std::vector<std::string> calls;
+};
+
+#endif //NATIVEACTIVITYDEMO_GLSTUB_H
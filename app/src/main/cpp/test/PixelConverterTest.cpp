@@ -0,0 +1,203 @@
+// PixelConverter的单元测试：
+//   test-pixel-converter ASSETS_DIR
+// 1. SSE2/NEON一次处理4个像素的路径和逐像素的参考实现逐个比较，宽1到22覆盖剩余的0到3个像素，也测原地转换
+// 2. 各种DitherMode转换后再展开成RGBA8，和原图比较PSNR和单个分量的最大误差
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "TestCheck.h"
+#include "../platform/AssetProvider.h"
+#include "../regression/ImageDiff.h"
+#include "../texture/PixelConverter.h"
+#include "../texture/TextureUtils.h"
+
+namespace {
+
+const PixelFormat FORMATS[] = {PIXEL_RGB565, PIXEL_RGBA5551, PIXEL_RGBA4444};
+const DitherMode DITHERS[] = {DITHER_NONE, DITHER_ORDERED, DITHER_DIFFUSION};
+
+// 每个分量的位数和在16位里的位置，按RGBA的顺序
+struct Layout {
+    int bits[4];
+    int shift[4];
+};
+
+Layout layoutOf(PixelFormat format) {
+    switch (format) {
+        case PIXEL_RGB565: return {{5, 6, 5, 0}, {11, 5, 0, 0}};
+        case PIXEL_RGBA5551: return {{5, 5, 5, 1}, {11, 6, 1, 0}};
+        default: return {{4, 4, 4, 4}, {12, 8, 4, 0}};
+    }
+}
+
+const char *formatName(PixelFormat format) {
+    return format == PIXEL_RGB565 ? "RGB565" : (format == PIXEL_RGBA5551 ? "RGBA5551" : "RGBA4444");
+}
+
+const char *ditherName(DitherMode dither) {
+    return dither == DITHER_NONE ? "none" : (dither == DITHER_ORDERED ? "ordered" : "diffusion");
+}
+
+// 参考实现：每个分量floor((c * max + t) / 255)，直接做除法
+uint16_t referencePixel(const uint8_t *p, PixelFormat format, DitherMode dither, uint32_t x, uint32_t y) {
+    static const uint32_t BAYER4[4][4] = {{0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+    uint32_t t = dither == DITHER_ORDERED ? BAYER4[y & 3][x & 3] * 16 + 8 : 127;
+    Layout layout = layoutOf(format);
+    uint32_t v = 0;
+    for (int c = 0; c < 4; c++) {
+        uint32_t maxValue = (1u << layout.bits[c]) - 1;
+        v |= (p[c] * maxValue + t) / 255 << layout.shift[c];
+    }
+    return (uint16_t)v;
+}
+
+void testAgainstReference() {
+    std::mt19937 random(20261019);
+    const uint32_t height = 5;
+    for (PixelFormat format: FORMATS) {
+        for (DitherMode dither: {DITHER_NONE, DITHER_ORDERED}) {
+            for (uint32_t w = 1; w <= 22; w++) {
+                std::vector<uint8_t> rgba((size_t)w * height * 4);
+                for (size_t i = 0; i < rgba.size(); i++) {
+                    uint32_t r = random();
+                    // 两端的值更容易出错，多放一些
+                    rgba[i] = (r & 7) == 0 ? 0 : ((r & 7) == 1 ? 255 : (uint8_t)(r >> 8));
+                }
+                std::vector<uint16_t> out((size_t)w * height);
+                PixelConverter::convert(rgba.data(), w, height, format, dither, out.data());
+                // 原地转换的结果必须相同
+                std::vector<uint8_t> inPlace = rgba;
+                PixelConverter::convert(inPlace.data(), w, height, format, dither, (uint16_t *)inPlace.data());
+                for (uint32_t y = 0; y < height; y++) {
+                    for (uint32_t x = 0; x < w; x++) {
+                        size_t i = (size_t)y * w + x;
+                        uint16_t expected = referencePixel(&rgba[i * 4], format, dither, x, y);
+                        uint16_t inPlaceValue;
+                        memcpy(&inPlaceValue, &inPlace[i * 2], sizeof(inPlaceValue));
+                        if (out[i] != expected || inPlaceValue != expected) {
+                            fprintf(stderr, "%s %s width %u (%u, %u): expected 0x%04x, got 0x%04x, in place 0x%04x\n",
+                                    formatName(format), ditherName(dither), w, x, y, expected, out[i], inPlaceValue);
+                            testFailures++;
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 16位展开回RGBA8，量化值按比例放大并四舍五入。565没有alpha，展开成255
+std::vector<uint8_t> expand(const std::vector<uint16_t> &pixels, PixelFormat format) {
+    Layout layout = layoutOf(format);
+    std::vector<uint8_t> rgba(pixels.size() * 4);
+    for (size_t i = 0; i < pixels.size(); i++) {
+        for (int c = 0; c < 4; c++) {
+            uint32_t maxValue = (1u << layout.bits[c]) - 1;
+            if (maxValue == 0) {
+                rgba[i * 4 + c] = 255;
+                continue;
+            }
+            uint32_t q = (pixels[i] >> layout.shift[c]) & maxValue;
+            rgba[i * 4 + c] = (uint8_t)((q * 255 + maxValue / 2) / maxValue);
+        }
+    }
+    return rgba;
+}
+
+// 各组合的下限和上限。PSNR按RGB，maxError是RGB单个分量和原图的最大差。
+// 不抖动时误差不超过半个量化步长（5位是8.2，4位是17）；有序抖动小于一个步长；
+// 误差扩散会把误差推到相邻的像素，单个像素可以超过一个步长，这里允许1.5个
+struct Bound {
+    PixelFormat format;
+    DitherMode dither;
+    float minPsnr;
+    int maxError;
+};
+
+const Bound BOUNDS[] = {
+        {PIXEL_RGB565, DITHER_NONE, 40.0f, 4},
+        {PIXEL_RGB565, DITHER_ORDERED, 37.0f, 8},
+        {PIXEL_RGB565, DITHER_DIFFUSION, 37.0f, 12},
+        {PIXEL_RGBA5551, DITHER_NONE, 39.0f, 4},
+        {PIXEL_RGBA5551, DITHER_ORDERED, 36.0f, 8},
+        {PIXEL_RGBA5551, DITHER_DIFFUSION, 36.0f, 12},
+        {PIXEL_RGBA4444, DITHER_NONE, 33.0f, 8},
+        {PIXEL_RGBA4444, DITHER_ORDERED, 30.0f, 16},
+        {PIXEL_RGBA4444, DITHER_DIFFUSION, 30.0f, 24},
+};
+
+void checkQuality(const std::string &name, const std::vector<uint8_t> &rgba, uint32_t w, uint32_t h) {
+    for (const Bound &bound: BOUNDS) {
+        std::vector<uint16_t> converted((size_t)w * h);
+        PixelConverter::convert(rgba.data(), w, h, bound.format, bound.dither, converted.data());
+        std::vector<uint8_t> expanded = expand(converted, bound.format);
+        ImageDiffOptions options;
+        ImageDiffResult diff = ImageDiff::compare(rgba.data(), expanded.data(), w, h, options);
+        int maxError = 0;
+        bool alphaExact = true;
+        for (size_t i = 0; i < rgba.size(); i++) {
+            if (i % 4 == 3) {
+                // 原图的alpha是0或255的像素，5551必须保持不变
+                if (bound.format == PIXEL_RGBA5551 && (rgba[i] == 0 || rgba[i] == 255)) {
+                    alphaExact = alphaExact && expanded[i] == rgba[i];
+                }
+                continue;
+            }
+            int error = std::abs((int)expanded[i] - (int)rgba[i]);
+            maxError = error > maxError ? error : maxError;
+        }
+        printf("%s %s %s: PSNR %.2f dB, max error %d\n", name.c_str(), formatName(bound.format),
+               ditherName(bound.dither), diff.psnr, maxError);
+        if (diff.psnr < bound.minPsnr || maxError > bound.maxError || !alphaExact) {
+            fprintf(stderr, "%s %s %s: expected PSNR >= %.1f dB and max error <= %d%s\n", name.c_str(),
+                    formatName(bound.format), ditherName(bound.dither), bound.minPsnr, bound.maxError,
+                    alphaExact ? "" : ", alpha changed");
+            testFailures++;
+        }
+    }
+}
+
+// 平滑的渐变最容易出现色带，alpha只有0和255
+std::vector<uint8_t> gradient(uint32_t w, uint32_t h) {
+    std::vector<uint8_t> rgba((size_t)w * h * 4);
+    for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+            uint8_t *p = &rgba[((size_t)y * w + x) * 4];
+            p[0] = (uint8_t)(x * 255 / (w - 1));
+            p[1] = (uint8_t)(y * 255 / (h - 1));
+            p[2] = (uint8_t)((x + y) * 255 / (w + h - 2));
+            p[3] = (x / 16 + y / 16) % 2 ? 255 : 0;
+        }
+    }
+    return rgba;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s ASSETS_DIR\n", argv[0]);
+        return 2;
+    }
+    Assets::setProvider(std::unique_ptr<AssetProvider>(new DirectoryAssetProvider(argv[1])));
+
+    testAgainstReference();
+
+    checkQuality("gradient", gradient(256, 256), 256, 256);
+    for (const char *pngFile: {"mountain.png", "oldhouse.png"}) {
+        uint32_t w = 0, h = 0;
+        auto image = (uint8_t *)TextureUtils::decodePNG(pngFile, &w, &h);
+        CHECK(image != nullptr);
+        if (image != nullptr) {
+            checkQuality(pngFile, std::vector<uint8_t>(image, image + (size_t)w * h * 4), w, h);
+            free(image);
+        }
+    }
+    return TEST_RESULT();
+}
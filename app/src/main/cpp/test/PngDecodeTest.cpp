@@ -0,0 +1,159 @@
+// TextureUtils::decodePNG（行指针直接指向翻转后的位置）和逐行复制的参考解码逐像素比较：
+//   test-png-decode ASSETS_DIR DATA_DIR
+// 输入是assets目录下的png，以及生成的RGB、RGBA、调色板、灰度等格式、奇数宽度、interlace的png
+
+#include <dirent.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "TestCheck.h"
+#include "TestPng.h"
+#include "../platform/AssetProvider.h"
+#include "../texture/TextureUtils.h"
+#include "../utils/libpng1_6_29/png.h"
+
+namespace {
+
+// name是asset路径，path是同一个文件在文件系统里的路径
+void compareDecode(const std::string &name, const std::string &path) {
+    std::vector<uint8_t> expected;
+    uint32_t expectedW = 0, expectedH = 0;
+    if (!TestPng::decodeReference(path, &expected, &expectedW, &expectedH)) {
+        fprintf(stderr, "%s: reference decode failed\n", name.c_str());
+        testFailures++;
+        return;
+    }
+    uint32_t w = 0, h = 0;
+    auto actual = (uint8_t *)TextureUtils::decodePNG(name.c_str(), &w, &h);
+    if (actual == nullptr || w != expectedW || h != expectedH) {
+        fprintf(stderr, "%s: decodePNG returned %ux%u, expected %ux%u\n", name.c_str(), w, h, expectedW, expectedH);
+        testFailures++;
+        free(actual);
+        return;
+    }
+    size_t rowBytes = (size_t)w * 4;
+    for (uint32_t y = 0; y < h; y++) {
+        const uint8_t *expectedRow = expected.data() + rowBytes * y;
+        const uint8_t *actualRow = actual + rowBytes * y;
+        if (memcmp(expectedRow, actualRow, rowBytes) == 0) {
+            continue;
+        }
+        size_t i = 0;
+        while (expectedRow[i] == actualRow[i]) {
+            i++;
+        }
+        fprintf(stderr, "%s: row %u pixel %zu channel %zu differs: expected %u, got %u\n",
+                name.c_str(), y, i / 4, i % 4, expectedRow[i], actualRow[i]);
+        testFailures++;
+        break;
+    }
+    free(actual);
+}
+
+bool isPngFile(const std::string &path) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    png_byte signature[8];
+    bool png = fread(signature, 1, sizeof(signature), file) == sizeof(signature) &&
+               png_sig_cmp(signature, 0, sizeof(signature)) == 0;
+    fclose(file);
+    return png;
+}
+
+int testBundled(const std::string &assetsDir) {
+    Assets::setProvider(std::unique_ptr<AssetProvider>(new DirectoryAssetProvider(assetsDir)));
+    DIR *dir = opendir(assetsDir.c_str());
+    if (dir == nullptr) {
+        fprintf(stderr, "can not open %s\n", assetsDir.c_str());
+        testFailures++;
+        return 0;
+    }
+    int count = 0;
+    while (dirent *entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() < 4 || name.compare(name.size() - 4, 4, ".png") != 0 || !isPngFile(assetsDir + "/" + name)) {
+            continue;
+        }
+        compareDecode(name, assetsDir + "/" + name);
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+int testGenerated(const std::string &dataDir) {
+    Assets::setProvider(std::unique_ptr<AssetProvider>(new DirectoryAssetProvider(dataDir)));
+    struct Format {
+        int colorType;
+        int bitDepth;
+        bool transparency;
+    };
+    const Format formats[] = {
+            {PNG_COLOR_TYPE_RGB, 8, false},
+            {PNG_COLOR_TYPE_RGB, 8, true},
+            {PNG_COLOR_TYPE_RGB, 16, false},
+            {PNG_COLOR_TYPE_RGB_ALPHA, 8, false},
+            {PNG_COLOR_TYPE_RGB_ALPHA, 16, false},
+            {PNG_COLOR_TYPE_PALETTE, 8, false},
+            {PNG_COLOR_TYPE_PALETTE, 8, true},
+            {PNG_COLOR_TYPE_PALETTE, 4, true},
+            {PNG_COLOR_TYPE_PALETTE, 2, false},
+            {PNG_COLOR_TYPE_PALETTE, 1, false},
+            {PNG_COLOR_TYPE_GRAY, 8, false},
+            {PNG_COLOR_TYPE_GRAY, 8, true},
+            {PNG_COLOR_TYPE_GRAY, 4, false},
+            {PNG_COLOR_TYPE_GRAY, 2, false},
+            {PNG_COLOR_TYPE_GRAY, 1, false},
+            {PNG_COLOR_TYPE_GRAY, 16, false},
+            {PNG_COLOR_TYPE_GRAY_ALPHA, 8, false},
+            {PNG_COLOR_TYPE_GRAY_ALPHA, 16, false},
+    };
+    const uint32_t widths[] = {1, 3, 17, 33, 64};
+    int count = 0;
+    for (const Format &format: formats) {
+        for (uint32_t width: widths) {
+            for (int interlace = 0; interlace < 2; interlace++) {
+                TestPngSpec spec = {width, 7, format.colorType, format.bitDepth, interlace != 0,
+                                    format.transparency, 0};
+                char name[64];
+                snprintf(name, sizeof(name), "decode_%d.png", count);
+                std::string path = dataDir + "/" + name;
+                if (!TestPng::write(path, spec, (uint32_t)count)) {
+                    testFailures++;
+                    continue;
+                }
+                int failuresBefore = testFailures;
+                compareDecode(name, path);
+                if (testFailures != failuresBefore) {
+                    fprintf(stderr, "  (%s)\n", TestPng::describe(spec).c_str());
+                }
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s ASSETS_DIR DATA_DIR\n", argv[0]);
+        return 2;
+    }
+    std::string dataDir = argv[2];
+    mkdir(dataDir.c_str(), 0755);
+
+    int bundled = testBundled(argv[1]);
+    CHECK(bundled > 0);
+    int generated = testGenerated(dataDir);
+    if (testFailures == 0) {
+        printf("PNG decode: %d bundled and %d generated images match the reference\n", bundled, generated);
+    }
+    return TEST_RESULT();
+}
@@ -0,0 +1,135 @@
+// bundled libpng的SSE2反滤波（intel/filter_sse2_intrinsics.c）和通用C实现的输出必须逐字节相同：
+//   test-png-filter ASSETS_DIR DATA_DIR
+// 同一张png解码两次，一次用png_set_option(PNG_INTEL_SSE2, OFF)关掉png_init_filter_functions_sse2。
+// 输入是assets目录下的png，以及强制Sub/Up/Avg/Paeth滤波、每像素3和4字节、宽1/3/257的生成图片。
+// 不是x86时没有SSE2的实现，两次解码走同一条路径
+
+#include <dirent.h>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "TestCheck.h"
+#include "TestPng.h"
+#include "../utils/libpng1_6_29/png.h"
+
+namespace {
+
+// 不做任何转换，输出就是反滤波之后的行，interlace的图片合并成完整的图
+bool decodeRaw(const std::string &path, bool sse2, std::vector<uint8_t> *pixels) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png_create_info_struct(png);
+    std::vector<png_bytep> rows;
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        fclose(file);
+        return false;
+    }
+    if (!sse2) {
+        CHECK(png_set_option(png, PNG_INTEL_SSE2, 0) != PNG_OPTION_INVALID);
+    }
+    png_init_io(png, file);
+    png_read_info(png, info);
+    png_set_interlace_handling(png);
+    png_read_update_info(png, info);
+
+    uint32_t height = png_get_image_height(png, info);
+    size_t rowBytes = png_get_rowbytes(png, info);
+    pixels->assign(rowBytes * height, 0);
+    rows.resize(height);
+    for (uint32_t y = 0; y < height; y++) {
+        rows[y] = pixels->data() + rowBytes * y;
+    }
+    png_read_image(png, rows.data());
+    png_read_end(png, nullptr);
+    png_destroy_read_struct(&png, &info, nullptr);
+    fclose(file);
+    return true;
+}
+
+void compareFilters(const std::string &path, const std::string &description) {
+    std::vector<uint8_t> scalar, sse2;
+    if (!decodeRaw(path, false, &scalar) || !decodeRaw(path, true, &sse2)) {
+        fprintf(stderr, "%s: decode failed\n", description.c_str());
+        testFailures++;
+        return;
+    }
+    if (scalar != sse2) {
+        size_t i = 0;
+        while (scalar[i] == sse2[i]) {
+            i++;
+        }
+        fprintf(stderr, "%s: byte %zu differs: generic %u, sse2 %u\n", description.c_str(), i, scalar[i], sse2[i]);
+        testFailures++;
+    }
+}
+
+int testGenerated(const std::string &dataDir) {
+    const int colorTypes[] = {PNG_COLOR_TYPE_RGB, PNG_COLOR_TYPE_RGB_ALPHA}; // 每像素3和4字节，SSE2只处理这两种
+    const int filters[] = {PNG_FILTER_SUB, PNG_FILTER_UP, PNG_FILTER_AVG, PNG_FILTER_PAETH, PNG_ALL_FILTERS};
+    const uint32_t widths[] = {1, 3, 257};
+    int count = 0;
+    for (int colorType: colorTypes) {
+        for (int filter: filters) {
+            for (uint32_t width: widths) {
+                for (int interlace = 0; interlace < 2; interlace++) {
+                    TestPngSpec spec = {width, 9, colorType, 8, interlace != 0, false, filter};
+                    std::string path = dataDir + "/filter_" + std::to_string(count) + ".png";
+                    if (!TestPng::write(path, spec, (uint32_t)count)) {
+                        testFailures++;
+                        continue;
+                    }
+                    compareFilters(path, TestPng::describe(spec));
+                    count++;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+int testBundled(const std::string &assetsDir) {
+    DIR *dir = opendir(assetsDir.c_str());
+    if (dir == nullptr) {
+        fprintf(stderr, "can not open %s\n", assetsDir.c_str());
+        testFailures++;
+        return 0;
+    }
+    int count = 0;
+    while (dirent *entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name.size() < 4 || name.compare(name.size() - 4, 4, ".png") != 0) {
+            continue;
+        }
+        compareFilters(assetsDir + "/" + name, name);
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s ASSETS_DIR DATA_DIR\n", argv[0]);
+        return 2;
+    }
+    std::string dataDir = argv[2];
+    mkdir(dataDir.c_str(), 0755);
+
+    int generated = testGenerated(dataDir);
+    int bundled = testBundled(argv[1]);
+    CHECK(bundled > 0);
+    if (testFailures == 0) {
+        printf("PNG filters: %d generated and %d bundled images decode identically with and without SSE2\n",
+               generated, bundled);
+    }
+    return TEST_RESULT();
+}
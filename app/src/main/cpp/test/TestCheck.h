@@ -0,0 +1,27 @@
+#ifndef NATIVEACTIVITYDEMO_TESTCHECK_H
+#define NATIVEACTIVITYDEMO_TESTCHECK_H
+
+#include <cstdio>
+
+// 开发机上的单元测试共用：检查失败时打印位置并记下失败次数，main里返回TEST_RESULT()
+static int testFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(expected, actual) \
+    do { \
+        if (!((expected) == (actual))) { \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s\n", __FILE__, __LINE__, #expected, #actual); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define TEST_RESULT() (testFailures == 0 ? 0 : 1)
+
+#endif //NATIVEACTIVITYDEMO_TESTCHECK_H
@@ -0,0 +1,161 @@
+#include "TestPng.h"
+#include <csetjmp>
+#include <cstdio>
+#include "../utils/libpng1_6_29/png.h"
+
+namespace {
+
+int channelsOf(int colorType) {
+    switch (colorType) {
+        case PNG_COLOR_TYPE_GRAY: return 1;
+        case PNG_COLOR_TYPE_GRAY_ALPHA: return 2;
+        case PNG_COLOR_TYPE_RGB: return 3;
+        case PNG_COLOR_TYPE_RGB_ALPHA: return 4;
+        default: return 1; // 调色板
+    }
+}
+
+// xorshift，不依赖rand()的实现
+uint32_t nextRandom(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+} // namespace
+
+bool TestPng::write(const std::string &path, const TestPngSpec &spec, uint32_t seed) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        fprintf(stderr, "can not write %s\n", path.c_str());
+        return false;
+    }
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png_create_info_struct(png);
+    if (setjmp(png_jmpbuf(png))) {
+        fprintf(stderr, "libpng error writing %s\n", path.c_str());
+        png_destroy_write_struct(&png, &info);
+        fclose(file);
+        return false;
+    }
+    png_init_io(png, file);
+    png_set_IHDR(png, info, spec.width, spec.height, spec.bitDepth, spec.colorType,
+                 spec.interlace ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+    uint32_t state = seed * 2654435761u + 1;
+    if (spec.colorType == PNG_COLOR_TYPE_PALETTE) {
+        int entries = 1 << spec.bitDepth;
+        std::vector<png_color> palette((size_t)entries);
+        for (png_color &color: palette) {
+            uint32_t value = nextRandom(&state);
+            color.red = (png_byte)value;
+            color.green = (png_byte)(value >> 8);
+            color.blue = (png_byte)(value >> 16);
+        }
+        png_set_PLTE(png, info, palette.data(), entries);
+        if (spec.transparency) {
+            png_byte alpha[4] = {0, 64, 128, 200};
+            png_set_tRNS(png, info, alpha, entries < 4 ? entries : 4, nullptr);
+        }
+    } else if (spec.transparency) {
+        // 透明色取一个肯定会出现的值：每行的第一个像素都是0
+        png_color_16 color = {0, 0, 0, 0, 0};
+        png_set_tRNS(png, info, nullptr, 0, &color);
+    }
+    if (spec.filter != 0) {
+        png_set_filter(png, PNG_FILTER_TYPE_BASE, spec.filter);
+    }
+    png_write_info(png, info);
+
+    int channels = channelsOf(spec.colorType);
+    size_t rowBytes = ((size_t)spec.width * channels * spec.bitDepth + 7) / 8;
+    std::vector<png_byte> pixels(rowBytes * spec.height);
+    std::vector<png_bytep> rows(spec.height);
+    for (uint32_t y = 0; y < spec.height; y++) {
+        png_bytep row = pixels.data() + rowBytes * y;
+        rows[y] = row;
+        for (size_t i = 0; i < rowBytes; i++) {
+            if (i == 0) {
+                row[i] = 0;
+            } else if ((y + i / 16) % 2 == 0) {
+                row[i] = (png_byte)(i * 3 + y * 7); // 渐变
+            } else {
+                row[i] = (png_byte)nextRandom(&state);
+            }
+        }
+    }
+    if (spec.transparency && spec.colorType != PNG_COLOR_TYPE_PALETTE) {
+        for (uint32_t y = 0; y < spec.height; y++) {
+            // 第一个像素整个清零，成为透明色
+            size_t pixelBytes = ((size_t)channels * spec.bitDepth + 7) / 8;
+            for (size_t i = 0; i < pixelBytes; i++) {
+                rows[y][i] = 0;
+            }
+        }
+    }
+    png_write_image(png, rows.data());
+    png_write_end(png, nullptr);
+    png_destroy_write_struct(&png, &info);
+    return fclose(file) == 0;
+}
+
+bool TestPng::decodeReference(const std::string &path, std::vector<uint8_t> *rgba, uint32_t *w, uint32_t *h) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    png_infop info = png_create_info_struct(png);
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        fclose(file);
+        return false;
+    }
+    png_init_io(png, file);
+    png_read_png(png, info, PNG_TRANSFORM_EXPAND | PNG_TRANSFORM_STRIP_16 | PNG_TRANSFORM_GRAY_TO_RGB, nullptr);
+    fclose(file);
+
+    *w = png_get_image_width(png, info);
+    *h = png_get_image_height(png, info);
+    int channels = png_get_channels(png, info); // 转换之后只会是3或4
+    png_bytepp rows = png_get_rows(png, info);
+    rgba->assign((size_t)*w * *h * 4, 0);
+    for (uint32_t y = 0; y < *h; y++) {
+        uint8_t *dst = rgba->data() + (size_t)(*h - 1 - y) * *w * 4;
+        for (uint32_t x = 0; x < *w; x++) {
+            const png_byte *src = rows[y] + (size_t)x * channels;
+            dst[x * 4 + 0] = src[0];
+            dst[x * 4 + 1] = src[1];
+            dst[x * 4 + 2] = src[2];
+            dst[x * 4 + 3] = channels == 4 ? src[3] : 0xff;
+        }
+    }
+    png_destroy_read_struct(&png, &info, nullptr);
+    return true;
+}
+
+std::string TestPng::describe(const TestPngSpec &spec) {
+    const char *type;
+    switch (spec.colorType) {
+        case PNG_COLOR_TYPE_GRAY: type = "gray"; break;
+        case PNG_COLOR_TYPE_GRAY_ALPHA: type = "gray-alpha"; break;
+        case PNG_COLOR_TYPE_RGB: type = "rgb"; break;
+        case PNG_COLOR_TYPE_RGB_ALPHA: type = "rgba"; break;
+        default: type = "palette"; break;
+    }
+    char text[128];
+    snprintf(text, sizeof(text), "%s%d %ux%u%s%s", type, spec.bitDepth, spec.width, spec.height,
+             spec.interlace ? " interlace" : "", spec.transparency ? " tRNS" : "");
+    std::string result = text;
+    if (spec.filter != 0) {
+        const char *name = spec.filter == PNG_FILTER_SUB ? "sub" : spec.filter == PNG_FILTER_UP ? "up" :
+                           spec.filter == PNG_FILTER_AVG ? "avg" : spec.filter == PNG_FILTER_PAETH ? "paeth" :
+                           "mixed";
+        result += std::string(" filter ") + name;
+    }
+    return result;
+}
@@ -0,0 +1,33 @@
+#ifndef NATIVEACTIVITYDEMO_TESTPNG_H
+#define NATIVEACTIVITYDEMO_TESTPNG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 生成测试用png的参数，colorType、bitDepth、filter取libpng的PNG_*常量
+struct TestPngSpec {
+    uint32_t width;
+    uint32_t height;
+    int colorType;
+    int bitDepth;
+    bool interlace;
+    bool transparency; // 写tRNS：调色板的前几项半透明，灰度和RGB指定一个透明色
+    int filter; // png_set_filter的参数，0表示libpng默认
+};
+
+/**
+ * png解码测试共用：生成各种格式的png，以及不经过TextureUtils的参考解码。
+ */
+class TestPng {
+public:
+    // 像素内容由spec和seed确定，既有平滑的渐变也有随机的噪声，各种filter都会用到
+    static bool write(const std::string &path, const TestPngSpec &spec, uint32_t seed);
+    // png_read_png整张读入后逐行复制，转成RGBA8并上下翻转，和TextureUtils::decodePNG的输出格式相同。
+    // 失败返回false
+    static bool decodeReference(const std::string &path, std::vector<uint8_t> *rgba, uint32_t *w, uint32_t *h);
+    // 用于日志，例如"rgb8 17x5 interlace"
+    static std::string describe(const TestPngSpec &spec);
+};
+
+#endif //NATIVEACTIVITYDEMO_TESTPNG_H
@@ -0,0 +1,123 @@
+#include "KtxTexture.h"
+#include "MipmapGenerator.h"
+#include "../gles/GLStateCache.h"
+#include "../platform/AssetProvider.h"
+#include "../app_log.h"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace {
+
+const uint8_t KTX_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+const uint32_t KTX_ENDIANNESS = 0x04030201;
+
+struct KtxHeader {
+    uint8_t identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+size_t blockBytes(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB8_ETC2:
+            return 8;
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+} // namespace
+
+std::unique_ptr<KtxImage> KtxTexture::read(const char *assetKtxName) {
+    int fd = Assets::openFd(assetKtxName);
+    if (fd <= 0) {
+        return nullptr; // 没有ktx文件是正常情况，调用者会回退到png
+    }
+    FILE *file = fdopen(fd, "r");
+    if (file == NULL) {
+        close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<KtxImage> image(new KtxImage());
+    KtxHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1
+              && memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0
+              && header.endianness == KTX_ENDIANNESS // etc2tool在小端机器上生成，和设备字节序一致
+              && header.glType == 0
+              && blockBytes(header.glInternalFormat) != 0
+              && header.pixelDepth == 0 && header.numberOfArrayElements == 0 && header.numberOfFaces == 1
+              && header.pixelWidth > 0 && header.pixelHeight > 0
+              && fseek(file, header.bytesOfKeyValueData, SEEK_CUR) == 0;
+
+    int levels = header.numberOfMipmapLevels > 0 ? (int)header.numberOfMipmapLevels : 1;
+    if (ok && levels > MipmapGenerator::levelCount(header.pixelWidth, header.pixelHeight)) {
+        ok = false;
+    }
+    for (int level = 0; ok && level < levels; level++) {
+        uint32_t w = MipmapGenerator::levelSize(header.pixelWidth, level);
+        uint32_t h = MipmapGenerator::levelSize(header.pixelHeight, level);
+        uint32_t expected = (uint32_t)(((w + 3) / 4) * ((h + 3) / 4) * blockBytes(header.glInternalFormat));
+        uint32_t imageSize = 0;
+        ok = fread(&imageSize, sizeof(imageSize), 1, file) == 1 && imageSize == expected;
+        if (!ok) {
+            break;
+        }
+        size_t offset = image->data.size();
+        image->data.resize(offset + imageSize);
+        ok = fread(&image->data[offset], 1, imageSize, file) == imageSize;
+        image->levelOffsets.push_back(offset);
+        image->levelSizes.push_back(imageSize);
+        // 块的大小是8的倍数，mipPadding总是0
+    }
+    fclose(file);
+
+    if (!ok) {
+        app_log("read ktx \"%s\" failed\n", assetKtxName);
+        return nullptr;
+    }
+    image->internalFormat = header.glInternalFormat;
+    image->width = header.pixelWidth;
+    image->height = header.pixelHeight;
+    return image;
+}
+
+void KtxTexture::upload(GLuint *textureId, const KtxImage &image) {
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    glGenTextures(1, textureId);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, *textureId);
+
+    int levels = (int)image.levelSizes.size();
+    for (int level = 0; level < levels; level++) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, image.internalFormat,
+                               MipmapGenerator::levelSize(image.width, level),
+                               MipmapGenerator::levelSize(image.height, level), 0,
+                               image.levelSizes[level], &image.data[image.levelOffsets[level]]);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+std::string KtxTexture::ktxNameFor(const char *assetPngName) {
+    std::string name(assetPngName);
+    size_t dot = name.rfind('.');
+    if (dot != std::string::npos) {
+        name.erase(dot);
+    }
+    return name + ".ktx";
+}
@@ -0,0 +1,36 @@
+#ifndef NATIVEACTIVITYDEMO_KTXTEXTURE_H
+#define NATIVEACTIVITYDEMO_KTXTEXTURE_H
+
+#include <GLES3/gl32.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// KTX 1.1文件里的ETC2压缩纹理，所有level的数据依次存放在data里
+struct KtxImage {
+    GLenum internalFormat = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> data;
+    std::vector<size_t> levelOffsets;
+    std::vector<uint32_t> levelSizes;
+};
+
+/**
+ * 读取tools/etc2tool生成的KTX文件，用glCompressedTexImage2D上传。
+ * 只支持GLES 3.0必须支持的GL_COMPRESSED_RGB8_ETC2和GL_COMPRESSED_RGBA8_ETC2_EAC，
+ * 显存占用是RGBA8的1/8和1/4。
+ */
+class KtxTexture {
+public:
+    // 读取并校验，不调用GL，可以在工作线程执行。文件不存在或格式不支持时返回nullptr
+    static std::unique_ptr<KtxImage> read(const char *assetKtxName);
+    // 上传所有level，多于一个level时使用三线性过滤。只能在GL线程调用
+    static void upload(GLuint *textureId, const KtxImage &image);
+    // png对应的ktx文件名，"skybox.png" -> "skybox.ktx"。有ktx文件时优先使用
+    static std::string ktxNameFor(const char *assetPngName);
+};
+
+#endif //NATIVEACTIVITYDEMO_KTXTEXTURE_H
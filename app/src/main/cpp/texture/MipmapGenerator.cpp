@@ -0,0 +1,113 @@
+#include "MipmapGenerator.h"
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+const int LINEAR_STEPS = 4096; // 线性空间量化到12位再查表转回sRGB，8位不够表示暗部
+const int LINEAR_FRACTION_BITS = 16; // toLinear的定点小数位，4个值相加也不会超出uint32
+
+struct GammaTables {
+    uint32_t toLinear[256]; // sRGB 8位 -> 线性，范围[0, LINEAR_STEPS - 1]，16位定点
+    uint8_t toSRGB[LINEAR_STEPS];
+
+    GammaTables() {
+        for (int i = 0; i < 256; i++) {
+            float c = i / 255.0f;
+            float linear = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+            toLinear[i] = (uint32_t)(linear * (LINEAR_STEPS - 1) * (1 << LINEAR_FRACTION_BITS) + 0.5f);
+        }
+        for (int i = 0; i < LINEAR_STEPS; i++) {
+            float linear = (float)i / (LINEAR_STEPS - 1);
+            float c = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+            toSRGB[i] = (uint8_t)(c * 255.0f + 0.5f);
+        }
+    }
+};
+
+const GammaTables &gammaTables() {
+    static const GammaTables tables; // 线程安全的一次性初始化
+    return tables;
+}
+
+// 4个线性值的平均四舍五入成toSRGB的下标。全是整数运算；查表没法向量化（SSE2没有gather），逐个分量算
+inline uint8_t averageToSRGB(const GammaTables &tables, uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+    uint32_t sum = tables.toLinear[a] + tables.toLinear[b] + tables.toLinear[c] + tables.toLinear[d];
+    return tables.toSRGB[(sum + (2u << LINEAR_FRACTION_BITS)) >> (LINEAR_FRACTION_BITS + 2)];
+}
+
+} // namespace
+
+int MipmapGenerator::levelCount(uint32_t w, uint32_t h) {
+    uint32_t size = w > h ? w : h;
+    int levels = 1;
+    while (size > 1) {
+        size >>= 1;
+        levels++;
+    }
+    return levels;
+}
+
+uint32_t MipmapGenerator::levelSize(uint32_t size, int level) {
+    size >>= level;
+    return size > 0 ? size : 1;
+}
+
+size_t MipmapGenerator::levelOffset(uint32_t w, uint32_t h, int level) {
+    size_t offset = 0;
+    for (int i = 0; i < level; i++) {
+        offset += (size_t)levelSize(w, i) * levelSize(h, i) * 4;
+    }
+    return offset;
+}
+
+size_t MipmapGenerator::chainBytes(uint32_t w, uint32_t h) {
+    return levelOffset(w, h, levelCount(w, h));
+}
+
+int MipmapGenerator::build(void **image, uint32_t w, uint32_t h) {
+    if (*image == nullptr || w == 0 || h == 0) {
+        return 1;
+    }
+    int levels = levelCount(w, h);
+    void *chain = realloc(*image, chainBytes(w, h));
+    if (chain == nullptr) {
+        return 1;
+    }
+    *image = chain;
+
+    uint8_t *src = (uint8_t *)chain;
+    for (int level = 1; level < levels; level++) {
+        uint32_t srcW = levelSize(w, level - 1);
+        uint32_t srcH = levelSize(h, level - 1);
+        uint8_t *dst = src + (size_t)srcW * srcH * 4;
+        downsample(src, srcW, srcH, dst);
+        src = dst;
+    }
+    return levels;
+}
+
+void MipmapGenerator::downsample(const uint8_t *src, uint32_t srcW, uint32_t srcH, uint8_t *dst) {
+    const GammaTables &tables = gammaTables();
+    uint32_t dstW = levelSize(srcW, 1);
+    uint32_t dstH = levelSize(srcH, 1);
+    size_t srcRowBytes = (size_t)srcW * 4;
+
+    for (uint32_t y = 0; y < dstH; y++) {
+        // levelSize向下取整，奇数尺寸时最后一行/列不参与，例如宽3时只平均第0、1列。
+        // 只有宽或高为1时才和自己平均
+        uint32_t y1 = 2 * y + 1 < srcH ? 2 * y + 1 : srcH - 1;
+        const uint8_t *row0 = src + srcRowBytes * (2 * y);
+        const uint8_t *row1 = src + srcRowBytes * y1;
+        uint8_t *out = dst + (size_t)dstW * 4 * y;
+        for (uint32_t x = 0; x < dstW; x++) {
+            uint32_t x0 = 2 * x * 4;
+            uint32_t x1 = (2 * x + 1 < srcW ? 2 * x + 1 : srcW - 1) * 4;
+            for (int c = 0; c < 3; c++) {
+                out[c] = averageToSRGB(tables, row0[x0 + c], row0[x1 + c], row1[x0 + c], row1[x1 + c]);
+            }
+            out[3] = (uint8_t)((row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3] + 2) >> 2);
+            out += 4;
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef NATIVEACTIVITYDEMO_MIPMAPGENERATOR_H
+#define NATIVEACTIVITYDEMO_MIPMAPGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 在cpu上为RGBA8图片生成完整的mipmap链，不调用GL，可以在工作线程执行。
+ * 颜色按sRGB存储，先转到线性空间再做2x2的box滤波，结果再转回sRGB；alpha直接线性平均。
+ * 奇数尺寸时下一级向下取整，最后一行/列被舍弃，不做3-tap的滤波。
+ * 各level在同一块内存里依次紧密排列：level0, level1, ... 直到1x1。
+ */
+class MipmapGenerator {
+public:
+    // 到1x1为止的level数
+    static int levelCount(uint32_t w, uint32_t h);
+    // level的宽高，最小为1
+    static uint32_t levelSize(uint32_t size, int level);
+    // level在整条链里的字节偏移
+    static size_t levelOffset(uint32_t w, uint32_t h, int level);
+    static size_t chainBytes(uint32_t w, uint32_t h);
+
+    // image是malloc分配的level0，成功时realloc成整条链并返回level数，image可能被移动。
+    // 失败时image不变，返回1
+    static int build(void **image, uint32_t w, uint32_t h);
+
+    // 由src（srcW x srcH）生成下一级，dst的尺寸是levelSize(src, 1)
+    static void downsample(const uint8_t *src, uint32_t srcW, uint32_t srcH, uint8_t *dst);
+};
+
+#endif //NATIVEACTIVITYDEMO_MIPMAPGENERATOR_H
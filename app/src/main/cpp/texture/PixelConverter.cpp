@@ -0,0 +1,247 @@
+#include "PixelConverter.h"
+#include "MipmapGenerator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// 每个分量的最大值和左移后的倍数，按RGBA的顺序
+struct PackInfo {
+    uint16_t maxValue[4];
+    uint16_t factor[4];
+};
+
+const PackInfo PACK_565 = {{31, 63, 31, 0}, {1 << 11, 1 << 5, 1, 0}};
+const PackInfo PACK_5551 = {{31, 31, 31, 1}, {1 << 11, 1 << 6, 1 << 1, 1}};
+const PackInfo PACK_4444 = {{15, 15, 15, 15}, {1 << 12, 1 << 8, 1 << 4, 1}};
+
+const PackInfo &packInfo(PixelFormat format) {
+    return format == PIXEL_RGB565 ? PACK_565 : (format == PIXEL_RGBA5551 ? PACK_5551 : PACK_4444);
+}
+
+const uint8_t BAYER4[4][4] = {
+        {0, 8, 2, 10},
+        {12, 4, 14, 6},
+        {3, 11, 1, 9},
+        {15, 7, 13, 5}
+};
+
+// 量化时加上的阈值，范围(0, 255)。不抖动时是127，即四舍五入；有序抖动时按Bayer矩阵均匀分布，
+// 一块区域内的平均值等于原来的颜色
+inline uint32_t threshold(DitherMode dither, uint32_t x, uint32_t y) {
+    return dither == DITHER_ORDERED ? BAYER4[y & 3][x & 3] * 16 + 8 : 127;
+}
+
+// x不超过255 * 63 + 255时等于x / 255，向下取整
+inline uint32_t div255(uint32_t x) {
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
+inline uint16_t packPixel(const uint8_t *p, const PackInfo &info, uint32_t t) {
+    uint32_t v = 0;
+    for (int c = 0; c < 4; c++) {
+        v += div255(p[c] * info.maxValue[c] + t) * info.factor[c];
+    }
+    return (uint16_t)v;
+}
+
+// 一次处理4个像素（x是4的倍数），返回处理到的x
+#if defined(__SSE2__)
+uint32_t packRow4(const uint8_t *src, uint32_t w, const PackInfo &info, const uint32_t *t, uint16_t *dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    const __m128i maxValue = _mm_set_epi16(info.maxValue[3], info.maxValue[2], info.maxValue[1], info.maxValue[0],
+                                           info.maxValue[3], info.maxValue[2], info.maxValue[1], info.maxValue[0]);
+    const __m128i factor = _mm_set_epi16(info.factor[3], info.factor[2], info.factor[1], info.factor[0],
+                                         info.factor[3], info.factor[2], info.factor[1], info.factor[0]);
+    // 同一行的阈值每4个像素重复一次
+    const __m128i tLo = _mm_set_epi16(t[1], t[1], t[1], t[1], t[0], t[0], t[0], t[0]);
+    const __m128i tHi = _mm_set_epi16(t[3], t[3], t[3], t[3], t[2], t[2], t[2], t[2]);
+    uint32_t x = 0;
+    for (; x + 4 <= w; x += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i *)(src + x * 4));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(px, zero), maxValue), tLo);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(px, zero), maxValue), tHi);
+        lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+        // 每个像素得到r * fr + g * fg和b * fb + a * fa两个32位的和
+        __m128 a = _mm_castsi128_ps(_mm_madd_epi16(lo, factor));
+        __m128 b = _mm_castsi128_ps(_mm_madd_epi16(hi, factor));
+        __m128i sum = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))),
+                                    _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+        // SSE2没有无符号的32位到16位pack，先平移到有符号的范围
+        sum = _mm_packs_epi32(_mm_sub_epi32(sum, bias), zero);
+        sum = _mm_xor_si128(sum, _mm_set1_epi16((short)0x8000));
+        _mm_storel_epi64((__m128i *)(dst + x), sum);
+    }
+    return x;
+}
+#elif defined(__ARM_NEON)
+uint32_t packRow4(const uint8_t *src, uint32_t w, const PackInfo &info, const uint32_t *t, uint16_t *dst) {
+    const uint16x8_t one = vdupq_n_u16(1);
+    uint16_t maxValues[8], factors[8], tLos[8], tHis[8];
+    for (int i = 0; i < 8; i++) {
+        maxValues[i] = info.maxValue[i & 3];
+        factors[i] = info.factor[i & 3];
+        tLos[i] = (uint16_t)t[i >> 2];
+        tHis[i] = (uint16_t)t[2 + (i >> 2)];
+    }
+    const uint16x8_t maxValue = vld1q_u16(maxValues);
+    const uint16x8_t factor = vld1q_u16(factors);
+    const uint16x8_t tLo = vld1q_u16(tLos);
+    const uint16x8_t tHi = vld1q_u16(tHis);
+    uint32_t x = 0;
+    for (; x + 4 <= w; x += 4) {
+        uint8x16_t px = vld1q_u8(src + x * 4);
+        uint16x8_t lo = vmlaq_u16(tLo, vmovl_u8(vget_low_u8(px)), maxValue);
+        uint16x8_t hi = vmlaq_u16(tHi, vmovl_u8(vget_high_u8(px)), maxValue);
+        lo = vshrq_n_u16(vaddq_u16(vaddq_u16(lo, one), vshrq_n_u16(lo, 8)), 8);
+        hi = vshrq_n_u16(vaddq_u16(vaddq_u16(hi, one), vshrq_n_u16(hi, 8)), 8);
+        // 各分量移位后互不重叠，相加不会超过16位
+        uint32x4_t sumLo = vpaddlq_u16(vmulq_u16(lo, factor));
+        uint32x4_t sumHi = vpaddlq_u16(vmulq_u16(hi, factor));
+        uint32x4_t sum = vcombine_u32(vpadd_u32(vget_low_u32(sumLo), vget_high_u32(sumLo)),
+                                      vpadd_u32(vget_low_u32(sumHi), vget_high_u32(sumHi)));
+        vst1_u16(dst + x, vmovn_u32(sum));
+    }
+    return x;
+}
+#else
+uint32_t packRow4(const uint8_t *, uint32_t, const PackInfo &, const uint32_t *, uint16_t *) {
+    return 0;
+}
+#endif
+
+void convertOrdered(const uint8_t *rgba, uint32_t w, uint32_t h, const PackInfo &info, DitherMode dither,
+                    uint16_t *out) {
+    for (uint32_t y = 0; y < h; y++) {
+        const uint8_t *src = rgba + (size_t)y * w * 4;
+        uint16_t *dst = out + (size_t)y * w;
+        uint32_t t[4];
+        for (uint32_t i = 0; i < 4; i++) {
+            t[i] = threshold(dither, i, y);
+        }
+        for (uint32_t x = packRow4(src, w, info, t, dst); x < w; x++) {
+            dst[x] = packPixel(src + x * 4, info, t[x & 3]);
+        }
+    }
+}
+
+// 误差按7/16、3/16、5/16、1/16分给右边、左下、下面、右下的像素，误差乘了16保存
+void convertDiffusion(const uint8_t *rgba, uint32_t w, uint32_t h, const PackInfo &info, uint16_t *out) {
+    // 每个分量的量化值还原成8位（乘16）的表，避免逐像素做除法
+    int32_t levels[4][64];
+    for (int c = 0; c < 4; c++) {
+        for (int32_t q = 0; q <= info.maxValue[c]; q++) {
+            levels[c][q] = info.maxValue[c] ? (q * 255 * 16 + info.maxValue[c] / 2) / info.maxValue[c] : 0;
+        }
+    }
+    // 两行误差，前后各多一个像素，不用判断边界
+    std::vector<int32_t> errors((w + 2) * 4 * 2, 0);
+    int32_t *curr = &errors[4];
+    int32_t *next = &errors[(w + 2) * 4 + 4];
+    for (uint32_t y = 0; y < h; y++) {
+        const uint8_t *src = rgba + (size_t)y * w * 4;
+        uint16_t *dst = out + (size_t)y * w;
+        for (uint32_t x = 0; x < w; x++) {
+            uint32_t v = 0;
+            for (int c = 0; c < 4; c++) {
+                int32_t maxValue = info.maxValue[c];
+                int32_t wanted = src[x * 4 + c] * 16 + curr[x * 4 + c];
+                wanted = wanted < 0 ? 0 : (wanted > 255 * 16 ? 255 * 16 : wanted);
+                int32_t q = (wanted * maxValue + 255 * 8) / (255 * 16);
+                int32_t err = wanted - levels[c][q];
+                curr[(x + 1) * 4 + c] += err * 7 >> 4;
+                next[((int32_t)x - 1) * 4 + c] += err * 3 >> 4;
+                next[x * 4 + c] += err * 5 >> 4;
+                next[(x + 1) * 4 + c] += err >> 4;
+                v += (uint32_t)q * info.factor[c];
+            }
+            dst[x] = (uint16_t)v;
+        }
+        std::swap(curr, next);
+        std::fill(next - 4, next + (w + 1) * 4, 0);
+    }
+}
+
+} // namespace
+
+PixelFormat PixelConverter::chooseFormat(const uint8_t *rgba, size_t pixelCount) {
+    bool opaque = true;
+    for (size_t i = 0; i < pixelCount; i++) {
+        uint8_t a = rgba[i * 4 + 3];
+        if (a != 255) {
+            opaque = false;
+            if (a != 0) {
+                return PIXEL_RGBA4444;
+            }
+        }
+    }
+    return opaque ? PIXEL_RGB565 : PIXEL_RGBA5551;
+}
+
+size_t PixelConverter::levelOffset(uint32_t w, uint32_t h, int level, PixelFormat format) {
+    return MipmapGenerator::levelOffset(w, h, level) / 4 * bytesPerPixel(format);
+}
+
+void PixelConverter::glFormat(PixelFormat format, GLenum *internalFormat, GLenum *pixelFormat, GLenum *type) {
+    switch (format) {
+        case PIXEL_RGB565:
+            *internalFormat = GL_RGB565;
+            *pixelFormat = GL_RGB;
+            *type = GL_UNSIGNED_SHORT_5_6_5;
+            break;
+        case PIXEL_RGBA5551:
+            *internalFormat = GL_RGB5_A1;
+            *pixelFormat = GL_RGBA;
+            *type = GL_UNSIGNED_SHORT_5_5_5_1;
+            break;
+        case PIXEL_RGBA4444:
+            *internalFormat = GL_RGBA4;
+            *pixelFormat = GL_RGBA;
+            *type = GL_UNSIGNED_SHORT_4_4_4_4;
+            break;
+        default:
+            *internalFormat = GL_RGBA8;
+            *pixelFormat = GL_RGBA;
+            *type = GL_UNSIGNED_BYTE;
+            break;
+    }
+}
+
+void PixelConverter::convert(const uint8_t *rgba, uint32_t w, uint32_t h, PixelFormat format, DitherMode dither,
+                             uint16_t *out) {
+    if (format == PIXEL_RGBA8888) {
+        return;
+    }
+    if (dither == DITHER_DIFFUSION) {
+        convertDiffusion(rgba, w, h, packInfo(format), out);
+    } else {
+        convertOrdered(rgba, w, h, packInfo(format), dither, out);
+    }
+}
+
+void PixelConverter::convertChain(void **image, uint32_t w, uint32_t h, int levels, PixelFormat format,
+                                  DitherMode dither) {
+    if (*image == nullptr || format == PIXEL_RGBA8888) {
+        return;
+    }
+    uint8_t *chain = (uint8_t *)*image;
+    for (int level = 0; level < levels; level++) {
+        convert(chain + MipmapGenerator::levelOffset(w, h, level),
+                MipmapGenerator::levelSize(w, level), MipmapGenerator::levelSize(h, level), format, dither,
+                (uint16_t *)(chain + levelOffset(w, h, level, format)));
+    }
+    void *shrunk = realloc(chain, levelOffset(w, h, levels, format));
+    if (shrunk != nullptr) {
+        *image = shrunk;
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef NATIVEACTIVITYDEMO_PIXELCONVERTER_H
+#define NATIVEACTIVITYDEMO_PIXELCONVERTER_H
+
+#include <GLES3/gl32.h>
+#include <cstddef>
+#include <cstdint>
+
+enum PixelFormat {
+    PIXEL_RGBA8888,
+    PIXEL_RGB565, // 不透明
+    PIXEL_RGBA5551, // alpha只有0和255
+    PIXEL_RGBA4444 // 有半透明
+};
+
+enum DitherMode {
+    DITHER_NONE, // 四舍五入
+    DITHER_ORDERED, // 4x4 Bayer矩阵，每个像素独立计算，SSE2/NEON一次处理4个像素
+    DITHER_DIFFUSION // Floyd-Steinberg误差扩散，依赖左边和上一行的误差，只能逐像素计算
+};
+
+/**
+ * 把RGBA8像素转成16位格式，显存和上传的数据量减半。不调用GL，可以在工作线程执行。
+ * 16位像素按GL_UNSIGNED_SHORT_5_6_5等packed类型的定义存放：r在最高位，本机字节序。
+ */
+class PixelConverter {
+public:
+    // 根据alpha内容选择：全部不透明用RGB565，alpha只有0和255用RGBA5551，否则RGBA4444
+    static PixelFormat chooseFormat(const uint8_t *rgba, size_t pixelCount);
+    static uint32_t bytesPerPixel(PixelFormat format) { return format == PIXEL_RGBA8888 ? 4 : 2; }
+    // 和MipmapGenerator相同排列的链里，level的字节偏移
+    static size_t levelOffset(uint32_t w, uint32_t h, int level, PixelFormat format);
+    // glTexStorage2D用的internalFormat，glTexSubImage2D用的format和type
+    static void glFormat(PixelFormat format, GLenum *internalFormat, GLenum *pixelFormat, GLenum *type);
+
+    // rgba和out可以是同一块内存，out在前面，已经写出的部分不会覆盖还没读取的像素
+    static void convert(const uint8_t *rgba, uint32_t w, uint32_t h, PixelFormat format, DitherMode dither,
+                        uint16_t *out);
+    // image是MipmapGenerator::build生成的levels级RGBA8链，逐级原地转换后realloc成较小的16位链，image可能被移动
+    static void convertChain(void **image, uint32_t w, uint32_t h, int levels, PixelFormat format, DitherMode dither);
+};
+
+#endif //NATIVEACTIVITYDEMO_PIXELCONVERTER_H
@@ -0,0 +1,23 @@
+#ifndef NATIVEACTIVITYDEMO_SOFTTEXTURE_H
+#define NATIVEACTIVITYDEMO_SOFTTEXTURE_H
+
+#include <cstdint>
+#include <cstdlib>
+
+// 软件光栅化使用的纹理，cpu内存里的RGBA8图片和完整的mipmap链（见MipmapGenerator），行从下往上，和GL纹理一致。
+struct SoftTexture {
+    uint8_t *pixels = nullptr; // malloc分配
+    uint32_t width = 0;
+    uint32_t height = 0;
+    int levels = 1;
+
+    SoftTexture() = default;
+    SoftTexture(const SoftTexture &) = delete;
+    SoftTexture &operator=(const SoftTexture &) = delete;
+
+    ~SoftTexture() {
+        free(pixels);
+    }
+};
+
+#endif //NATIVEACTIVITYDEMO_SOFTTEXTURE_H
@@ -0,0 +1,37 @@
+#ifndef NATIVEACTIVITYDEMO_TEXTURE_H
+#define NATIVEACTIVITYDEMO_TEXTURE_H
+
+#include <GLES3/gl32.h>
+#include <cstddef>
+#include <memory>
+#include "../gles/GLStateCache.h"
+
+// 纹理的加载选项。不透明或者alpha简单的贴图用16位格式，显存和上传量减半，见PixelConverter
+enum TextureOption {
+    TEXTURE_RGBA8,
+    TEXTURE_16BIT, // 有序抖动
+    TEXTURE_16BIT_DIFFUSION // 误差扩散抖动，没有规则的纹路，转换更慢
+};
+
+// GL纹理对象的所有权，最后一个持有者释放时删除纹理。
+struct Texture {
+    GLuint id = 0;
+    // 使用纹理中的哪一块：u0, v0, u方向缩放, v方向缩放。只有图集中的子纹理不是整张
+    GLfloat uvRect[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+    // 图集中的子纹理持有所在的page，id是page的，由page负责删除
+    std::shared_ptr<Texture> page;
+    // 显存占用的字节数，包括所有mipmap level，压缩纹理按压缩后的大小。由创建纹理的地方填写，TextureManager据此统计
+    size_t bytes = 0;
+
+    Texture() = default;
+    Texture(const Texture &) = delete;
+    Texture &operator=(const Texture &) = delete;
+
+    ~Texture() {
+        if (id != 0 && !page) {
+            GLStateCache::deleteTextures(1, &id);
+        }
+    }
+};
+
+#endif //NATIVEACTIVITYDEMO_TEXTURE_H
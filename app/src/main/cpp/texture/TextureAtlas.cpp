@@ -0,0 +1,180 @@
+#include "TextureAtlas.h"
+#include "MipmapGenerator.h"
+#include "../resource/TextureManager.h"
+#include "../app_log.h"
+#include <cstring>
+
+std::vector<TextureAtlas::Page> TextureAtlas::pages;
+std::unordered_map<std::string, TextureAtlas::Region> TextureAtlas::regions;
+
+static uint32_t alignUp4(uint32_t v) {
+    return (v + 3) & ~3u;
+}
+
+TextureAtlas::Page &TextureAtlas::newPage() {
+    Page page;
+    page.texture = std::make_shared<Texture>();
+    page.skyline.push_back({0, 0, PAGE_SIZE});
+
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    glGenTextures(1, &page.texture->id);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, page.texture->id);
+    glTexStorage2D(GL_TEXTURE_2D, PAGE_LEVELS, GL_RGBA8, PAGE_SIZE, PAGE_SIZE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    page.texture->bytes = MipmapGenerator::levelOffset(PAGE_SIZE, PAGE_SIZE, PAGE_LEVELS);
+    // 区域只在加载时写入，换出后无法恢复，page一直驻留
+    TextureManager::track("#atlas page " + std::to_string(pages.size()), page.texture, false);
+
+    pages.push_back(std::move(page));
+    app_log("texture atlas: page %d created\n", (int)pages.size() - 1);
+    return pages.back();
+}
+
+// skyline bottom-left：在所有能放下的位置中选顶边最低的，一样低时选最左边的
+bool TextureAtlas::allocate(Page &page, uint32_t w, uint32_t h, uint32_t *outX, uint32_t *outY) {
+    std::vector<SkylineNode> &skyline = page.skyline;
+    size_t bestIndex = skyline.size();
+    uint32_t bestTop = UINT32_MAX, bestX = 0, bestY = 0;
+    for (size_t i = 0; i < skyline.size(); i++) {
+        uint32_t x = skyline[i].x;
+        if (x + w > PAGE_SIZE) {
+            break; // 后面的节点x更大
+        }
+        // 区域横跨的各段里最高的那段决定了y
+        uint32_t y = 0;
+        uint32_t widthLeft = w;
+        for (size_t j = i; widthLeft > 0; j++) {
+            y = skyline[j].y > y ? skyline[j].y : y;
+            widthLeft = skyline[j].width >= widthLeft ? 0 : widthLeft - skyline[j].width;
+        }
+        if (y + h <= PAGE_SIZE && y + h < bestTop) {
+            bestTop = y + h;
+            bestIndex = i;
+            bestX = x;
+            bestY = y;
+        }
+    }
+    if (bestIndex == skyline.size()) {
+        return false;
+    }
+
+    skyline.insert(skyline.begin() + bestIndex, {bestX, bestY + h, w});
+    // 新节点覆盖到的部分从后面的节点中去掉
+    for (size_t i = bestIndex + 1; i < skyline.size();) {
+        uint32_t coveredEnd = bestX + w;
+        if (skyline[i].x >= coveredEnd) {
+            break;
+        }
+        uint32_t shrink = coveredEnd - skyline[i].x;
+        if (shrink >= skyline[i].width) {
+            skyline.erase(skyline.begin() + i);
+            continue;
+        }
+        skyline[i].x += shrink;
+        skyline[i].width -= shrink;
+        break;
+    }
+    // 合并高度相同的相邻节点
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            i++;
+        }
+    }
+    *outX = bestX;
+    *outY = bestY;
+    return true;
+}
+
+std::shared_ptr<Texture> TextureAtlas::makeSubTexture(const Region &region) {
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+    texture->page = pages[region.page].texture;
+    texture->id = texture->page->id;
+    memcpy(texture->uvRect, region.uvRect, sizeof(texture->uvRect));
+    return texture;
+}
+
+std::shared_ptr<Texture> TextureAtlas::find(const std::string &name) {
+    auto it = regions.find(name);
+    if (it == regions.end()) {
+        return nullptr;
+    }
+    return makeSubTexture(it->second);
+}
+
+std::shared_ptr<Texture> TextureAtlas::add(const std::string &name, const void *image, uint32_t w, uint32_t h) {
+    if (image == nullptr || w == 0 || h == 0 || !accepts(w, h)) {
+        return nullptr;
+    }
+    auto it = regions.find(name);
+    if (it != regions.end()) {
+        return makeSubTexture(it->second);
+    }
+
+    // 四周重复边缘像素，并补齐到4的倍数，之后每缩小一级都是整像素对齐
+    uint32_t paddedW = alignUp4(w + PADDING * 2);
+    uint32_t paddedH = alignUp4(h + PADDING * 2);
+    uint32_t x = 0, y = 0;
+    int pageIndex = -1;
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (allocate(pages[i], paddedW, paddedH, &x, &y)) {
+            pageIndex = (int)i;
+            break;
+        }
+    }
+    if (pageIndex < 0) {
+        if (!allocate(newPage(), paddedW, paddedH, &x, &y)) {
+            return nullptr;
+        }
+        pageIndex = (int)pages.size() - 1;
+    }
+
+    size_t chainBytes = 0;
+    for (int level = 0; level < PAGE_LEVELS; level++) {
+        chainBytes += (size_t)(paddedW >> level) * (paddedH >> level) * 4;
+    }
+    std::vector<uint8_t> chain(chainBytes);
+    const uint8_t *src = (const uint8_t *)image;
+    for (uint32_t py = 0; py < paddedH; py++) {
+        int sy = (int)py - (int)PADDING;
+        sy = sy < 0 ? 0 : (sy >= (int)h ? (int)h - 1 : sy);
+        for (uint32_t px = 0; px < paddedW; px++) {
+            int sx = (int)px - (int)PADDING;
+            sx = sx < 0 ? 0 : (sx >= (int)w ? (int)w - 1 : sx);
+            memcpy(&chain[((size_t)py * paddedW + px) * 4], src + ((size_t)sy * w + sx) * 4, 4);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, pages[pageIndex].texture->id);
+    size_t offset = 0;
+    for (int level = 0; level < PAGE_LEVELS; level++) {
+        uint32_t levelW = paddedW >> level, levelH = paddedH >> level;
+        size_t levelBytes = (size_t)levelW * levelH * 4;
+        if (level + 1 < PAGE_LEVELS) {
+            MipmapGenerator::downsample(&chain[offset], levelW, levelH, &chain[offset + levelBytes]);
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, level, x >> level, y >> level, levelW, levelH,
+                        GL_RGBA, GL_UNSIGNED_BYTE, &chain[offset]);
+        offset += levelBytes;
+    }
+
+    Region region;
+    region.page = pageIndex;
+    region.uvRect[0] = (GLfloat)(x + PADDING) / PAGE_SIZE;
+    region.uvRect[1] = (GLfloat)(y + PADDING) / PAGE_SIZE;
+    region.uvRect[2] = (GLfloat)w / PAGE_SIZE;
+    region.uvRect[3] = (GLfloat)h / PAGE_SIZE;
+    regions[name] = region;
+    app_log("texture atlas: %s %ux%u -> page %d (%u, %u)\n", name.c_str(), w, h, pageIndex, x, y);
+    return makeSubTexture(region);
+}
+
+void TextureAtlas::release() {
+    pages.clear();
+    regions.clear();
+}
@@ -0,0 +1,62 @@
+#ifndef NATIVEACTIVITYDEMO_TEXTUREATLAS_H
+#define NATIVEACTIVITYDEMO_TEXTUREATLAS_H
+
+#include <GLES3/gl32.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Texture.h"
+
+/**
+ * 把小纹理（纯色、小贴图）在加载时用skyline算法装进共享的page，使用它们的绘制排序后不再需要切换纹理。
+ * 返回的子纹理id是page的，uvRect是所在区域，shader里把模型的uv映射到这个区域，
+ * 因此只适用于uv在[0, 1]内、不依赖GL_REPEAT的模型。
+ * 每个区域四周重复边缘像素PADDING个，page只有PAGE_LEVELS级mipmap，最小一级的边仍有1像素，不会混入相邻区域。
+ * 只能在GL线程调用。
+ */
+class TextureAtlas {
+public:
+    static const uint32_t PAGE_SIZE = 256;
+    static const uint32_t MAX_REGION_SIZE = 64; // 更大的纹理仍然单独创建
+    static const uint32_t PADDING = 4;
+    static const int PAGE_LEVELS = 3; // 区域按4像素对齐，缩小两次后边界仍然对齐
+
+    static bool accepts(uint32_t w, uint32_t h) { return w <= MAX_REGION_SIZE && h <= MAX_REGION_SIZE; }
+
+    // image是上下翻转后的RGBA像素（和decodePNG一致），放不下时返回nullptr
+    static std::shared_ptr<Texture> add(const std::string &name, const void *image, uint32_t w, uint32_t h);
+    // 已经装进图集的不需要重新解码，没有时返回nullptr
+    static std::shared_ptr<Texture> find(const std::string &name);
+
+    static int getPageCount() { return (int)pages.size(); }
+    // context销毁前调用，已经分配出去的子纹理仍然持有各自的page
+    static void release();
+
+private:
+    struct SkylineNode {
+        uint32_t x;
+        uint32_t y; // 这一段已经占用到的高度
+        uint32_t width;
+    };
+
+    struct Page {
+        std::shared_ptr<Texture> texture;
+        std::vector<SkylineNode> skyline;
+    };
+
+    struct Region {
+        int page;
+        GLfloat uvRect[4];
+    };
+
+    static std::vector<Page> pages;
+    static std::unordered_map<std::string, Region> regions;
+
+    static bool allocate(Page &page, uint32_t w, uint32_t h, uint32_t *outX, uint32_t *outY);
+    static Page &newPage();
+    static std::shared_ptr<Texture> makeSubTexture(const Region &region);
+};
+
+#endif //NATIVEACTIVITYDEMO_TEXTUREATLAS_H
@@ -0,0 +1,167 @@
+#include "TextureUploader.h"
+#include "MipmapGenerator.h"
+#include "../gles/GLStateCache.h"
+#include <cstdlib>
+#include <cstring>
+
+GLuint TextureUploader::pbos[PBO_COUNT] = {0};
+GLsync TextureUploader::fences[PBO_COUNT] = {nullptr};
+int TextureUploader::nextPbo = 0;
+size_t TextureUploader::frameBudget = 2 * 1024 * 1024;
+std::deque<TextureUploader::Request> TextureUploader::requests;
+
+void TextureUploader::enqueue(void *image, uint32_t w, uint32_t h, int levels, PixelFormat format, Callback callback) {
+    Request request;
+    request.texture = std::make_shared<Texture>();
+    request.texture->bytes = PixelConverter::levelOffset(w, h, levels, format);
+    request.image = image;
+    request.width = w;
+    request.height = h;
+    request.levels = levels;
+    request.format = format;
+    request.callback = std::move(callback);
+
+    // 先分配好不可变的存储，之后只用glTexSubImage2D填充
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    glGenTextures(1, &request.texture->id);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, request.texture->id);
+    GLenum internalFormat, pixelFormat, type;
+    PixelConverter::glFormat(format, &internalFormat, &pixelFormat, &type);
+    glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, w, h);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    requests.push_back(std::move(request));
+}
+
+// PBO上一次的glTexSubImage2D已经执行完，才能再次写入
+bool TextureUploader::acquirePbo(int index) {
+    if (pbos[0] == 0) {
+        glGenBuffers(PBO_COUNT, pbos);
+        for (GLuint pbo: pbos) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, TILE_BYTES, nullptr, GL_STREAM_DRAW);
+        }
+    }
+    if (fences[index] != nullptr) {
+        GLenum result = glClientWaitSync(fences[index], 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            return false;
+        }
+        glDeleteSync(fences[index]);
+        fences[index] = nullptr;
+    }
+    return true;
+}
+
+void TextureUploader::pump() {
+    if (requests.empty()) {
+        return;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLStateCache::activeTexture(GL_TEXTURE0);
+
+    size_t uploaded = 0;
+    while (!requests.empty() && (uploaded == 0 || uploaded < frameBudget)) {
+        if (!acquirePbo(nextPbo)) {
+            break; // GPU还没用完，下一帧再继续
+        }
+        Request &request = requests.front();
+        uint32_t pixelBytes = PixelConverter::bytesPerPixel(request.format);
+        // 一个PBO里依次放当前level剩下的行和后面的level。各level在image里是连续的，一次memcpy即可，
+        // 后面很小的level会合在同一个PBO里，不会每个level都占一个PBO和fence
+        size_t tileBytes = 0;
+        int level = request.level;
+        uint32_t rows = request.rowsUploaded;
+        while (level < request.levels) {
+            size_t rowBytes = (size_t)MipmapGenerator::levelSize(request.width, level) * pixelBytes;
+            uint32_t levelRows = MipmapGenerator::levelSize(request.height, level) - rows;
+            uint32_t tileRows = (uint32_t)((TILE_BYTES - tileBytes) / rowBytes);
+            if (tileRows == 0 && tileBytes == 0) {
+                tileRows = 1; // 宽度超过16384的纹理GL本身也不支持，这里只防止死循环
+            }
+            if (tileRows == 0) {
+                break;
+            }
+            if (tileRows < levelRows) {
+                tileBytes += rowBytes * tileRows;
+                break;
+            }
+            tileBytes += rowBytes * levelRows;
+            level++;
+            rows = 0;
+        }
+        size_t srcOffset = request.levelOffset +
+                (size_t)request.rowsUploaded * MipmapGenerator::levelSize(request.width, request.level) * pixelBytes;
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[nextPbo]);
+        void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, tileBytes,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (dst == nullptr) {
+            break;
+        }
+        memcpy(dst, (GLubyte *)request.image + srcOffset, tileBytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        GLStateCache::bindTexture(GL_TEXTURE_2D, request.texture->id);
+        GLenum internalFormat, pixelFormat, type;
+        PixelConverter::glFormat(request.format, &internalFormat, &pixelFormat, &type);
+        size_t pboOffset = 0;
+        while (pboOffset < tileBytes) {
+            uint32_t levelW = MipmapGenerator::levelSize(request.width, request.level);
+            uint32_t levelH = MipmapGenerator::levelSize(request.height, request.level);
+            size_t rowBytes = (size_t)levelW * pixelBytes;
+            uint32_t tileRows = (uint32_t)((tileBytes - pboOffset) / rowBytes);
+            if (tileRows > levelH - request.rowsUploaded) {
+                tileRows = levelH - request.rowsUploaded;
+            }
+            // 绑定了PBO时，最后一个参数是PBO内的偏移
+            glTexSubImage2D(GL_TEXTURE_2D, request.level, 0, request.rowsUploaded, levelW, tileRows,
+                            pixelFormat, type, (const void *)pboOffset);
+            pboOffset += rowBytes * tileRows;
+            request.rowsUploaded += tileRows;
+            if (request.rowsUploaded >= levelH) {
+                request.levelOffset += rowBytes * levelH;
+                request.level++;
+                request.rowsUploaded = 0;
+            }
+        }
+        fences[nextPbo] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        nextPbo = (nextPbo + 1) % PBO_COUNT;
+        uploaded += tileBytes;
+
+        if (request.level >= request.levels) {
+            Request done = std::move(request);
+            requests.pop_front();
+            free(done.image);
+            done.image = nullptr;
+            if (done.callback) {
+                done.callback(done.texture);
+            }
+        }
+    }
+    // 其他地方还会从客户端内存上传纹理，不能让PBO一直绑定着
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void TextureUploader::cancelAll() {
+    for (Request &request: requests) {
+        free(request.image);
+    }
+    requests.clear();
+}
+
+void TextureUploader::release() {
+    cancelAll();
+    for (GLsync &fence: fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    if (pbos[0] != 0) {
+        glDeleteBuffers(PBO_COUNT, pbos);
+        memset(pbos, 0, sizeof(pbos));
+    }
+    nextPbo = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef NATIVEACTIVITYDEMO_TEXTUREUPLOADER_H
+#define NATIVEACTIVITYDEMO_TEXTUREUPLOADER_H
+
+#include <GLES3/gl32.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include "Texture.h"
+#include "PixelConverter.h"
+
+/**
+ * 通过一组GL_PIXEL_UNPACK_BUFFER把大纹理分成若干行带（tile），分几帧用glTexSubImage2D上传。
+ * 每个PBO用完后插入fence，fence还没signal时本帧停止上传，不会让cpu等待GPU。
+ * 每帧上传的字节数有上限，可以配置。纹理完整上传（包括所有mipmap level）后才回调，之前不会被绘制。
+ * 只能在GL线程调用。
+ */
+class TextureUploader {
+public:
+    typedef std::function<void(const std::shared_ptr<Texture> &)> Callback;
+
+    static const size_t TILE_BYTES = 512 * 1024; // 每个PBO的大小，也是一次glTexSubImage2D的上限
+    static const int PBO_COUNT = 4;
+
+    // image是format格式的像素，levels大于1时是MipmapGenerator生成的整条链（16位格式时经过PixelConverter::convertChain）。
+    // 所有权转移给TextureUploader，上传完后free
+    static void enqueue(void *image, uint32_t w, uint32_t h, int levels, PixelFormat format, Callback callback);
+    // 每帧调用一次，最多上传bytesPerFrame字节（至少一个tile）
+    static void pump();
+    static void setFrameBudget(size_t bytesPerFrame) { frameBudget = bytesPerFrame; }
+    static bool hasPending() { return !requests.empty(); }
+
+    // 丢弃还没上传完的纹理，不回调
+    static void cancelAll();
+    // context销毁前调用
+    static void release();
+
+private:
+    struct Request {
+        std::shared_ptr<Texture> texture;
+        void *image = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        int levels = 1;
+        PixelFormat format = PIXEL_RGBA8888;
+        int level = 0; // 正在上传的level
+        size_t levelOffset = 0; // 当前level在image里的偏移
+        uint32_t rowsUploaded = 0; // 当前level已经上传的行数
+        Callback callback;
+    };
+
+    static GLuint pbos[PBO_COUNT];
+    static GLsync fences[PBO_COUNT];
+    static int nextPbo;
+    static size_t frameBudget;
+    static std::deque<Request> requests;
+
+    static bool acquirePbo(int index);
+};
+
+#endif //NATIVEACTIVITYDEMO_TEXTUREUPLOADER_H
@@ -4,16 +4,21 @@
 
 #include <GLES3/gl32.h>
 #include "TextureUtils.h"
+#include "MipmapGenerator.h"
+#include "TextureAtlas.h"
+#include "../gles/GLStateCache.h"
 #include "../utils/libpng1_6_29/png.h"
 #include "../app_log.h"
-#include "../utils/AndroidAssetUtils.h"
+#include "../platform/AssetProvider.h"
+#include "../utils/ThreadPool.h"
 #include <cerrno>
 #include <cstring>
 #include <cstdlib>
 #include <unistd.h>
+#include <csetjmp>
+#include <vector>
 
-static void loadPng(uint32_t *w, uint32_t *h, void **image, const char *pngFile) {
-    int fd = AndroidAssetUtils::openFdFromAsset(pngFile);
+static void loadPng(uint32_t *w, uint32_t *h, void **image, const char *pngFile, int fd) {
     if (fd <= 0) {
         app_log("openFdFromAsset failed: err: %s\n", strerror(errno));
         return;
@@ -28,25 +33,50 @@ static void loadPng(uint32_t *w, uint32_t *h, void **image, const char *pngFile)
 
     png_structp pngStructp = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
     png_infop pngInfop = png_create_info_struct(pngStructp);
+    png_bytepp volatile rows = NULL; // setjmp之后会修改，需要volatile
+    png_bytep volatile pixels = NULL;
+
+    // libpng出错时longjmp回这里
+    if (setjmp(png_jmpbuf(pngStructp))) {
+        app_log("decode png \"%s\" failed\n", pngFile);
+        png_destroy_read_struct(&pngStructp, &pngInfop, NULL);
+        fclose(file);
+        free(rows);
+        free(pixels);
+        return;
+    }
 
     png_init_io(pngStructp, file);
-    // 内部已经调用read_info，read_end，外面再调会崩溃
-    png_read_png(pngStructp, pngInfop, PNG_TRANSFORM_EXPAND, NULL);
-
-    fclose(file);
+    png_read_info(pngStructp, pngInfop);
 
     int bit_depth, color_type;
     png_get_IHDR(pngStructp, pngInfop, w, h, &bit_depth, &color_type, NULL, NULL, NULL);
 
-    *image = malloc((*w) * (*h) * 4);
-    png_bytepp rows = png_get_rows(pngStructp, pngInfop);
-    uint32_t rowbytes = png_get_rowbytes(pngStructp, pngInfop);
-    for (int row = 0; row < *h; row++) {
+    // 统一转成8位RGBA，在解码的同时完成，不需要再单独转换一遍
+    png_set_expand(pngStructp); // 调色板转RGB，低于8位的灰度扩展到8位，tRNS转成alpha通道
+    png_set_strip_16(pngStructp);
+    png_set_gray_to_rgb(pngStructp);
+    if ((color_type & PNG_COLOR_MASK_ALPHA) == 0 && !png_get_valid(pngStructp, pngInfop, PNG_INFO_tRNS)) {
+        png_set_add_alpha(pngStructp, 0xff, PNG_FILLER_AFTER);
+    }
+    png_set_interlace_handling(pngStructp);
+    png_read_update_info(pngStructp, pngInfop);
+
+    uint32_t rowbytes = (*w) * 4;
+    pixels = (png_bytep)malloc((size_t)rowbytes * (*h));
+    rows = (png_bytepp)malloc(sizeof(png_bytep) * (*h));
+    for (uint32_t row = 0; row < *h; row++) {
         // texture接收的图片像素值是上下倒置的，注意「不是」旋转180度。
-        memcpy((png_bytep)*image + (*h - 1 - row) * rowbytes, rows[row], rowbytes);
+        // 行指针直接指向翻转后的位置，解码结果一次写到最终的buffer里
+        rows[row] = pixels + (size_t)(*h - 1 - row) * rowbytes;
     }
+    png_read_image(pngStructp, rows);
+    png_read_end(pngStructp, NULL);
 
     png_destroy_read_struct(&pngStructp, &pngInfop, NULL);
+    fclose(file);
+    free(rows);
+    *image = pixels;
 }
 
 /* 3 x 3 Image,  R G B A Channels RAW Format. */
@@ -71,46 +101,137 @@ GLubyte TextureUtils::pixelsRed[1 * 4] = {
         255, 0, 0, 255
 };
 
-GLuint TextureUtils::textureIds[2] = {0};
+std::shared_ptr<Texture> TextureUtils::simpleTextures[2];
 
 void TextureUtils::loadSimpleTexture() {
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // 名字不是asset路径，不会和png冲突
+    simpleTextures[0] = TextureAtlas::add("#green", pixelsGreen, 1, 1);
+    simpleTextures[1] = TextureAtlas::add("#red", pixelsRed, 1, 1);
+}
 
-    glActiveTexture(GL_TEXTURE0); // 激活纹理单元（texure unit），对应frag shader中的sampler2D变量。
+void TextureUtils::deleteSimpleTexture() {
+    simpleTextures[0] = nullptr;
+    simpleTextures[1] = nullptr;
+    TextureAtlas::release();
+}
 
-    glGenTextures(2, textureIds); // 生成纹理对象id
+void TextureUtils::loadPNGTexture(const char *pngFile, GLuint *textureId) {
+    uint32_t w = 0, h = 0;
+    void *image = decodePNG(pngFile, &w, &h);
+    int levels = MipmapGenerator::build(&image, w, h);
+    uploadTexture(textureId, w, h, image, levels);
+    free(image);
+}
 
-    glBindTexture(GL_TEXTURE_2D, textureIds[0]);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixelsGreen);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+void TextureUtils::loadPNGTextures(const char *const *pngFiles, int count, GLuint *textureIds) {
+    std::vector<void *> images(count, nullptr);
+    std::vector<uint32_t> ws(count, 0);
+    std::vector<uint32_t> hs(count, 0);
+    std::vector<int> levels(count, 1);
+    decodePNGs(pngFiles, count, images.data(), ws.data(), hs.data(), levels.data());
+    for (int i = 0; i < count; i++) {
+        uploadTexture(&textureIds[i], ws[i], hs[i], images[i], levels[i]);
+        free(images[i]);
+    }
+}
 
-    glBindTexture(GL_TEXTURE_2D, textureIds[1]);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixelsRed);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+static void decodeWithMips(const char *pngFile, void **image, uint32_t *w, uint32_t *h, int *levels) {
+    *image = TextureUtils::decodePNG(pngFile, w, h);
+    if (levels != nullptr) {
+        *levels = MipmapGenerator::build(image, *w, *h);
+    }
 }
 
-void TextureUtils::deleteSimpleTexture() {
-    glDeleteTextures(2, textureIds);
+void TextureUtils::decodePNGs(const char *const *pngFiles, int count, void **images, uint32_t *ws, uint32_t *hs,
+                              int *levels) {
+    unsigned int threadCount = ThreadPool::defaultThreadCount() + 1; // 调用线程只是等待，也算进来
+    if (threadCount > (unsigned int)count) {
+        threadCount = count;
+    }
+    if (threadCount <= 1) {
+        for (int i = 0; i < count; i++) {
+            decodeWithMips(pngFiles[i], &images[i], &ws[i], &hs[i], levels ? &levels[i] : nullptr);
+        }
+        return;
+    }
+    ThreadPool pool(threadCount);
+    for (int i = 0; i < count; i++) {
+        pool.post([=]() {
+            decodeWithMips(pngFiles[i], &images[i], &ws[i], &hs[i], levels ? &levels[i] : nullptr);
+        });
+    }
+    // pool析构时等待所有任务完成
 }
 
-void TextureUtils::loadPNGTexture(const char *pngFile, GLuint *textureId) {
+void *TextureUtils::decodePNG(const char *pngFile, uint32_t *w, uint32_t *h) {
+    void *image = nullptr;
+    loadPng(w, h, &image, pngFile, Assets::openFd(pngFile));
+    return image;
+}
+
+void *TextureUtils::decodePNG(AssetProvider &provider, const char *pngFile, uint32_t *w, uint32_t *h) {
+    void *image = nullptr;
+    loadPng(w, h, &image, pngFile, provider.openFd(pngFile));
+    return image;
+}
+
+bool TextureUtils::encodePNG(const char *path, const void *rgba, uint32_t w, uint32_t h) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        app_log("encodePNG: can not open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    png_structp pngStructp = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop pngInfop = png_create_info_struct(pngStructp);
+    if (setjmp(png_jmpbuf(pngStructp))) {
+        app_log("encodePNG: libpng error: %s\n", path);
+        png_destroy_write_struct(&pngStructp, &pngInfop);
+        fclose(file);
+        return false;
+    }
+    png_init_io(pngStructp, file);
+    png_set_IHDR(pngStructp, pngInfop, w, h, 8, PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(pngStructp, pngInfop);
+    for (uint32_t y = 0; y < h; y++) {
+        png_write_row(pngStructp, (png_const_bytep)rgba + (size_t)y * w * 4);
+    }
+    png_write_end(pngStructp, NULL);
+    png_destroy_write_struct(&pngStructp, &pngInfop);
+    return fclose(file) == 0;
+}
+
+PixelFormat TextureUtils::applyOption(void **image, uint32_t w, uint32_t h, int levels, TextureOption option) {
+    if (*image == nullptr || option == TEXTURE_RGBA8 || TextureAtlas::accepts(w, h)) {
+        return PIXEL_RGBA8888;
+    }
+    PixelFormat format = PixelConverter::chooseFormat((const uint8_t *)*image, (size_t)w * h);
+    PixelConverter::convertChain(image, w, h, levels, format,
+                                 option == TEXTURE_16BIT_DIFFUSION ? DITHER_DIFFUSION : DITHER_ORDERED);
+    return format;
+}
+
+void TextureUtils::uploadTexture(GLuint *textureId, uint32_t w, uint32_t h, const void *image, int levels,
+                                 PixelFormat format) {
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    glActiveTexture(GL_TEXTURE0); // 激活纹理单元（texure unit），对应frag shader中的sampler2D变量。
+    GLStateCache::activeTexture(GL_TEXTURE0); // 激活纹理单元（texure unit），对应frag shader中的sampler2D变量。
 
     glGenTextures(1, textureId); // 生成纹理对象id
 
-    glBindTexture(GL_TEXTURE_2D, *textureId); // 对于一个纹理单元只能绑定同一种target类型：GL_TEXTURE_2D, GL_TEXTURE_3D等
-    uint32_t w, h;
-    void *image = nullptr;
-    loadPng(&w, &h, &image, pngFile);
+    GLStateCache::bindTexture(GL_TEXTURE_2D, *textureId); // 对于一个纹理单元只能绑定同一种target类型：GL_TEXTURE_2D, GL_TEXTURE_3D等
     if (image == nullptr) {
         return;
     }
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-    free(image);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    GLenum internalFormat, pixelFormat, type;
+    PixelConverter::glFormat(format, &internalFormat, &pixelFormat, &type);
+    for (int level = 0; level < levels; level++) {
+        glTexImage2D(GL_TEXTURE_2D, level, internalFormat,
+                     MipmapGenerator::levelSize(w, level), MipmapGenerator::levelSize(h, level), 0,
+                     pixelFormat, type, (const GLubyte *)image + PixelConverter::levelOffset(w, h, level, format));
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    // 缩小时在两级mipmap之间三线性插值，远处的地形和房子不再闪烁
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 }
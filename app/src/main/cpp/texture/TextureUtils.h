@@ -6,13 +6,39 @@
 #define NATIVEACTIVITYDEMO_TEXTUREUTILS_H
 
 #include <GLES3/gl32.h>
+#include <cstdint>
+#include <memory>
+#include "Texture.h"
+#include "PixelConverter.h"
+
+class AssetProvider;
 
 class TextureUtils {
 public:
     static void loadPNGTexture(const char *pngFile, GLuint *textureId);
+    // 多个png在线程池中并行解码（每个线程各自的png_struct），全部完成后在调用线程里一次性创建纹理
+    static void loadPNGTextures(const char *const *pngFiles, int count, GLuint *textureIds);
+    // 并行解码，images、ws、hs各有count个元素，失败的image为nullptr。
+    // levels不为nullptr时在解码线程里接着生成mipmap链，见MipmapGenerator::build
+    static void decodePNGs(const char *const *pngFiles, int count, void **images, uint32_t *ws, uint32_t *hs,
+                           int *levels = nullptr);
+    // 解码为上下翻转后的RGBA像素，不调用GL，可以在工作线程执行。失败返回nullptr，成功时由调用者free
+    static void *decodePNG(const char *pngFile, uint32_t *w, uint32_t *h);
+    // 从指定的provider读取，不经过Assets，例如不在apk里的测试数据
+    static void *decodePNG(AssetProvider &provider, const char *pngFile, uint32_t *w, uint32_t *h);
+    // 把RGBA8的像素（从上到下按行排列）写成png文件，path是文件系统路径，不是asset
+    static bool encodePNG(const char *path, const void *rgba, uint32_t w, uint32_t h);
+    // 按option把MipmapGenerator生成的RGBA8链转成16位格式，返回image现在的格式。不调用GL，可以在工作线程执行。
+    // 会装进图集的小纹理保持RGBA8
+    static PixelFormat applyOption(void **image, uint32_t w, uint32_t h, int levels, TextureOption option);
+    // 生成纹理并上传format格式的像素，image为nullptr时只生成纹理对象。
+    // levels大于1时image是MipmapGenerator生成的整条链，使用三线性过滤
+    static void uploadTexture(GLuint *textureId, uint32_t w, uint32_t h, const void *image, int levels = 1,
+                              PixelFormat format = PIXEL_RGBA8888);
+    // 纯色纹理放在图集里，和其他小纹理共用一个纹理对象
     static void loadSimpleTexture();
     static void deleteSimpleTexture();
-    static GLuint textureIds[];
+    static std::shared_ptr<Texture> simpleTextures[2]; // [绿色, 红色]
 private:
     static GLubyte pixels[];
     static GLubyte pixelsGreen[];
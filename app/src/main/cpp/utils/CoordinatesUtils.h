@@ -6,6 +6,7 @@
 #define NATIVEACTIVITYDEMO_COORDINATESUTILS_H
 
 #include <GLES3/gl32.h>
+#include <memory>
 #include <unordered_map>
 #include "../entity/MapLocInfo.h"
 
@@ -0,0 +1,36 @@
+#include "FrameStats.h"
+#include "../app_log.h"
+#include <algorithm>
+
+FrameStatsSummary FrameStats::summarize() const {
+    FrameStatsSummary summary = {0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    if (samples.empty()) {
+        return summary;
+    }
+    std::vector<long> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    long long sum = 0;
+    for (long us: sorted) {
+        sum += us;
+    }
+    // 最近秩法，p99在样本少时就是最大值
+    auto percentile = [&sorted](int p) {
+        size_t rank = (sorted.size() * p + 99) / 100;
+        return sorted[rank > 0 ? rank - 1 : 0] / 1000.0f;
+    };
+    summary.frames = sorted.size();
+    summary.avgMs = (float)(sum / (double)sorted.size() / 1000.0);
+    summary.minMs = sorted.front() / 1000.0f;
+    summary.maxMs = sorted.back() / 1000.0f;
+    summary.p50Ms = percentile(50);
+    summary.p95Ms = percentile(95);
+    summary.p99Ms = percentile(99);
+    return summary;
+}
+
+void FrameStats::log(const char *tag) const {
+    FrameStatsSummary summary = summarize();
+    app_log("%s: %zu frames, avg: %.2fms, min: %.2fms, p50: %.2fms, p95: %.2fms, p99: %.2fms, max: %.2fms\n",
+            tag, summary.frames, summary.avgMs, summary.minMs, summary.p50Ms, summary.p95Ms, summary.p99Ms,
+            summary.maxMs);
+}
@@ -0,0 +1,35 @@
+#ifndef NATIVEACTIVITYDEMO_FRAMESTATS_H
+#define NATIVEACTIVITYDEMO_FRAMESTATS_H
+
+#include <cstddef>
+#include <vector>
+
+// 单位都是毫秒
+struct FrameStatsSummary {
+    size_t frames;
+    float avgMs;
+    float minMs;
+    float maxMs;
+    float p50Ms;
+    float p95Ms;
+    float p99Ms;
+};
+
+/**
+ * 收集帧时间，统计平均值、最值和分位数，用于窗口模式的周期日志和headless模式的测试报告。
+ */
+class FrameStats {
+public:
+    void add(long frameUS) { samples.push_back(frameUS); }
+    void clear() { samples.clear(); }
+    size_t count() const { return samples.size(); }
+    const std::vector<long> &getSamples() const { return samples; }
+
+    FrameStatsSummary summarize() const;
+    void log(const char *tag) const;
+
+private:
+    std::vector<long> samples; // 微秒
+};
+
+#endif //NATIVEACTIVITYDEMO_FRAMESTATS_H
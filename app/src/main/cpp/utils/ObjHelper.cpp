@@ -66,7 +66,7 @@ static void genMapInfoHeight(ObjHelper::ObjData *pObjData, GLfloat x, GLfloat y,
     }
 }
 
-static void genMapInfoNormal(ObjHelper::ObjData *pObjData, GLfloat vx, GLfloat vy, GLfloat vz,
+static void genMapInfoNormal(ObjHelper::ObjData *pObjData, GLfloat vx, GLfloat /*vy*/, GLfloat vz,
                              GLfloat nx, GLfloat ny, GLfloat nz) {
     int fixedX = (int)(vx * ObjHelper::heightMapSampleFactor);
     int fixedZ = (int)(vz * ObjHelper::heightMapSampleFactor);
@@ -141,7 +141,7 @@ static void readIndexInfo(FILE *file, ObjHelper::ObjData *pObjData, bool hasTexC
 // 按照obj文件格式读出来后，顶点，纹理和法向量坐标都有各自的索引数组。
 // 现在新建一套匹配的顶点，纹理和法向量坐标，由同一个索引数组控制。
 // 这可能会导致各坐标数组变大，包含重复的坐标数据，这是统一索引的代价。
-static void rearrangeVVtVns(ObjHelper::ObjData *pObjData, bool isSmoothLight, bool needGenMapInfo) {
+void ObjHelper::rearrangeVVtVns(ObjHelper::ObjData *pObjData, bool isSmoothLight, bool needGenMapInfo) {
     using namespace std;
     vector<GLfloat> vs;
     vector<GLfloat> vts;
@@ -230,6 +230,14 @@ void ObjHelper::readObjFile(FILE *file, ObjHelper::ObjData *pObjData, bool needG
     if (file == nullptr) return;
 
     long time0 = Utils::getCurrTimeUS();
+    parseObjFile(file, pObjData, needGenMapInfo, hasTexCoords);
+    long time1 = Utils::getCurrTimeUS();
+    rearrangeVVtVns(pObjData, isSmoothLight, needGenMapInfo);
+    app_log("parseTime: %ld(us), rearrangeTime: %ld(us)\n", time1 - time0, Utils::getCurrTimeUS() - time1);
+}
+
+void ObjHelper::parseObjFile(FILE *file, ObjHelper::ObjData *pObjData, bool needGenMapInfo, bool hasTexCoords) {
+    if (file == nullptr) return;
 
     bool shouldQuit = false;
     int c;
@@ -271,7 +279,4 @@ void ObjHelper::readObjFile(FILE *file, ObjHelper::ObjData *pObjData, bool needG
         pObjData->texCoords.push_back(0.5f); // 如果没有生成纹理坐标，就创建一个坐标，使用纹理的中心点颜色
         pObjData->texCoords.push_back(0.5f);
     }
-    long time1 = Utils::getCurrTimeUS();
-    rearrangeVVtVns(pObjData, isSmoothLight, needGenMapInfo);
-    app_log("parseTime: %ld(us), rearrangeTime: %ld(us)\n", time1 - time0, Utils::getCurrTimeUS() - time1);
 }
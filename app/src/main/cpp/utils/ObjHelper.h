@@ -7,6 +7,7 @@
 
 #include <cstdio>
 #include <vector>
+#include <memory>
 #include <unordered_map>
 #include <GLES3/gl32.h>
 #include "../entity/MapLocInfo.h"
@@ -39,6 +40,9 @@ public:
     };
     static float heightMapSampleFactor; // 表示取浮点数小数部分的位数，10表示1位，100表示两位等等。注意只能是整数。
     static void readObjFile(FILE *file, ObjData *pObjData, bool needGenMapInfo, bool hasTexCoords, bool isSmoothLight);
+    // readObjFile的两步，分开是为了能单独测量：解析文本，然后把v、vt、vn整理成同一个索引
+    static void parseObjFile(FILE *file, ObjData *pObjData, bool needGenMapInfo, bool hasTexCoords);
+    static void rearrangeVVtVns(ObjData *pObjData, bool isSmoothLight, bool needGenMapInfo);
 };
 
 #endif //NATIVEACTIVITYDEMO_OBJHELPER_H
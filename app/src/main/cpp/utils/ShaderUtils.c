@@ -61,6 +61,8 @@ GLuint linkShader(GLuint vertShaderID, GLuint fragShaderID) {
         // Attach vertex and fragment shader to it
         glAttachShader(program, vertShaderID);
         glAttachShader(program, fragShaderID);
+        // 链接前声明之后要用glGetProgramBinary取出，有的驱动不声明时返回的长度为0
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
         // Link the program
         glLinkProgram(program);
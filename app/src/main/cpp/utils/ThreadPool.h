@@ -0,0 +1,32 @@
+#ifndef NATIVEACTIVITYDEMO_THREADPOOL_H
+#define NATIVEACTIVITYDEMO_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定数量的工作线程，任务按提交顺序执行，析构时等待已提交的任务执行完。
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    void post(std::function<void()> task);
+
+    // 除去调用线程以外，可以用来干活的核数，至少为1
+    static unsigned int defaultThreadCount();
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+
+    void workerLoop();
+};
+
+#endif //NATIVEACTIVITYDEMO_THREADPOOL_H
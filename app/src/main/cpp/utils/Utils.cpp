@@ -3,18 +3,14 @@
 //
 
 #include "Utils.h"
+#include "../platform/Clock.h"
 #include <cstring>
 #include <ctime>
 #include <cstdio>
 #include <cstdlib>
 
 long Utils::getCurrTimeUS() {
-    struct timeval ts = {
-            .tv_sec = 0,
-            .tv_usec = 0
-    };
-    gettimeofday(&ts, nullptr);
-    return ts.tv_usec + ts.tv_sec * 1000000;
+    return Clock::nowUS();
 }
 
 // fixedNum支持0-9
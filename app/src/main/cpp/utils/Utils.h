@@ -8,6 +8,7 @@
 
 class Utils {
 public:
+    // 见Clock，默认是单调时钟
     static long getCurrTimeUS();
     // fixedNum支持0-9
     static float toFixedFloat(float origin, int fixedNum);
@@ -0,0 +1,301 @@
+/* filter_sse2_intrinsics.c - SSE2 optimized filter functions
+ *
+ * Based on the arm/filter_neon_intrinsics.c structure in libpng 1.6.29.
+ *
+ * This code is released under the libpng license.
+ * For conditions of distribution and use, see the disclaimer
+ * and license in png.h
+ */
+
+#include "../pngpriv.h"
+
+#ifdef PNG_READ_SUPPORTED
+
+#if PNG_INTEL_SSE_IMPLEMENTATION > 0
+
+#include <emmintrin.h>
+#include <string.h>
+
+/* Functions in this file look at most 3 pixels (a,b,c) to predict the 4th (d).
+ * They're positioned like this:
+ *    prev:  c b
+ *    row:   a d
+ * The Sub filter predicts d=a, Avg d=(a+b)/2, and Paeth predicts d to be
+ * whichever of a, b, or c is closest to p=a+b-c.
+ *
+ * Each pixel depends on the one to its left, so the work is done one pixel
+ * per iteration in the low lanes of a register; wider vectors do not help.
+ */
+
+static __m128i
+load4(const void *p)
+{
+   int v;
+
+   memcpy(&v, p, 4); /* rows are not aligned */
+   return _mm_cvtsi32_si128(v);
+}
+
+static void
+store4(void *p, __m128i v)
+{
+   int i = _mm_cvtsi128_si32(v);
+
+   memcpy(p, &i, 4);
+}
+
+static __m128i
+load3(const void *p)
+{
+   int v = 0;
+
+   memcpy(&v, p, 3);
+   return _mm_cvtsi32_si128(v);
+}
+
+static void
+store3(void *p, __m128i v)
+{
+   int i = _mm_cvtsi128_si32(v);
+
+   memcpy(p, &i, 3);
+}
+
+void
+png_read_filter_row_sub3_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   /* The Sub filter predicts each pixel as the previous pixel, a.
+    * There is no pixel to the left of the first pixel.  It's encoded directly.
+    * That works with our main loop if we just say that left pixel was zero.
+    */
+   png_size_t rb = row_info->rowbytes;
+   __m128i a, d = _mm_setzero_si128();
+
+   png_debug(1, "in png_read_filter_row_sub3_sse2");
+
+   while (rb >= 4)
+   {
+      /* 4 byte loads are fine here, the 4th byte is still inside the row */
+      a = d; d = load4(row);
+      d = _mm_add_epi8(d, a);
+      store3(row, d);
+
+      row += 3;
+      rb  -= 3;
+   }
+
+   if (rb > 0)
+   {
+      a = d; d = load3(row);
+      d = _mm_add_epi8(d, a);
+      store3(row, d);
+   }
+
+   PNG_UNUSED(prev)
+}
+
+void
+png_read_filter_row_sub4_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_size_t rb = row_info->rowbytes;
+   __m128i a, d = _mm_setzero_si128();
+
+   png_debug(1, "in png_read_filter_row_sub4_sse2");
+
+   while (rb >= 4)
+   {
+      a = d; d = load4(row);
+      d = _mm_add_epi8(d, a);
+      store4(row, d);
+
+      row += 4;
+      rb  -= 4;
+   }
+
+   PNG_UNUSED(prev)
+}
+
+/* PNG requires a truncating average, _mm_avg_epu8 rounds up; subtract 1 back
+ * off where a and b have different low bits.
+ */
+static __m128i
+avg_floor(__m128i a, __m128i b)
+{
+   __m128i avg = _mm_avg_epu8(a, b);
+
+   return _mm_sub_epi8(avg, _mm_and_si128(_mm_xor_si128(a, b),
+       _mm_set1_epi8(1)));
+}
+
+void
+png_read_filter_row_avg3_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   /* The Avg filter predicts each pixel as the (truncated) average of a and b.
+    * There's no pixel to the left of the first pixel.  Luckily, it's
+    * predicted to be half of the pixel above it.  So again, this works
+    * perfectly with our loop if we make sure a starts at zero.
+    */
+   png_size_t rb = row_info->rowbytes;
+   __m128i b;
+   __m128i a, d = _mm_setzero_si128();
+
+   png_debug(1, "in png_read_filter_row_avg3_sse2");
+
+   while (rb >= 4)
+   {
+      b = load4(prev);
+      a = d; d = load4(row);
+      d = _mm_add_epi8(d, avg_floor(a, b));
+      store3(row, d);
+
+      prev += 3;
+      row  += 3;
+      rb   -= 3;
+   }
+
+   if (rb > 0)
+   {
+      b = load3(prev);
+      a = d; d = load3(row);
+      d = _mm_add_epi8(d, avg_floor(a, b));
+      store3(row, d);
+   }
+}
+
+void
+png_read_filter_row_avg4_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_size_t rb = row_info->rowbytes;
+   __m128i b;
+   __m128i a, d = _mm_setzero_si128();
+
+   png_debug(1, "in png_read_filter_row_avg4_sse2");
+
+   while (rb >= 4)
+   {
+      b = load4(prev);
+      a = d; d = load4(row);
+      d = _mm_add_epi8(d, avg_floor(a, b));
+      store4(row, d);
+
+      prev += 4;
+      row  += 4;
+      rb   -= 4;
+   }
+}
+
+/* Returns |x| for packed signed 16-bit values. */
+static __m128i
+abs_i16(__m128i x)
+{
+   /* To negate two's complement, flip all the bits then add 1. */
+   __m128i is_negative = _mm_cmplt_epi16(x, _mm_setzero_si128());
+
+   x = _mm_xor_si128(x, is_negative);
+   x = _mm_sub_epi16(x, is_negative);
+   return x;
+}
+
+/* Bytewise c ? t : e. */
+static __m128i
+if_then_else(__m128i c, __m128i t, __m128i e)
+{
+   return _mm_or_si128(_mm_and_si128(c, t), _mm_andnot_si128(c, e));
+}
+
+/* a, b, c and d hold one pixel widened to 16-bit lanes; returns the new d. */
+static __m128i
+paeth_pixel(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+   __m128i pa, pb, pc, smallest, nearest;
+
+   /* (p-a) == (a+b-c - a) == (b-c) */
+   pa = _mm_sub_epi16(b, c);
+   /* (p-b) == (a+b-c - b) == (a-c) */
+   pb = _mm_sub_epi16(a, c);
+   /* (p-c) == (a+b-c - c) == (b-c)+(a-c) */
+   pc = _mm_add_epi16(pa, pb);
+
+   pa = abs_i16(pa);
+   pb = abs_i16(pb);
+   pc = abs_i16(pc);
+
+   smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+   /* Paeth breaks ties favoring a over b over c. */
+   nearest = if_then_else(_mm_cmpeq_epi16(smallest, pa), a,
+       if_then_else(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+   /* Note `_epi8`: the addition has to wrap modulo 256 in each low byte, the
+    * high bytes of the 16-bit lanes stay zero.
+    */
+   return _mm_add_epi8(d, nearest);
+}
+
+void
+png_read_filter_row_paeth3_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   /* The first pixel has no left context, and so uses an Up filter, p=b.
+    * This works naturally with our main loop's p=a+b-c if we force a and c
+    * to zero.  Here we zero b and d, which become c and a respectively at the
+    * start of the loop.
+    */
+   png_size_t rb = row_info->rowbytes;
+   const __m128i zero = _mm_setzero_si128();
+   __m128i c, b = zero,
+           a, d = zero;
+
+   png_debug(1, "in png_read_filter_row_paeth3_sse2");
+
+   while (rb >= 4)
+   {
+      c = b; b = _mm_unpacklo_epi8(load4(prev), zero);
+      a = d; d = _mm_unpacklo_epi8(load4(row), zero);
+      d = paeth_pixel(a, b, c, d);
+      store3(row, _mm_packus_epi16(d, d));
+
+      prev += 3;
+      row  += 3;
+      rb   -= 3;
+   }
+
+   if (rb > 0)
+   {
+      c = b; b = _mm_unpacklo_epi8(load3(prev), zero);
+      a = d; d = _mm_unpacklo_epi8(load3(row), zero);
+      d = paeth_pixel(a, b, c, d);
+      store3(row, _mm_packus_epi16(d, d));
+   }
+}
+
+void
+png_read_filter_row_paeth4_sse2(png_row_infop row_info, png_bytep row,
+    png_const_bytep prev)
+{
+   png_size_t rb = row_info->rowbytes;
+   const __m128i zero = _mm_setzero_si128();
+   __m128i c, b = zero,
+           a, d = zero;
+
+   png_debug(1, "in png_read_filter_row_paeth4_sse2");
+
+   while (rb >= 4)
+   {
+      c = b; b = _mm_unpacklo_epi8(load4(prev), zero);
+      a = d; d = _mm_unpacklo_epi8(load4(row), zero);
+      d = paeth_pixel(a, b, c, d);
+      store4(row, _mm_packus_epi16(d, d));
+
+      prev += 4;
+      row  += 4;
+      rb   -= 4;
+   }
+}
+
+#endif /* PNG_INTEL_SSE_IMPLEMENTATION > 0 */
+#endif /* PNG_READ_SUPPORTED */
@@ -0,0 +1,87 @@
+/* intel_init.c - SSE2 optimized filter functions
+ *
+ * Based on the arm/arm_init.c structure in libpng 1.6.29.
+ *
+ * This code is released under the libpng license.
+ * For conditions of distribution and use, see the disclaimer
+ * and license in png.h
+ */
+
+#include "../pngpriv.h"
+
+#ifdef PNG_READ_SUPPORTED
+#if PNG_INTEL_SSE_IMPLEMENTATION > 0
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#  include <cpuid.h>
+
+/* Run-time check.  SSE2 is part of the x86-64 baseline and of the Android x86
+ * ABI, so on every target this is built for it should succeed; it is still
+ * checked so that a 32-bit build compiled with -msse2 does not crash on a CPU
+ * without it.
+ */
+static int
+png_have_sse2(void)
+{
+   unsigned int eax, ebx, ecx, edx;
+
+   if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+      return 0;
+
+   return (edx & bit_SSE2) != 0;
+}
+#else
+static int
+png_have_sse2(void)
+{
+   return 1; /* Only compiled when the compiler targets SSE2 */
+}
+#endif
+
+void
+png_init_filter_functions_sse2(png_structp pp, unsigned int bpp)
+{
+   /* The SSE2 code works on one pixel at a time, so it only helps 3 and 4
+    * byte pixels; Up has no pixel-to-pixel dependency and is left to the
+    * compiler's auto-vectorization of the generic code.
+    */
+   static volatile int no_sse2 = -1; /* not checked */
+
+   png_debug(1, "in png_init_filter_functions_sse2");
+
+#ifdef PNG_SET_OPTION_SUPPORTED
+   /* Unlike NEON the SSE2 code is used by default; turning the option OFF
+    * keeps the generic C filters, which is how the host test compares the
+    * two implementations.
+    */
+   if (((pp->options >> PNG_INTEL_SSE2) & 3) == PNG_OPTION_OFF)
+      return;
+#endif
+
+   if (no_sse2 < 0)
+      no_sse2 = !png_have_sse2();
+
+   if (no_sse2)
+      return;
+
+   /* IMPORTANT: any new external functions used here must be declared using
+    * PNG_INTERNAL_FUNCTION in ../pngpriv.h.
+    */
+   if (bpp == 3)
+   {
+      pp->read_filter[PNG_FILTER_VALUE_SUB-1] = png_read_filter_row_sub3_sse2;
+      pp->read_filter[PNG_FILTER_VALUE_AVG-1] = png_read_filter_row_avg3_sse2;
+      pp->read_filter[PNG_FILTER_VALUE_PAETH-1] =
+         png_read_filter_row_paeth3_sse2;
+   }
+
+   else if (bpp == 4)
+   {
+      pp->read_filter[PNG_FILTER_VALUE_SUB-1] = png_read_filter_row_sub4_sse2;
+      pp->read_filter[PNG_FILTER_VALUE_AVG-1] = png_read_filter_row_avg4_sse2;
+      pp->read_filter[PNG_FILTER_VALUE_PAETH-1] =
+         png_read_filter_row_paeth4_sse2;
+   }
+}
+#endif /* PNG_INTEL_SSE_IMPLEMENTATION > 0 */
+#endif /* PNG_READ_SUPPORTED */
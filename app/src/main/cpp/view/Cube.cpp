@@ -12,7 +12,7 @@ Cube::Cube(): Shape() {
     glGenVertexArrays(1, &vao);
     glGenBuffers(3, buffers);
 
-    glBindVertexArray(vao); // 以下的操作都会记录在这个vao上，绑定成功后，会自动接触之前的绑定。
+    GLStateCache::bindVertexArray(vao); // 以下的操作都会记录在这个vao上，绑定成功后，会自动接触之前的绑定。
 
     glBindBuffer(GL_ARRAY_BUFFER, buffers[0]); // 绑定成功后，会自动接触之前的绑定。
     GLfloat cubePoints[] = {
@@ -83,23 +83,22 @@ Cube::Cube(): Shape() {
 
 Cube::~Cube() {
     glDeleteBuffers(3, buffers);
-    glDeleteVertexArrays(1, &vao);
+    GLStateCache::deleteVertexArrays(1, &vao);
     app_log("Cube destructor~~~\n");
 }
 
-void Cube::draw() {
-    Shape::draw();
-
-    glUniform1i(transformEnabledLocation, 1); // 开启shader中的transform
+void Cube::submit(RenderQueue &queue) {
     modelColorFactorV4[3] = 1.0f;
-    glUniform4fv(modelColorFactorLocation, 1, modelColorFactorV4);
-    glBindTexture(GL_TEXTURE_2D, TextureUtils::textureIds[0]); // green texture
-    glBindVertexArray(vao);
-    glDrawElements(GL_TRIANGLES, 30, GL_UNSIGNED_SHORT, 0);
+    DrawPacket packet = makeDrawPacket();
+    packet.setTexture(*TextureUtils::simpleTextures[0]); // green texture
+    packet.vao = vao;
+    packet.count = 30;
+    packet.indexType = GL_UNSIGNED_SHORT;
+    queue.submit(packet);
 
     // 包围盒
-    drawWrapBox3D();
+    submitWrapBox3D(queue);
 
     // wrapBox2D
-    drawWrapBox2D();
+    submitWrapBox2D(queue);
 }
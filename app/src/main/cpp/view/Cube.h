@@ -15,7 +15,7 @@ private:
 public:
     Cube();
     virtual ~Cube();
-    virtual void draw();
+    virtual void submit(RenderQueue &queue);
 };
 
 #endif //NATIVEACTIVITYDEMO_CUBE_H
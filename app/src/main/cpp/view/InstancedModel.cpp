@@ -0,0 +1,96 @@
+#include "InstancedModel.h"
+#include "../resource/AssetLoader.h"
+#include "../resource/TextureManager.h"
+
+InstancedModel::InstancedModel(const char *assetObjName, const char *assetPngName,
+                               bool hasTexCoords, bool isSmoothLight): Shape() {
+    std::weak_ptr<bool> alive = aliveToken;
+    AssetLoader::loadMesh(assetObjName, false, hasTexCoords, isSmoothLight,
+                          [this, alive](const std::shared_ptr<ObjMesh> &loadedMesh) {
+        if (alive.expired() || !loadedMesh) {
+            return;
+        }
+        mesh = loadedMesh;
+        initInstanceVao();
+    });
+    AssetLoader::loadTexture(assetPngName, [this, alive](const std::shared_ptr<Texture> &loadedTexture) {
+        if (alive.expired()) {
+            return;
+        }
+        texture = loadedTexture;
+    });
+}
+
+void InstancedModel::initInstanceVao() {
+    glGenVertexArrays(1, &instanceVao);
+    glGenBuffers(1, &instanceVbo);
+    GLStateCache::bindVertexArray(instanceVao);
+    mesh->bindAttributes();
+
+    // mat4属性按列占用4个location，每个实例前进一次
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    for (GLuint i = 0; i < 4; i++) {
+        GLuint location = BaseShader::INSTANCE_MAT4_LOCATION + i;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (const void *)(sizeof(glm::vec4) * i));
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+InstancedModel::~InstancedModel() {
+    GLStateCache::deleteVertexArrays(1, &instanceVao);
+    glDeleteBuffers(1, &instanceVbo);
+    app_log("InstancedModel destructor~~~\n");
+}
+
+size_t InstancedModel::addInstance(const glm::mat4 &instanceMat4) {
+    instanceMat4s.push_back(instanceMat4);
+    instancesDirty = true;
+    return instanceMat4s.size() - 1;
+}
+
+void InstancedModel::setInstanceTransform(size_t index, const glm::mat4 &instanceMat4) {
+    if (index >= instanceMat4s.size()) {
+        return;
+    }
+    instanceMat4s[index] = instanceMat4;
+    instancesDirty = true;
+}
+
+void InstancedModel::clearInstances() {
+    instanceMat4s.clear();
+    instancesDirty = true;
+}
+
+void InstancedModel::uploadInstances() {
+    GLsizeiptr size = sizeof(glm::mat4) * instanceMat4s.size();
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    if (size > instanceVboCapacity) {
+        instanceVboCapacity = size;
+        glBufferData(GL_ARRAY_BUFFER, size, instanceMat4s.data(), GL_DYNAMIC_DRAW);
+    } else {
+        // 先orphan掉旧的存储，避免等待上一帧还在使用它的绘制
+        glBufferData(GL_ARRAY_BUFFER, instanceVboCapacity, nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, instanceMat4s.data());
+    }
+    instancesDirty = false;
+}
+
+void InstancedModel::submit(RenderQueue &queue) {
+    if (!mesh || !texture || instanceMat4s.empty() || !TextureManager::use(texture)) {
+        return;
+    }
+    if (instancesDirty) {
+        uploadInstances();
+    }
+
+    modelColorFactorV4[3] = 1.0f;
+    DrawPacket packet = makeDrawPacket();
+    packet.setTexture(*texture);
+    packet.vao = instanceVao;
+    packet.count = mesh->indexCount;
+    packet.indexType = GL_UNSIGNED_SHORT;
+    packet.instanceCount = (GLsizei)instanceMat4s.size();
+    queue.submit(packet);
+}
@@ -0,0 +1,40 @@
+#ifndef NATIVEACTIVITYDEMO_INSTANCEDMODEL_H
+#define NATIVEACTIVITYDEMO_INSTANCEDMODEL_H
+
+#include <memory>
+#include <vector>
+#include "Shape.h"
+#include "ObjMesh.h"
+#include "../texture/Texture.h"
+
+/**
+ * 同一个mesh和纹理的多个实例，一次glDrawElementsInstanced画完。
+ * 每个实例的model矩阵放在实例属性buffer中（divisor为1），
+ * Shape自身的变换（包括world、view和投影）作用于所有实例之上。
+ */
+class InstancedModel: public Shape {
+private:
+    std::shared_ptr<ObjMesh> mesh;
+    std::shared_ptr<Texture> texture;
+    GLuint instanceVao = 0; // mesh的顶点属性 + 实例矩阵
+    GLuint instanceVbo = 0;
+    GLsizeiptr instanceVboCapacity = 0; // 字节
+    std::vector<glm::mat4> instanceMat4s;
+    bool instancesDirty = false; // cpu侧修改后，下次提交前再上传
+
+    void initInstanceVao();
+    void uploadInstances();
+
+public:
+    InstancedModel(const char *assetObjName, const char *assetPngName, bool hasTexCoords, bool isSmoothLight);
+    virtual ~InstancedModel();
+
+    void submit(RenderQueue &queue);
+
+    size_t addInstance(const glm::mat4 &instanceMat4);
+    void setInstanceTransform(size_t index, const glm::mat4 &instanceMat4);
+    void clearInstances();
+    size_t getInstanceCount() const { return instanceMat4s.size(); }
+};
+
+#endif //NATIVEACTIVITYDEMO_INSTANCEDMODEL_H
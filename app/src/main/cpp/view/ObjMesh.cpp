@@ -0,0 +1,144 @@
+#include "ObjMesh.h"
+#include "../app_log.h"
+#include "../gles/GLStateCache.h"
+#include "../utils/ObjHelper.h"
+#include "../platform/AssetProvider.h"
+#include "../utils/CoordinatesUtils.h"
+#include <cstring>
+#include <cerrno>
+
+// 从free3d.com中下载.blender文件素材，导入blender后再导出为obj，导出设置：
+// 1、z forward，y up；这种方式导出后x坐标是反的，ObjHelper.cpp中进行了处理。在视图和透视矩阵加入后，x坐标就不反了。
+// 2、write normals, include uvs, triangulate faces，其他都不要选
+
+std::shared_ptr<ObjMesh> ObjMesh::load(const char *assetObjName, bool needGenHeightMap,
+                                       bool hasTexCoords, bool isSmoothLight) {
+    std::unique_ptr<ObjMeshData> data = parse(assetObjName, needGenHeightMap, hasTexCoords, isSmoothLight);
+    if (!data) {
+        return nullptr;
+    }
+    return upload(*data);
+}
+
+std::unique_ptr<ObjMeshData> ObjMesh::parse(const char *assetObjName, bool needGenHeightMap,
+                                            bool hasTexCoords, bool isSmoothLight) {
+    // assets目录下，文件后缀是png才能读到，否则会报错: no such file or directory.
+    // 原因是：assets目录下的文件会进行压缩，所以读不到。而png会被认为是压缩文件，不会再次压缩。
+    int fd = Assets::openFd(assetObjName);
+    if (fd <= 0) {
+        app_log("openFdFromAsset \"%s\" failed: err: %s\n", assetObjName, strerror(errno));
+        return nullptr;
+    }
+    FILE *file = fdopen(fd, "r");
+
+    // 从手机sd读取
+//    FILE *file = fopen("/sdcard/sphere.obj", "r");
+//    if (file == NULL) {
+//        app_log("file is NULL, err: %s\n", strerror(errno));
+//        return nullptr;
+//    }
+
+    auto pObjData = new ObjHelper::ObjData();
+    ObjHelper::readObjFile(file, pObjData, needGenHeightMap, hasTexCoords, isSmoothLight);
+    fclose(file);
+
+    std::unique_ptr<ObjMeshData> data(new ObjMeshData());
+    data->vertices = std::move(pObjData->vertices);
+    data->indeces.reserve(pObjData->indeces.size());
+    for (const std::vector<GLushort> &value: pObjData->indeces) {
+        data->indeces.push_back(value.at(0));
+    }
+    data->texCoords = std::move(pObjData->texCoords);
+    data->normals = std::move(pObjData->normals);
+    data->mapLocInfos = std::move(pObjData->mapLocInfos);
+
+    // 包围盒
+    for (int i = 0; i < 3; i++) {
+        data->minVertex[i] = pObjData->minVertex.at(i);
+        data->maxVertex[i] = pObjData->maxVertex.at(i);
+    }
+    app_log("%s, min(x: %f, y: %f, z: %f), max(x: %f, y: %f, z: %f)\n", assetObjName,
+            data->minVertex[0], data->minVertex[1], data->minVertex[2],
+            data->maxVertex[0], data->maxVertex[1], data->maxVertex[2]);
+
+    if (needGenHeightMap) {
+        CoordinatesUtils::insertLinearValue(data->mapLocInfos,
+                                            (int)(data->minVertex[0] * ObjHelper::heightMapSampleFactor),
+                                            (int)(data->minVertex[2] * ObjHelper::heightMapSampleFactor),
+                                            (int)(data->maxVertex[0] * ObjHelper::heightMapSampleFactor),
+                                            (int)(data->maxVertex[2] * ObjHelper::heightMapSampleFactor));
+    }
+
+    delete pObjData;
+    return data;
+}
+
+std::shared_ptr<ObjMesh> ObjMesh::upload(ObjMeshData &data) {
+    std::shared_ptr<ObjMesh> mesh = std::make_shared<ObjMesh>();
+    glGenVertexArrays(1, &mesh->vao);
+    glGenBuffers(4, mesh->buffers);
+    GLStateCache::bindVertexArray(mesh->vao);
+
+    // vertex data
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->buffers[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * data.vertices.size(), data.vertices.data(), GL_STATIC_DRAW);
+
+    // indeces
+    mesh->indexCount = data.indeces.size();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->buffers[1]);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * data.indeces.size(), data.indeces.data(), GL_STATIC_DRAW);
+
+    // texture coordinates data
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->buffers[2]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * data.texCoords.size(), data.texCoords.data(), GL_STATIC_DRAW);
+
+    // normals data
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->buffers[3]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * data.normals.size(), data.normals.data(), GL_STATIC_DRAW);
+
+    mesh->bindAttributes();
+
+    memcpy(mesh->minVertex, data.minVertex, sizeof(mesh->minVertex));
+    memcpy(mesh->maxVertex, data.maxVertex, sizeof(mesh->maxVertex));
+    mesh->mapLocInfos = std::move(data.mapLocInfos);
+    return mesh;
+}
+
+void ObjMesh::bindAttributes() const {
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]); // 索引buffer的绑定也记录在vao中
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[2]);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffers[3]);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(2);
+}
+
+const MapLocInfo *ObjMesh::findMapLocInfo(int fixedX, int fixedZ) const {
+    return findMapLocInfo(mapLocInfos, fixedX, fixedZ);
+}
+
+const MapLocInfo *ObjMesh::findMapLocInfo(
+        const std::unordered_map<int, std::unordered_map<int, std::unique_ptr<MapLocInfo>>> &mapLocInfos,
+        int fixedX, int fixedZ) {
+    auto column = mapLocInfos.find(fixedX);
+    if (column == mapLocInfos.end()) {
+        return nullptr;
+    }
+    auto info = column->second.find(fixedZ);
+    if (info == column->second.end()) {
+        return nullptr;
+    }
+    return info->second.get();
+}
+
+ObjMesh::~ObjMesh() {
+    GLStateCache::deleteVertexArrays(1, &vao);
+    glDeleteBuffers(4, buffers);
+}
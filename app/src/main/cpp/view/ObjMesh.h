@@ -0,0 +1,52 @@
+#ifndef NATIVEACTIVITYDEMO_OBJMESH_H
+#define NATIVEACTIVITYDEMO_OBJMESH_H
+
+#include <GLES3/gl32.h>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include "../entity/MapLocInfo.h"
+
+// 解析完成、还未上传的cpu侧数据，可以在工作线程中生成
+struct ObjMeshData {
+    std::vector<GLfloat> vertices; // 3个为一组
+    std::vector<GLushort> indeces;
+    std::vector<GLfloat> texCoords; // 2个为一组
+    std::vector<GLfloat> normals; // 3个为一组
+    GLfloat minVertex[3] = {0.0f, 0.0f, 0.0f};
+    GLfloat maxVertex[3] = {0.0f, 0.0f, 0.0f};
+    std::unordered_map<int, std::unordered_map<int, std::unique_ptr<MapLocInfo>>> mapLocInfos;
+};
+
+// obj文件解析、上传后的GPU数据，可以被多个模型共享。
+class ObjMesh {
+public:
+    GLuint vao = 0; // vertex array object
+    GLuint buffers[4] = {0}; // [vertices, indeces, texCoords, normals]
+    GLuint indexCount = 0;
+    GLfloat minVertex[3] = {0.0f, 0.0f, 0.0f}; // 包围盒
+    GLfloat maxVertex[3] = {0.0f, 0.0f, 0.0f};
+    std::unordered_map<int, std::unordered_map<int, std::unique_ptr<MapLocInfo>>> mapLocInfos; // 高度图
+
+    ~ObjMesh();
+
+    // 读取失败时返回nullptr，parse + upload
+    static std::shared_ptr<ObjMesh> load(const char *assetObjName, bool needGenHeightMap,
+                                         bool hasTexCoords, bool isSmoothLight);
+    // 文件读取、解析和高度图生成，不调用GL，可以在任意线程执行
+    static std::unique_ptr<ObjMeshData> parse(const char *assetObjName, bool needGenHeightMap,
+                                              bool hasTexCoords, bool isSmoothLight);
+    // 只能在GL线程调用，mapLocInfos会被移走
+    static std::shared_ptr<ObjMesh> upload(ObjMeshData &data);
+
+    // 把顶点属性和索引buffer绑定到当前的vao上，用于需要额外属性（比如实例化）的vao
+    void bindAttributes() const;
+
+    const MapLocInfo *findMapLocInfo(int fixedX, int fixedZ) const;
+    // 也用于还没上传的ObjMeshData
+    static const MapLocInfo *findMapLocInfo(
+            const std::unordered_map<int, std::unordered_map<int, std::unique_ptr<MapLocInfo>>> &mapLocInfos,
+            int fixedX, int fixedZ);
+};
+
+#endif //NATIVEACTIVITYDEMO_OBJMESH_H
@@ -5,26 +5,40 @@
 #ifndef NATIVEACTIVITYDEMO_OBJMODEL_H
 #define NATIVEACTIVITYDEMO_OBJMODEL_H
 
-#include <unordered_map>
+#include <functional>
+#include <memory>
 #include "Shape.h"
-#include "../entity/MapLocInfo.h"
+#include "ObjMesh.h"
+#include "../texture/Texture.h"
 
 class ObjModel: public Shape {
 private:
-    GLuint vao[1] = {0}; // vertex array object
-    GLuint buffers[4] = {0}; // vertex buffer object
-    GLuint textureId = 0;
-    GLuint indexCount = 0;
-    std::unordered_map<int, std::unordered_map<int, std::unique_ptr<MapLocInfo>>> mapLocInfos;
+    std::shared_ptr<ObjMesh> mesh;
+    std::shared_ptr<Texture> texture;
+    // 软件光栅化时使用，见RenderBackend
+    std::shared_ptr<const ObjMeshData> meshData;
+    std::shared_ptr<const SoftTexture> softTexture;
+    std::function<void()> onReady;
+
+    void checkReady();
+    const MapLocInfo *findMapLocInfo(int fixedX, int fixedZ) const;
 
 public:
     ObjModel(const char *assetObjName, const char *assetPngName, bool needGenHeightMap,
-             bool hasTexCoords, bool isSmoothLight);
+             bool hasTexCoords, bool isSmoothLight, TextureOption textureOption = TEXTURE_RGBA8);
     virtual ~ObjModel();
 
-    void draw();
+    void submit(RenderQueue &queue);
+    void submitSoft(SoftRasterizer &rasterizer);
     GLfloat getMapHeight(GLfloat x, GLfloat z);
     void getMapNormal(GLfloat x, GLfloat z, glm::vec3 &outVec3);
+
+    const std::shared_ptr<ObjMesh> &getMesh() const { return mesh; }
+
+    // mesh和纹理都加载完成后才会被绘制。软件光栅化时png读取失败也绘制，和GL里得到id为0的纹理一样
+    bool isReady() const { return (mesh && texture) || meshData; }
+    // 加载完成后在GL线程回调一次，已经完成时立即回调
+    void setOnReady(std::function<void()> callback);
 };
 
 #endif //NATIVEACTIVITYDEMO_OBJMODEL_H
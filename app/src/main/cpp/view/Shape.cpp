@@ -28,13 +28,13 @@ void Shape::moveBy(float offsetX, float offsetY, float offsetZ) {
     updateWrapBoxTransform();
 }
 
-void Shape::moveXTo(float x) {
+void Shape::moveXTo(float /*x*/) {
 
 }
-void Shape::moveYTo(float y) {
+void Shape::moveYTo(float /*y*/) {
 
 }
-void Shape::moveZTo(float z) {
+void Shape::moveZTo(float /*z*/) {
 
 }
 
@@ -49,7 +49,7 @@ void Shape::worldMoveBy(float offsetX, float offsetY, float offsetZ) {
     updateWrapBoxTransform();
 }
 
-void Shape::worldMoveXTo(float x) {
+void Shape::worldMoveXTo(float /*x*/) {
 
 }
 void Shape::worldMoveYTo(float y) {
@@ -57,7 +57,7 @@ void Shape::worldMoveYTo(float y) {
     updateModelMat4();
     updateWrapBoxTransform();
 }
-void Shape::worldMoveZTo(float z) {
+void Shape::worldMoveZTo(float /*z*/) {
 
 }
 
@@ -157,31 +157,45 @@ void Shape::worldScaleZTo(float z) {
     updateWrapBoxTransform();
 }
 
-void Shape::draw() {
-    glUniformMatrix4fv(transformMat4Location, 1, GL_FALSE, glm::value_ptr(modelMat4));
+void Shape::submit(RenderQueue &/*queue*/) {
+
+}
+
+void Shape::submitSoft(SoftRasterizer &/*rasterizer*/) {
+
 }
 
-void Shape::drawWrapBox2D() {
-    modelColorFactorV4[3] = 0.34f;
-    glUniform4fv(modelColorFactorLocation, 1, modelColorFactorV4);
-    glUniform1i(transformEnabledLocation, 0); // 关闭shader中的transform
-    glLineWidth(5.0f);
-    glBindTexture(GL_TEXTURE_2D, TextureUtils::textureIds[1]); // red texture
-    glBindVertexArray(0); // break previous binding
-    // 如果只有一个物体，初始化时设置一次即可。如果是多个物体，每次绘制前要设置用哪个顶点数据。
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, wrapBox2DVertices); // 需要w分量
-    glDrawArrays(GL_LINE_LOOP, 0, wrapBox2DVerticesSize/4);
+DrawPacket Shape::makeDrawPacket() {
+    DrawPacket packet;
+    if (shader == nullptr || shaderGeneration != BaseShader::getGeneration()) {
+        shader = BaseShader::getShader(shaderFeatures); // 失败时BaseShader记住了，不会每帧重新编译
+        shaderGeneration = BaseShader::getGeneration();
+    }
+    packet.program = shader != nullptr ? shader->getProgram() : 0;
+    packet.transformMat4 = glm::value_ptr(modelMat4);
+    packet.depth = getDepth();
+    memcpy(packet.colorFactor, modelColorFactorV4, sizeof(packet.colorFactor));
+    return packet;
+}
+
+SoftDraw Shape::makeSoftDraw() {
+    SoftDraw draw;
+    draw.features = shaderFeatures;
+    draw.transformMat4 = glm::value_ptr(modelMat4);
+    memcpy(draw.colorFactor, modelColorFactorV4, sizeof(draw.colorFactor));
+    return draw;
 }
 
-void Shape::drawWrapBox3D() {
-    modelColorFactorV4[3] = 0.34f;
-    glUniform4fv(modelColorFactorLocation, 1, modelColorFactorV4);
-    glUniform1i(transformEnabledLocation, 1); // 开启shader中的transform
-    glLineWidth(5.0f);
-    glBindTexture(GL_TEXTURE_2D, TextureUtils::textureIds[0]); // green texture
-    glBindVertexArray(vao[0]);
-    glDrawElements(GL_LINE_STRIP, 16, GL_UNSIGNED_SHORT, 0);
-//    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0);
+void Shape::submitWrapBox2D(RenderQueue &queue) {
+    if (!wrapBoxInited) return;
+    static const GLfloat red[4] = {1.0f, 0.0f, 0.0f, 0.34f};
+    queue.getDebugDraw().addLineLoop(wrapBox2DVertices, wrapBox2DVerticesSize/4, red);
+}
+
+void Shape::submitWrapBox3D(RenderQueue &queue) {
+    if (!wrapBoxInited) return;
+    static const GLfloat green[4] = {0.0f, 1.0f, 0.0f, 0.34f};
+    queue.getDebugDraw().addBox(modelMat4, wrapBox3DVertices, green);
 }
 
 void Shape::initWrapBox(GLfloat minX, GLfloat minY, GLfloat minZ,
@@ -189,8 +203,6 @@ void Shape::initWrapBox(GLfloat minX, GLfloat minY, GLfloat minZ,
     // init bounds
     updateBounds(minX, minY, maxX, maxY);
 
-    glBindVertexArray(vao[0]);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo[0]);
     /**
      *        0 -------- 3 (max)
      *         /       /
@@ -209,32 +221,9 @@ void Shape::initWrapBox(GLfloat minX, GLfloat minY, GLfloat minZ,
             maxX, minY, minZ,
             maxX, minY, maxZ
     };
-    memcpy(wrapBox3DVertices, wrapBoxVertices_, sizeof(wrapBoxVertices_));
-    glBufferData(GL_ARRAY_BUFFER, sizeof(wrapBox3DVertices), wrapBox3DVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(0);
-    // indeces
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo[1]);
-    GLushort wrapBoxIndeces[] = { // 16
-            0, 1, 2, 3, 0,
-            4, 5, 6, 7, 4,
-            6, 2, 7, 3, 1,
-            5
-    };
-    GLushort cubeIndices[] = { // 36
-            0, 1, 2, 0, 2, 3, // 上， 逆时针
-            1, 5, 6, 1, 6, 2, // 前， 逆时针
-            2, 6, 7, 2, 7, 3, // 右， 逆时针
-            3, 7, 4, 3, 4, 0, // 里， 逆时针
-            0, 4, 5, 0, 5, 1, // 左， 逆时针
-            5, 4, 7, 5, 7, 6  // 下， 逆时针
-    };
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(wrapBoxIndeces), wrapBoxIndeces, GL_STATIC_DRAW);
-//    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices, GL_STATIC_DRAW);
+    memcpy(wrapBox3DVertices, wrapBoxVertices_, sizeof(wrapBoxVertices_)); // 提交时由DebugDraw变换
 
-    // 2D包围框，不使用vao、vbo，直接用本地数据渲染
-    glBindVertexArray(0); // break previous binding
-    glBindBuffer(GL_ARRAY_BUFFER, 0); // unbind previous binding
+    // 2D包围框，顶点在cpu侧计算，变换后更新
     GLfloat wrapBox2DVertices_[] = { // 需要w分量
             minX, minY, 0.0f, 1.0f, // 左下
             maxX, minY, 0.0f, 1.0f, // 右下
@@ -242,9 +231,8 @@ void Shape::initWrapBox(GLfloat minX, GLfloat minY, GLfloat minZ,
             minX, maxY, 0.0f, 1.0f  // 左上
     };
     memcpy(wrapBox2DVertices, wrapBox2DVertices_, sizeof(wrapBox2DVertices_));
-    // 如果只有一个物体，初始化时设置一次即可。如果是多个物体，每次绘制前要设置用哪个顶点数据。
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, wrapBox2DVertices);// 需要w分量
-    glEnableVertexAttribArray(0); // 如果其他地方有关闭操作，则要在每次绘制前开启。
+
+    wrapBoxInited = true;
 }
 
 // 仅wrapBox2D在使用
@@ -299,6 +287,19 @@ void Shape::updateWrapBoxTransform() {
     updateBounds(minX, minY, maxX, maxY);
 }
 
+// 包围盒中心经过变换后的w分量，即到相机的距离，除以远裁剪面后归一化。没有包围盒时用模型原点。
+GLfloat Shape::getDepth() {
+    glm::vec4 center(0.0f, 0.0f, 0.0f, 1.0f);
+    if (wrapBoxInited) {
+        // wrapBox3DVertices中下标3是max点，下标5是min点
+        center[0] = (wrapBox3DVertices[9] + wrapBox3DVertices[15]) / 2.0f;
+        center[1] = (wrapBox3DVertices[10] + wrapBox3DVertices[16]) / 2.0f;
+        center[2] = (wrapBox3DVertices[11] + wrapBox3DVertices[17]) / 2.0f;
+    }
+    center = modelMat4 * center;
+    return center[3] / zFar;
+}
+
 /**
  * GLM是基于（GLSL）规范的图形软件的仅头文件C++数学库。该库可与OpenGL完美配合。
  * 1、glm::mat4在内存中存储是列优先的。
@@ -334,7 +335,7 @@ void Shape::updateModelMat4() {
     viewMat4 = glm::translate(viewMat4, glm::vec3(-worldTranslateXYZ[0], -worldTranslateXYZ[1], -worldTranslateXYZ[2]));
 
     // 透视投影变换
-    glm::mat4 projectMat4 = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+    glm::mat4 projectMat4 = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, zFar);
 
     modelMat4 = projectMat4 * viewMat4 * modelMat4; // 最先发生的变换矩阵，往后放
 }
@@ -371,10 +372,10 @@ void Shape::getRotate(GLfloat *rotateXYZarr) {
     }
 }
 
-GLfloat Shape::getMapHeight(GLfloat x, GLfloat z) {
+GLfloat Shape::getMapHeight(GLfloat /*x*/, GLfloat /*z*/) {
     return 0.0f;
 }
 
-void Shape::getMapNormal(GLfloat x, GLfloat z, glm::vec3 &outVec3) {
+void Shape::getMapNormal(GLfloat /*x*/, GLfloat /*z*/, glm::vec3 &/*outVec3*/) {
 
 }
@@ -6,36 +6,29 @@
 #define NATIVEACTIVITYDEMO_SHAPE_H
 
 #include <GLES3/gl32.h>
+#include <memory>
 #include "../app_log.h"
 #include "../shader/BaseShader.h"
 #include "../texture/TextureUtils.h"
+#include "../render/RenderQueue.h"
+#include "../render/SoftRasterizer.h"
+#include "../gles/GLStateCache.h"
 #include "../utils/libglm0_9_6_3/glm/glm.hpp"
 
 class Shape {
 public:
     Shape() {
-        transformEnabledLocation = glGetUniformLocation(BaseShader::getSingletonProgram(), "transformEnabled");
-        textureUnitLocation = glGetUniformLocation(BaseShader::getSingletonProgram(), "textureUnit");
-        modelColorFactorLocation = glGetUniformLocation(BaseShader::getSingletonProgram(), "modelColorFactor");
-        lightPositionLocation = glGetUniformLocation(BaseShader::getSingletonProgram(), "lightPosition");
-        lightColorLocation = glGetUniformLocation(BaseShader::getSingletonProgram(), "lightColor");
-        transformMat4Location = glGetUniformLocation(BaseShader::getSingletonProgram(), "transformMat4");
-        glUseProgram(BaseShader::getSingletonProgram());
-        glUniform1i(textureUnitLocation, 0);
-
-        glGenVertexArrays(1, vao);
-        glGenBuffers(2, vbo);
-
         app_log("Shape constructor");
     }
 
     virtual ~Shape() {
         app_log("Shape destructor");
-        glDeleteVertexArrays(1, vao);
-        glDeleteBuffers(2, vbo);
     }
 
-    virtual void draw();
+    // 生成本帧的DrawPacket，由RenderQueue统一排序后绘制
+    virtual void submit(RenderQueue &queue);
+    // 软件光栅化时代替submit，见RenderBackend。默认不绘制
+    virtual void submitSoft(SoftRasterizer &rasterizer);
 
     virtual void moveBy(float offsetX, float offsetY, float offsetZ);
 
@@ -75,8 +68,9 @@ public:
 
     void initWrapBox(GLfloat minX, GLfloat minY, GLfloat minZ, GLfloat maxX, GLfloat maxY, GLfloat maxZ);
 
-    void drawWrapBox2D();
-    void drawWrapBox3D();
+    // 包围盒交给queue的DebugDraw合并绘制，DebugDraw关闭时什么都不做
+    void submitWrapBox2D(RenderQueue &queue);
+    void submitWrapBox3D(RenderQueue &queue);
 
     void getScale(GLfloat *scaleXYZarr);
     void getTranslate(GLfloat *translateXYZarr);
@@ -86,24 +80,37 @@ public:
     virtual void getMapNormal(GLfloat x, GLfloat z, glm::vec3 &outVec3);
 
 protected: // 子类可以按需进行修改
-    GLint transformEnabledLocation;
-
-    GLint modelColorFactorLocation;
     GLfloat modelColorFactorV4[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    // 见ShaderFeature。第一次makeDrawPacket时才向BaseShader取对应的program，构造时不需要GL context
+    uint32_t shaderFeatures = BaseShader::DEFAULT_FEATURES;
+
+    void setShaderFeatures(uint32_t features) {
+        shaderFeatures = features;
+        shader = nullptr;
+    }
 
-    GLint lightPositionLocation;
-    GLfloat lightPositionV3[3] = {0.0f, 3.0f, -10.0f};
+    DrawPacket makeDrawPacket(); // 填充program、变换矩阵和深度等公共字段
+    SoftDraw makeSoftDraw(); // 填充特性、变换矩阵和颜色因子
 
-    GLint lightColorLocation;
-    GLfloat lightColorV3[3] = {1.0f, 1.0f, 1.0f};
+    // 异步加载的回调持有它的weak_ptr，Shape析构后回调不再访问this
+    std::shared_ptr<bool> aliveToken = std::make_shared<bool>(true);
+
+    // 变换改变后重新计算，public的变换方法都会调用这两个
+    void updateModelMat4();
+    void updateWrapBoxTransform();
 
 private:
+    // shaderFeatures对应的program和反射信息，由BaseShader持有，所有同样特性的Shape共用一份。
+    // 只查一次，BaseShader::deletePrograms之后（generation变了）重新查
+    const ShaderReflection *shader = nullptr;
+    uint32_t shaderGeneration = 0;
+
     int bounds[4]; // [l, t, r, b]，屏幕尺寸值，不是GL ES的归一化值。
 
-    GLuint vao[1];
-    GLuint vbo[2];
-    const static GLint wrapBox3DVerticesSize = 24; // shader里计算，3分量即可
-    const static GLint wrapBox2DVerticesSize = 16; // 在cpu侧计算，需要w分量
+    bool wrapBoxInited = false;
+    constexpr static GLfloat zFar = 100.0f; // 透视投影的远裁剪面
+    const static GLint wrapBox3DVerticesSize = 24; // 模型坐标，3分量即可
+    const static GLint wrapBox2DVerticesSize = 16; // 裁剪坐标，需要w分量
     GLfloat wrapBox3DVertices[wrapBox3DVerticesSize] = {0};
     GLfloat wrapBox2DVertices[wrapBox2DVerticesSize] = {0};
 
@@ -115,13 +122,9 @@ private:
     GLfloat worldRotateXYZ[3] = {0}; // world
 
     glm::mat4 modelMat4 = glm::mat4(1);
-    GLint transformMat4Location;
-
-    GLint textureUnitLocation;
 
-    void updateWrapBoxTransform();
     void updateBounds(GLfloat minX, GLfloat minY, GLfloat maxX, GLfloat maxY);
-    void updateModelMat4();
+    GLfloat getDepth();
 };
 
 #endif //NATIVEACTIVITYDEMO_SHAPE_H
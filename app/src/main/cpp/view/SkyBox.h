@@ -5,18 +5,22 @@
 #ifndef NATIVEACTIVITYDEMO_SKYBOX_H
 #define NATIVEACTIVITYDEMO_SKYBOX_H
 
+#include <memory>
 #include "Shape.h"
+#include "../texture/Texture.h"
 
 class SkyBox: public Shape {
 private:
     GLuint vao = 0; // vertex array object
     GLuint buffers[3] = {0};
-    GLuint textureId = 0;
+    std::shared_ptr<Texture> texture;
+    std::shared_ptr<const SoftTexture> softTexture; // 软件光栅化时使用
 
 public:
     SkyBox();
     virtual ~SkyBox();
-    virtual void draw();
+    virtual void submit(RenderQueue &queue);
+    virtual void submitSoft(SoftRasterizer &rasterizer);
 };
 
 
@@ -15,7 +15,7 @@ Triangles::Triangles(): Shape() {
     // vao会记录所有的状态数据，包括attrib的开启与否。
     // 绑定成功后，之前的vao绑定会解除，后续的所有数据操作都会记录到这个vao上。
     // 后续在切换数据时，只要切换绑定vao就行。
-    glBindVertexArray(vao);
+    GLStateCache::bindVertexArray(vao);
 
     glBindBuffer(GL_ARRAY_BUFFER, buffers[0]); // 绑定成功后，会自动解除之前的绑定。
     GLfloat triangles[] = {
@@ -45,24 +45,22 @@ Triangles::Triangles(): Shape() {
 
 Triangles::~Triangles() {
     glDeleteBuffers(2, buffers);
-    glDeleteVertexArrays(1, &vao);
+    GLStateCache::deleteVertexArrays(1, &vao);
     app_log("Triangles destructor~~~\n");
 }
 
-void Triangles::draw() {
-    Shape::draw();
-
-    glUniform1i(transformEnabledLocation, 1); // 开启shader中的transform
+void Triangles::submit(RenderQueue &queue) {
     modelColorFactorV4[3] = 1.0f;
-    glUniform4fv(modelColorFactorLocation, 1, modelColorFactorV4);
-    glBindTexture(GL_TEXTURE_2D, TextureUtils::textureIds[0]); // green texture
-    glBindVertexArray(vao);
-    glUniform4fv(modelColorFactorLocation, 1, modelColorFactorV4);
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+    DrawPacket packet = makeDrawPacket();
+    packet.setTexture(*TextureUtils::simpleTextures[0]); // green texture
+    packet.vao = vao;
+    packet.mode = GL_TRIANGLE_FAN;
+    packet.count = 4;
+    queue.submit(packet);
 
     // 包围盒
-    drawWrapBox3D();
+    submitWrapBox3D(queue);
 
     // wrapBox2D
-    drawWrapBox2D();
+    submitWrapBox2D(queue);
 }
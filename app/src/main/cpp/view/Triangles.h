@@ -15,7 +15,7 @@ private:
 public:
     Triangles();
     virtual ~Triangles();
-    virtual void draw();
+    virtual void submit(RenderQueue &queue);
 };
 
 #endif //NATIVEACTIVITYDEMO_TRIANGLES_H
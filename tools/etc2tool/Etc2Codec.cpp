@@ -0,0 +1,385 @@
+#include "Etc2Codec.h"
+#include <climits>
+#include <cstring>
+
+namespace {
+
+// ETC1/ETC2的亮度修正表，index的msb/lsb为00、01、10、11时分别取 +a、+b、-a、-b
+const int COLOR_MODIFIERS[8][2] = {
+        {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}
+};
+
+const int ALPHA_MODIFIERS[16][8] = {
+        {-3, -6, -9, -15, 2, 5, 8, 14},
+        {-3, -7, -10, -13, 2, 6, 9, 12},
+        {-2, -5, -8, -13, 1, 4, 7, 12},
+        {-2, -4, -6, -13, 1, 3, 5, 12},
+        {-3, -6, -8, -12, 2, 5, 7, 11},
+        {-3, -7, -9, -11, 2, 6, 8, 10},
+        {-4, -7, -8, -11, 3, 6, 7, 10},
+        {-3, -5, -8, -11, 2, 4, 7, 10},
+        {-2, -6, -8, -10, 1, 5, 7, 9},
+        {-2, -5, -8, -10, 1, 4, 7, 9},
+        {-2, -4, -8, -10, 1, 3, 7, 9},
+        {-2, -5, -7, -10, 1, 4, 6, 9},
+        {-3, -4, -7, -10, 2, 3, 6, 9},
+        {-1, -2, -3, -10, 0, 1, 2, 9},
+        {-4, -6, -8, -9, 3, 5, 7, 8},
+        {-3, -5, -7, -9, 2, 4, 6, 8}
+};
+
+inline int clamp255(int v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+inline int clampRange(int v, int lo, int hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+inline int modifierValue(int table, int index) {
+    int m = COLOR_MODIFIERS[table][index & 1];
+    return (index & 2) ? -m : m;
+}
+
+// 子块里8个像素的坐标。flip为0时是左右两个2x4，为1时是上下两个4x2
+void subblockPositions(int flip, int sub, int *xs, int *ys) {
+    int n = 0;
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int inSub = flip ? (y >= 2) : (x >= 2);
+            if (inSub == sub) {
+                xs[n] = x;
+                ys[n] = y;
+                n++;
+            }
+        }
+    }
+}
+
+struct SubblockFit {
+    int error = INT_MAX;
+    int base[3] = {0}; // 量化后的值，4位或5位
+    int table = 0;
+    int indices[8] = {0};
+};
+
+inline int expand4(int c) {
+    return (c << 4) | c;
+}
+
+inline int expand5(int c) {
+    return (c << 3) | (c >> 2);
+}
+
+// 给定量化后的基色，选出误差最小的修正表和每个像素的index
+void fitSubblock(const uint8_t *pixels, const int *xs, const int *ys, const int *base, bool fiveBit,
+                 SubblockFit &fit) {
+    int r = fiveBit ? expand5(base[0]) : expand4(base[0]);
+    int g = fiveBit ? expand5(base[1]) : expand4(base[1]);
+    int b = fiveBit ? expand5(base[2]) : expand4(base[2]);
+    for (int table = 0; table < 8; table++) {
+        int error = 0;
+        int indices[8];
+        for (int i = 0; i < 8 && error < fit.error; i++) {
+            const uint8_t *p = pixels + (ys[i] * 4 + xs[i]) * 4;
+            int best = INT_MAX;
+            for (int index = 0; index < 4; index++) {
+                int m = modifierValue(table, index);
+                int dr = clamp255(r + m) - p[0];
+                int dg = clamp255(g + m) - p[1];
+                int db = clamp255(b + m) - p[2];
+                int e = dr * dr + dg * dg + db * db;
+                if (e < best) {
+                    best = e;
+                    indices[i] = index;
+                }
+            }
+            error += best;
+        }
+        if (error < fit.error) {
+            fit.error = error;
+            memcpy(fit.base, base, sizeof(fit.base));
+            fit.table = table;
+            memcpy(fit.indices, indices, sizeof(indices));
+        }
+    }
+}
+
+void subblockMean(const uint8_t *pixels, const int *xs, const int *ys, float *mean) {
+    mean[0] = mean[1] = mean[2] = 0.0f;
+    for (int i = 0; i < 8; i++) {
+        const uint8_t *p = pixels + (ys[i] * 4 + xs[i]) * 4;
+        for (int c = 0; c < 3; c++) {
+            mean[c] += p[c] / 8.0f;
+        }
+    }
+}
+
+// 基色在平均值量化结果的基础上沿灰度方向偏移几档再试，修正表只沿灰度方向调整亮度
+const int BASE_SHIFTS = 3;
+const int BASE_SHIFT[BASE_SHIFTS] = {0, -1, 1};
+
+void quantizedCandidate(const float *mean, int maxValue, int shift, int *base) {
+    for (int c = 0; c < 3; c++) {
+        base[c] = clampRange((int)(mean[c] * maxValue / 255.0f + 0.5f) + shift, 0, maxValue);
+    }
+}
+
+struct BlockFit {
+    int error = INT_MAX;
+    int flip = 0;
+    bool diff = false;
+    SubblockFit subs[2];
+};
+
+void tryIndividual(const uint8_t *pixels, int flip, int xs[2][8], int ys[2][8], BlockFit &best) {
+    SubblockFit subs[2];
+    for (int sub = 0; sub < 2; sub++) {
+        float mean[3];
+        subblockMean(pixels, xs[sub], ys[sub], mean);
+        for (int shift: BASE_SHIFT) {
+            int base[3];
+            quantizedCandidate(mean, 15, shift, base);
+            fitSubblock(pixels, xs[sub], ys[sub], base, false, subs[sub]);
+        }
+    }
+    if (subs[0].error + subs[1].error < best.error) {
+        best.error = subs[0].error + subs[1].error;
+        best.flip = flip;
+        best.diff = false;
+        best.subs[0] = subs[0];
+        best.subs[1] = subs[1];
+    }
+}
+
+bool deltaInRange(const int *base0, const int *base1) {
+    for (int c = 0; c < 3; c++) {
+        int d = base1[c] - base0[c];
+        if (d < -4 || d > 3) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void tryDifferential(const uint8_t *pixels, int flip, int xs[2][8], int ys[2][8], BlockFit &best) {
+    SubblockFit candidates[2][BASE_SHIFTS];
+    for (int sub = 0; sub < 2; sub++) {
+        float mean[3];
+        subblockMean(pixels, xs[sub], ys[sub], mean);
+        for (int i = 0; i < BASE_SHIFTS; i++) {
+            int base[3];
+            quantizedCandidate(mean, 31, BASE_SHIFT[i], base);
+            fitSubblock(pixels, xs[sub], ys[sub], base, true, candidates[sub][i]);
+        }
+    }
+    // 第二个基色用相对第一个的3位差值存储，范围[-4, 3]，超出时会被解码成T/H/planar模式
+    int bestPair = INT_MAX;
+    SubblockFit subs[2];
+    for (int i = 0; i < BASE_SHIFTS; i++) {
+        for (int j = 0; j < BASE_SHIFTS; j++) {
+            if (!deltaInRange(candidates[0][i].base, candidates[1][j].base)) {
+                continue;
+            }
+            int error = candidates[0][i].error + candidates[1][j].error;
+            if (error < bestPair) {
+                bestPair = error;
+                subs[0] = candidates[0][i];
+                subs[1] = candidates[1][j];
+            }
+        }
+    }
+    if (bestPair == INT_MAX) {
+        // 两个子块颜色差得太多，把第二个基色拉到范围内，通常individual模式会更好
+        subs[0] = candidates[0][0];
+        int base[3];
+        for (int c = 0; c < 3; c++) {
+            base[c] = clampRange(candidates[1][0].base[c], subs[0].base[c] - 4, subs[0].base[c] + 3);
+        }
+        subs[1] = SubblockFit();
+        fitSubblock(pixels, xs[1], ys[1], base, true, subs[1]);
+        bestPair = subs[0].error + subs[1].error;
+    }
+    if (bestPair < best.error) {
+        best.error = bestPair;
+        best.flip = flip;
+        best.diff = true;
+        best.subs[0] = subs[0];
+        best.subs[1] = subs[1];
+    }
+}
+
+void writeBigEndian(uint64_t v, uint8_t *out) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(v >> (56 - i * 8));
+    }
+}
+
+uint64_t readBigEndian(const uint8_t *in) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) {
+        v = (v << 8) | in[i];
+    }
+    return v;
+}
+
+} // namespace
+
+void Etc2Codec::encodeRGB(const uint8_t *pixels, uint8_t *block) {
+    BlockFit best;
+    int xs[2][8], ys[2][8];
+    for (int flip = 0; flip < 2; flip++) {
+        subblockPositions(flip, 0, xs[0], ys[0]);
+        subblockPositions(flip, 1, xs[1], ys[1]);
+        tryDifferential(pixels, flip, xs, ys, best);
+        tryIndividual(pixels, flip, xs, ys, best);
+    }
+
+    uint64_t v = 0;
+    const int *b0 = best.subs[0].base;
+    const int *b1 = best.subs[1].base;
+    if (best.diff) {
+        for (int c = 0; c < 3; c++) {
+            uint64_t delta = (uint64_t)((b1[c] - b0[c]) & 7);
+            v |= ((uint64_t)b0[c] << (59 - c * 8)) | (delta << (56 - c * 8));
+        }
+    } else {
+        for (int c = 0; c < 3; c++) {
+            v |= ((uint64_t)b0[c] << (60 - c * 8)) | ((uint64_t)b1[c] << (56 - c * 8));
+        }
+    }
+    v |= (uint64_t)best.subs[0].table << 37;
+    v |= (uint64_t)best.subs[1].table << 34;
+    v |= (uint64_t)(best.diff ? 1 : 0) << 33;
+    v |= (uint64_t)best.flip << 32;
+
+    int xs0[8], ys0[8];
+    for (int sub = 0; sub < 2; sub++) {
+        subblockPositions(best.flip, sub, xs0, ys0);
+        for (int i = 0; i < 8; i++) {
+            int bit = xs0[i] * 4 + ys0[i]; // 像素index按列排列
+            int index = best.subs[sub].indices[i];
+            v |= (uint64_t)(index >> 1) << (16 + bit);
+            v |= (uint64_t)(index & 1) << bit;
+        }
+    }
+    writeBigEndian(v, block);
+}
+
+void Etc2Codec::encodeAlpha(const uint8_t *pixels, uint8_t *block) {
+    int minA = 255, maxA = 0;
+    for (int i = 0; i < 16; i++) {
+        int a = pixels[i * 4 + 3];
+        minA = a < minA ? a : minA;
+        maxA = a > maxA ? a : maxA;
+    }
+
+    int bestError = INT_MAX, bestBase = minA, bestMultiplier = 1, bestTable = 13;
+    int bestIndices[16] = {0};
+    if (minA == maxA) {
+        // 第13个表的index 4是0，常量alpha可以无损表示
+        for (int &index: bestIndices) {
+            index = 4;
+        }
+        bestError = 0;
+    }
+    for (int table = 0; table < 16 && bestError > 0; table++) {
+        int tableMin = ALPHA_MODIFIERS[table][3], tableMax = ALPHA_MODIFIERS[table][7];
+        for (int multiplier = 1; multiplier < 16; multiplier++) {
+            // 让表的范围覆盖[minA, maxA]的中心
+            int center = ((minA + maxA) - (tableMin + tableMax) * multiplier) / 2;
+            for (int base = center - 1; base <= center + 1; base++) {
+                if (base < 0 || base > 255) {
+                    continue;
+                }
+                int error = 0;
+                int indices[16];
+                for (int i = 0; i < 16 && error < bestError; i++) {
+                    int a = pixels[i * 4 + 3];
+                    int best = INT_MAX;
+                    for (int index = 0; index < 8; index++) {
+                        int d = clamp255(base + ALPHA_MODIFIERS[table][index] * multiplier) - a;
+                        if (d * d < best) {
+                            best = d * d;
+                            indices[i] = index;
+                        }
+                    }
+                    error += best;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    bestBase = base;
+                    bestMultiplier = multiplier;
+                    bestTable = table;
+                    memcpy(bestIndices, indices, sizeof(indices));
+                }
+            }
+        }
+    }
+
+    uint64_t v = ((uint64_t)bestBase << 56) | ((uint64_t)bestMultiplier << 52) | ((uint64_t)bestTable << 48);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int order = x * 4 + y; // 第一个像素在最高的3位
+            v |= (uint64_t)bestIndices[y * 4 + x] << (45 - order * 3);
+        }
+    }
+    writeBigEndian(v, block);
+}
+
+void Etc2Codec::encodeRGBA(const uint8_t *pixels, uint8_t *block) {
+    encodeAlpha(pixels, block);
+    encodeRGB(pixels, block + 8);
+}
+
+void Etc2Codec::decodeRGB(const uint8_t *block, uint8_t *pixels) {
+    uint64_t v = readBigEndian(block);
+    bool diff = (v >> 33) & 1;
+    int flip = (int)((v >> 32) & 1);
+    int tables[2] = {(int)((v >> 37) & 7), (int)((v >> 34) & 7)};
+    int bases[2][3];
+    for (int c = 0; c < 3; c++) {
+        if (diff) {
+            int b0 = (int)((v >> (59 - c * 8)) & 31);
+            int delta = (int)((v >> (56 - c * 8)) & 7);
+            delta = delta >= 4 ? delta - 8 : delta;
+            bases[0][c] = expand5(b0);
+            bases[1][c] = expand5(b0 + delta); // 编码时保证不溢出
+        } else {
+            bases[0][c] = expand4((int)((v >> (60 - c * 8)) & 15));
+            bases[1][c] = expand4((int)((v >> (56 - c * 8)) & 15));
+        }
+    }
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int sub = flip ? (y >= 2) : (x >= 2);
+            int bit = x * 4 + y;
+            int index = (int)((((v >> (16 + bit)) & 1) << 1) | ((v >> bit) & 1));
+            int m = modifierValue(tables[sub], index);
+            uint8_t *p = pixels + (y * 4 + x) * 4;
+            for (int c = 0; c < 3; c++) {
+                p[c] = (uint8_t)clamp255(bases[sub][c] + m);
+            }
+            p[3] = 255;
+        }
+    }
+}
+
+void Etc2Codec::decodeAlpha(const uint8_t *block, uint8_t *pixels) {
+    uint64_t v = readBigEndian(block);
+    int base = (int)(v >> 56);
+    int multiplier = (int)((v >> 52) & 15);
+    int table = (int)((v >> 48) & 15);
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            int order = x * 4 + y;
+            int index = (int)((v >> (45 - order * 3)) & 7);
+            pixels[(y * 4 + x) * 4 + 3] = (uint8_t)clamp255(base + ALPHA_MODIFIERS[table][index] * multiplier);
+        }
+    }
+}
+
+void Etc2Codec::decodeRGBA(const uint8_t *block, uint8_t *pixels) {
+    decodeRGB(block + 8, pixels);
+    decodeAlpha(block, pixels);
+}
@@ -0,0 +1,29 @@
+#ifndef NATIVEACTIVITYDEMO_ETC2CODEC_H
+#define NATIVEACTIVITYDEMO_ETC2CODEC_H
+
+#include <cstdint>
+
+/**
+ * ETC2 4x4块的编码和解码。
+ * 颜色只使用ETC2里和ETC1兼容的individual/differential模式（差值不溢出，不会进入T/H/planar模式），
+ * 输出是合法的GL_COMPRESSED_RGB8_ETC2块；alpha使用EAC，和颜色块一起组成GL_COMPRESSED_RGBA8_ETC2_EAC块。
+ * 块内像素按行存储：pixels[(y * 4 + x) * 4 + c]，c为RGBA。块按大端字节序写出，和KTX文件里一致。
+ */
+class Etc2Codec {
+public:
+    static const int RGB_BLOCK_BYTES = 8;
+    static const int RGBA_BLOCK_BYTES = 16;
+
+    static void encodeRGB(const uint8_t *pixels, uint8_t *block);
+    static void encodeRGBA(const uint8_t *pixels, uint8_t *block);
+
+    // 解码出RGBA，RGB块的alpha为255。用来计算PSNR
+    static void decodeRGB(const uint8_t *block, uint8_t *pixels);
+    static void decodeRGBA(const uint8_t *block, uint8_t *pixels);
+
+private:
+    static void encodeAlpha(const uint8_t *pixels, uint8_t *block);
+    static void decodeAlpha(const uint8_t *block, uint8_t *pixels);
+};
+
+#endif //NATIVEACTIVITYDEMO_ETC2CODEC_H
@@ -0,0 +1,211 @@
+// 离线把png编码成ETC2，存为KTX 1.1文件，连同用MipmapGenerator生成的mipmap链。
+// 用法：etc2tool [-j 线程数] [--no-mips] input.png output.ktx
+// 每个纹理输出level0的PSNR和显存占用的变化。
+//
+
+#include "Etc2Codec.h"
+#include "../../app/src/main/cpp/texture/MipmapGenerator.h"
+#include "../../app/src/main/cpp/utils/libpng1_6_29/png.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static const uint32_t GL_COMPRESSED_RGB8_ETC2 = 0x9274;
+static const uint32_t GL_COMPRESSED_RGBA8_ETC2_EAC = 0x9278;
+static const uint32_t GL_RGB = 0x1907;
+static const uint32_t GL_RGBA = 0x1908;
+
+// 解码为RGBA，行和app里的decodePNG一样上下翻转，KTX里的数据可以直接上传
+static uint8_t *loadPng(const char *file, uint32_t *w, uint32_t *h) {
+    png_image image;
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    if (!png_image_begin_read_from_file(&image, file)) {
+        fprintf(stderr, "%s: %s\n", file, image.message);
+        return nullptr;
+    }
+    image.format = PNG_FORMAT_RGBA;
+    uint8_t *pixels = (uint8_t *)malloc(PNG_IMAGE_SIZE(image));
+    // 负的row stride表示从最后一行开始存放
+    if (!png_image_finish_read(&image, nullptr, pixels, -(png_int_32)PNG_IMAGE_ROW_STRIDE(image), nullptr)) {
+        fprintf(stderr, "%s: %s\n", file, image.message);
+        free(pixels);
+        return nullptr;
+    }
+    *w = image.width;
+    *h = image.height;
+    return pixels;
+}
+
+// 取出一个4x4块，超出图片的部分重复边缘像素
+static void fetchBlock(const uint8_t *image, uint32_t w, uint32_t h, uint32_t bx, uint32_t by, uint8_t *block) {
+    for (uint32_t y = 0; y < 4; y++) {
+        uint32_t sy = by * 4 + y < h ? by * 4 + y : h - 1;
+        for (uint32_t x = 0; x < 4; x++) {
+            uint32_t sx = bx * 4 + x < w ? bx * 4 + x : w - 1;
+            memcpy(block + (y * 4 + x) * 4, image + ((size_t)sy * w + sx) * 4, 4);
+        }
+    }
+}
+
+// 块按行分给各个线程
+static void encodeLevel(const uint8_t *image, uint32_t w, uint32_t h, bool hasAlpha, int threadCount,
+                        std::vector<uint8_t> &out) {
+    uint32_t blocksX = (w + 3) / 4, blocksY = (h + 3) / 4;
+    size_t blockBytes = hasAlpha ? Etc2Codec::RGBA_BLOCK_BYTES : Etc2Codec::RGB_BLOCK_BYTES;
+    out.resize((size_t)blocksX * blocksY * blockBytes);
+    std::atomic<uint32_t> nextRow(0);
+    auto worker = [&]() {
+        uint8_t pixels[64];
+        for (uint32_t by = nextRow++; by < blocksY; by = nextRow++) {
+            for (uint32_t bx = 0; bx < blocksX; bx++) {
+                fetchBlock(image, w, h, bx, by, pixels);
+                uint8_t *block = &out[((size_t)by * blocksX + bx) * blockBytes];
+                if (hasAlpha) {
+                    Etc2Codec::encodeRGBA(pixels, block);
+                } else {
+                    Etc2Codec::encodeRGB(pixels, block);
+                }
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+}
+
+static double psnr(const uint8_t *image, uint32_t w, uint32_t h, bool hasAlpha, const std::vector<uint8_t> &blocks) {
+    uint32_t blocksX = (w + 3) / 4;
+    size_t blockBytes = hasAlpha ? Etc2Codec::RGBA_BLOCK_BYTES : Etc2Codec::RGB_BLOCK_BYTES;
+    int channels = hasAlpha ? 4 : 3;
+    double squaredError = 0;
+    uint8_t pixels[64];
+    for (uint32_t by = 0; by < (h + 3) / 4; by++) {
+        for (uint32_t bx = 0; bx < blocksX; bx++) {
+            const uint8_t *block = &blocks[((size_t)by * blocksX + bx) * blockBytes];
+            if (hasAlpha) {
+                Etc2Codec::decodeRGBA(block, pixels);
+            } else {
+                Etc2Codec::decodeRGB(block, pixels);
+            }
+            for (uint32_t y = 0; y < 4 && by * 4 + y < h; y++) {
+                for (uint32_t x = 0; x < 4 && bx * 4 + x < w; x++) {
+                    const uint8_t *src = image + ((size_t)(by * 4 + y) * w + bx * 4 + x) * 4;
+                    for (int c = 0; c < channels; c++) {
+                        int d = (int)pixels[(y * 4 + x) * 4 + c] - src[c];
+                        squaredError += d * d;
+                    }
+                }
+            }
+        }
+    }
+    double mse = squaredError / ((double)w * h * channels);
+    return mse == 0 ? INFINITY : 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+static void writeUint32(FILE *file, uint32_t v) {
+    fwrite(&v, sizeof(v), 1, file); // KTX用endianness字段标记字节序，按本机字节序写即可
+}
+
+static bool writeKtx(const char *file, uint32_t w, uint32_t h, bool hasAlpha,
+                     const std::vector<std::vector<uint8_t>> &levels) {
+    FILE *out = fopen(file, "wb");
+    if (out == nullptr) {
+        perror(file);
+        return false;
+    }
+    static const uint8_t identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+    fwrite(identifier, 1, sizeof(identifier), out);
+    writeUint32(out, 0x04030201); // endianness
+    writeUint32(out, 0); // glType，压缩格式为0
+    writeUint32(out, 1); // glTypeSize
+    writeUint32(out, 0); // glFormat
+    writeUint32(out, hasAlpha ? GL_COMPRESSED_RGBA8_ETC2_EAC : GL_COMPRESSED_RGB8_ETC2);
+    writeUint32(out, hasAlpha ? GL_RGBA : GL_RGB);
+    writeUint32(out, w);
+    writeUint32(out, h);
+    writeUint32(out, 0); // pixelDepth
+    writeUint32(out, 0); // numberOfArrayElements
+    writeUint32(out, 1); // numberOfFaces
+    writeUint32(out, (uint32_t)levels.size());
+    writeUint32(out, 0); // bytesOfKeyValueData
+    for (const std::vector<uint8_t> &level: levels) {
+        writeUint32(out, (uint32_t)level.size());
+        fwrite(level.data(), 1, level.size(), out); // 块大小是8的倍数，不需要补齐
+    }
+    bool ok = ferror(out) == 0;
+    ok = fclose(out) == 0 && ok;
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int threadCount = (int)std::thread::hardware_concurrency();
+    bool mips = true;
+    const char *input = nullptr, *output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threadCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--no-mips") == 0) {
+            mips = false;
+        } else if (input == nullptr) {
+            input = argv[i];
+        } else {
+            output = argv[i];
+        }
+    }
+    if (input == nullptr || output == nullptr) {
+        fprintf(stderr, "usage: %s [-j threads] [--no-mips] input.png output.ktx\n", argv[0]);
+        return 1;
+    }
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+
+    uint32_t w = 0, h = 0;
+    void *image = loadPng(input, &w, &h);
+    if (image == nullptr) {
+        return 1;
+    }
+    bool hasAlpha = false;
+    for (size_t i = 0; i < (size_t)w * h; i++) {
+        if (((uint8_t *)image)[i * 4 + 3] != 255) {
+            hasAlpha = true;
+            break;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int levelCount = mips ? MipmapGenerator::build(&image, w, h) : 1;
+    std::vector<std::vector<uint8_t>> levels(levelCount);
+    for (int level = 0; level < levelCount; level++) {
+        encodeLevel((uint8_t *)image + MipmapGenerator::levelOffset(w, h, level),
+                    MipmapGenerator::levelSize(w, level), MipmapGenerator::levelSize(h, level),
+                    hasAlpha, threadCount, levels[level]);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double quality = psnr((uint8_t *)image, w, h, hasAlpha, levels[0]);
+    size_t compressedBytes = 0;
+    for (const std::vector<uint8_t> &level: levels) {
+        compressedBytes += level.size();
+    }
+    size_t rgbaBytes = mips ? MipmapGenerator::chainBytes(w, h) : (size_t)w * h * 4;
+    printf("%s: %ux%u %s, %d levels, %.2fMB (RGBA8 %.2fMB, %.1fx), PSNR %.2fdB, %.2fs on %d threads\n",
+           input, w, h, hasAlpha ? "RGBA8_ETC2_EAC" : "RGB8_ETC2", levelCount,
+           compressedBytes / 1048576.0, rgbaBytes / 1048576.0, (double)rgbaBytes / compressedBytes,
+           quality, seconds, threadCount);
+
+    bool ok = writeKtx(output, w, h, hasAlpha, levels);
+    free(image);
+    return ok ? 0 : 1;
+}